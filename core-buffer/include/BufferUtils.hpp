@@ -3,10 +3,82 @@
 
 #include <string>
 #include <vector>
+#include "buffer_config.hpp"
 
 namespace BufferUtils
 {
 
+    enum class UdpRecvBackend {
+        // Plain recvmmsg on a UDP socket.
+        RECVMMSG,
+        // AF_PACKET TPACKET_V3 memory mapped ring.
+        PACKET_MMAP
+    };
+
+    enum class RamBufferPages {
+        // Regular 4 KB pages of a POSIX shared memory object.
+        SMALL,
+        // POSIX shared memory with MADV_HUGEPAGE (shmem THP).
+        TRANSPARENT_HUGE,
+        // File on a hugetlbfs mount, page size of the mount (2 MB/1 GB).
+        HUGETLBFS
+    };
+
+    struct RamBufferOptions {
+        // Used by the process that creates the buffer, the others adopt
+        // the number of slots of the existing buffer.
+        int n_slots = buffer_config::RAM_BUFFER_N_SLOTS;
+        RamBufferPages pages = RamBufferPages::SMALL;
+        std::string hugetlbfs_dir = "/dev/hugepages";
+        // Fault in all pages when mapping (MAP_POPULATE).
+        bool populate = false;
+        // Lock the mapping in RAM (mlock).
+        bool lock = false;
+        // NUMA node of each module frame region (mbind), empty for first
+        // touch placement.
+        std::vector<int> numa_nodes;
+    };
+
+    enum class EventTransport {
+        // ZMQ PUB/SUB over ipc sockets.
+        ZMQ,
+        // Shared memory EventRing.
+        SHM
+    };
+
+    struct SpillBufferOptions {
+        // Ring file on local disk, empty when there is no spill buffer.
+        std::string filename;
+        int n_slots = buffer_config::SPILL_BUFFER_N_SLOTS;
+    };
+
+    enum class DoublePixels {
+        // Pixels as they are, gap pixels 0.
+        KEEP,
+        // Double pixels at the inner chip borders (and gap pixels) 0.
+        MASK,
+        // Gap pixels take the value of their double pixel.
+        DUPLICATE
+    };
+
+    struct ModuleGeometry {
+        // Image position of the top left corner of the rotated module.
+        int x = 0;
+        int y = 0;
+        // Clockwise quarter turns, 0 to 3.
+        int rotation = 0;
+    };
+
+    struct DetectorGeometry {
+        // One per module, empty for modules stacked as in the RamBuffer.
+        std::vector<ModuleGeometry> modules;
+        // 0 for the bounding box of the modules.
+        int image_x_size = 0;
+        int image_y_size = 0;
+        bool gap_pixels = false;
+        DoublePixels double_pixels = DoublePixels::KEEP;
+    };
+
     struct DetectorConfig {
         const std::string streamvis_address;
         const int reduction_factor_streamvis;
@@ -19,6 +91,40 @@ namespace BufferUtils
         const int n_modules;
         const int start_udp_port;
         const std::string buffer_folder;
+
+        // Optional, default RECVMMSG on all interfaces.
+        const UdpRecvBackend udp_recv_backend;
+        const std::string udp_recv_interface;
+        // Optional, one core per receiver thread, in the thread order of
+        // the receiver.
+        const std::vector<int> udp_recv_cores;
+        // Optional, core of each single module receiver process, indexed
+        // by module_id.
+        const std::vector<int> udp_recv_module_cores;
+        // Optional low latency receive, all disabled with 0/false.
+        const int udp_recv_busy_poll_us;
+        const int udp_recv_rt_priority;
+        const bool udp_recv_mlockall;
+        // Optional, number of frames open for late packets, default 1.
+        const int udp_recv_reorder_window;
+        // Optional, JFJ sockets each receiving a block of modules, default
+        // 1. On consecutive ports, or all on start_udp_port with reuseport.
+        const int udp_recv_n_streams;
+        const bool udp_recv_reuseport;
+        // Optional, record per pulse stage timestamps, default false.
+        const bool latency_trace;
+        // Optional RamBuffer mapping, default 4 KB pages on demand.
+        const RamBufferOptions ram_buffer;
+        // Optional layout of assembled images, default stacked modules.
+        const DetectorGeometry geometry;
+        // Optional local disk history behind the RamBuffer.
+        const SpillBufferOptions spill_buffer;
+        // Optional transport of the pulse_id/ImageMetadata notifications
+        // between the processes on this host, default ZMQ.
+        const EventTransport event_transport;
+        // Optional, ms to wait for all modules of a pulse before the image
+        // is assembled without the missing ones, default 50.
+        const int assembler_deadline_ms;
     };
 
 
@@ -50,6 +156,15 @@ namespace BufferUtils
             const std::string& stream_name);
 
     DetectorConfig read_json_config(const std::string& filename);
+
+    void pin_thread_to_core(const int core_id);
+
+    // Run the calling thread on the cores of a NUMA node.
+    void pin_thread_to_numa_node(const int numa_node);
+
+    void set_thread_rt_priority(const int priority);
+
+    void lock_process_memory();
 }
 
 #endif //BUFFER_UTILS_HPP
@@ -0,0 +1,105 @@
+#ifndef SF_DAQ_BUFFER_EVENTRING_HPP
+#define SF_DAQ_BUFFER_EVENTRING_HPP
+
+#include <atomic>
+#include <string>
+#include "buffer_config.hpp"
+
+// Read position of one consumer, visible to all processes of the ring.
+// The consumer holds a file lock on the first byte of its entry.
+struct alignas(64) EventRingConsumer {
+    // Index of the next event to read.
+    std::atomic<uint64_t> cursor;
+    std::atomic<uint64_t> n_dropped;
+};
+
+struct EventRingHeader {
+    // EVENT_RING_MAGIC, stored last when the header is complete.
+    std::atomic<uint64_t> magic;
+    uint32_t version;
+    uint32_t event_bytes;
+    uint32_t n_slots;
+    uint32_t slot_bytes;
+
+    // Number of events sent.
+    alignas(64) std::atomic<uint64_t> write_index;
+    // Incremented with each event, consumers wait on it.
+    alignas(64) std::atomic<uint32_t> futex_word;
+    std::atomic<uint32_t> n_waiters;
+
+    EventRingConsumer consumers[buffer_config::EVENT_RING_MAX_CONSUMERS];
+};
+
+/** Shared memory broadcast ring of fixed size events
+
+    One producer process sends events (pulse_ids, ImageMetadata) to any
+    number of consumer processes on the same host. The producer never
+    waits: consumers that fall more than n_slots events behind lose the
+    oldest ones, and count them as dropped. Each event slot has a sequence
+    number, odd while the slot is written, so consumers detect events
+    overwritten during the copy.
+
+    Consumers spin briefly on the write index, then sleep on a futex in
+    the shared memory that the producer wakes when someone waits. Each
+    consumer publishes its cursor and drops in the header, for lag
+    monitoring. The first process of the ring creates it, producer or
+    consumer.
+
+    Consumer entries are owned through open file description locks on
+    the shared memory, released by the kernel when the consumer exits,
+    so entries of dead consumers are reused also across PID namespaces. **/
+class EventRing {
+    const std::string shm_name_;
+    const size_t event_bytes_;
+    const size_t slot_bytes_;
+    const int n_slots_;
+    const bool is_producer_;
+
+    int shm_fd_;
+    size_t buffer_bytes_;
+    void* buffer_;
+    EventRingHeader* header_;
+    char* slots_;
+
+    // Consumer entry and position of this process.
+    EventRingConsumer* consumer_ = nullptr;
+    uint64_t cursor_ = 0;
+    uint64_t n_dropped_ = 0;
+
+    void init_header();
+    void attach_header();
+    void register_consumer();
+    bool lock_consumer(const EventRingConsumer& consumer, const short type);
+    bool is_consumer_alive(const EventRingConsumer& consumer) const;
+    char* get_slot(const uint64_t index) const;
+    std::atomic<uint64_t>& get_slot_seq(const uint64_t index) const;
+    void drop(const uint64_t n_events);
+    bool wait(const uint64_t write_index, const int timeout_ms);
+
+public:
+    EventRing(const std::string& detector_name,
+              const std::string& stream_name,
+              const size_t event_bytes,
+              const bool is_producer,
+              const int n_slots=buffer_config::EVENT_RING_N_SLOTS);
+    virtual ~EventRing();
+
+    static void remove(const std::string& detector_name,
+                       const std::string& stream_name);
+
+    void send(const void* event);
+    // Next event, false if none arrived within timeout_ms (-1 waits
+    // forever). Consumers only receive events sent after they attached.
+    bool recv(void* event, const int timeout_ms=-1);
+
+    // Events this consumer lost because the producer overwrote them.
+    uint64_t get_n_dropped() const;
+    // Events sent but not read yet by this consumer.
+    uint64_t get_lag() const;
+    // Largest lag of all consumers of the ring.
+    uint64_t get_max_lag() const;
+    int get_n_consumers() const;
+};
+
+
+#endif //SF_DAQ_BUFFER_EVENTRING_HPP
@@ -0,0 +1,54 @@
+#ifndef SF_DAQ_BUFFER_EVENTSTREAM_HPP
+#define SF_DAQ_BUFFER_EVENTSTREAM_HPP
+
+#include <memory>
+#include <string>
+#include "BufferUtils.hpp"
+#include "EventRing.hpp"
+
+/** Notifications between the processes of a detector
+
+    Fixed size events (pulse_id, ImageMetadata) on a named stream, sent
+    either over a ZMQ PUB/SUB ipc socket (bind_socket/connect_socket) or
+    over a shared memory EventRing. Both ends of a stream must use the
+    same transport. **/
+class EventSender {
+    const size_t event_bytes_;
+    void* socket_ = nullptr;
+    std::unique_ptr<EventRing> ring_;
+
+public:
+    EventSender(void* ctx,
+                const std::string& detector_name,
+                const std::string& stream_name,
+                const size_t event_bytes,
+                const BufferUtils::EventTransport transport);
+    virtual ~EventSender();
+
+    void send(const void* event);
+    // Largest number of events not read yet by a consumer, 0 with ZMQ.
+    uint64_t get_max_lag() const;
+};
+
+class EventReceiver {
+    const size_t event_bytes_;
+    void* socket_ = nullptr;
+    std::unique_ptr<EventRing> ring_;
+
+public:
+    EventReceiver(void* ctx,
+                  const std::string& detector_name,
+                  const std::string& stream_name,
+                  const size_t event_bytes,
+                  const BufferUtils::EventTransport transport);
+    virtual ~EventReceiver();
+
+    // Next event, false if none arrived within timeout_ms (-1 waits
+    // forever).
+    bool recv(void* event, const int timeout_ms=-1);
+    // Events lost because the receiver was too slow, 0 with ZMQ.
+    uint64_t get_n_dropped() const;
+};
+
+
+#endif //SF_DAQ_BUFFER_EVENTSTREAM_HPP
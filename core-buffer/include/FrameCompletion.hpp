@@ -0,0 +1,77 @@
+#ifndef SF_DAQ_BUFFER_FRAMECOMPLETION_HPP
+#define SF_DAQ_BUFFER_FRAMECOMPLETION_HPP
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "formats.hpp"
+#include "buffer_config.hpp"
+
+/** Completion of frames assembled in parts
+
+    Several threads assemble disjoint parts of the same frame (for example
+    blocks of modules) directly into its RamBuffer slot. Each thread adds
+    the metadata and the received packets bitmap of its closed parts here;
+    one atomic counter per slot, tagged with the frame_index, counts the
+    parts. The thread that adds the last part of a frame gets the merged
+    frame metadata and bitmap, and publishes it.
+
+    Every part thread must add one part per frame_index: frames it did not
+    receive any packet of are added with add_empty_part, so frames with a
+    lost part still complete. A part thread that gets no packets at all
+    adds empty parts up to get_newest_frame_index after a deadline. Parts
+    of a frame older than the one in its slot are dropped before anything
+    of them is written. **/
+class FrameCompletion {
+    const int n_parts_;
+    const int n_slots_;
+    // Part i has the packets [part_packets_[i], part_packets_[i+1]).
+    const std::vector<uint32_t> part_packets_;
+    const size_t n_bitmap_words_;
+
+    // Slot state: frame_index << PART_BITS | n_added_parts.
+    static constexpr int PART_BITS = 8;
+    std::unique_ptr<std::atomic<uint64_t>[]> slot_state_;
+    std::atomic<uint64_t> newest_frame_index_{0};
+    // Part metadata, n_parts_ per slot.
+    std::unique_ptr<ModuleFrame[]> parts_;
+    // Frame bitmap per slot, each part writes only its own words.
+    std::unique_ptr<uint64_t[]> bitmaps_;
+
+    uint64_t* get_part_words(const uint64_t frame_index, const int i_part);
+    bool claim_slot(const uint64_t frame_index);
+    bool count_part(const uint64_t frame_index,
+                    ModuleFrame& frame,
+                    uint64_t* frame_bitmap);
+
+public:
+    // part_packets holds the first packet of each part and the number of
+    // frame packets at the end. Part boundaries must be multiples of 64.
+    FrameCompletion(const std::vector<uint32_t>& part_packets,
+                    const int n_slots=buffer_config::RAM_BUFFER_N_SLOTS);
+
+    // Add the closed part i_part with its received packets (frame wide
+    // bitmap, only the part packets are read). Returns true if it was the
+    // last part of a frame with received packets, and writes the merged
+    // metadata and bitmap to frame and frame_bitmap.
+    bool add_part(const int i_part,
+                  const ModuleFrame& part,
+                  const uint64_t* part_bitmap,
+                  ModuleFrame& frame,
+                  uint64_t* frame_bitmap);
+
+    // Add a part without packets for frame_index, same return as add_part.
+    bool add_empty_part(const int i_part,
+                        const uint64_t frame_index,
+                        ModuleFrame& frame,
+                        uint64_t* frame_bitmap);
+
+    // Frame_index of the frame that most recently got its first part.
+    uint64_t get_newest_frame_index() const;
+
+    int get_n_parts() const;
+    int get_n_slots() const;
+};
+
+
+#endif //SF_DAQ_BUFFER_FRAMECOMPLETION_HPP
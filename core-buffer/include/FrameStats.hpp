@@ -1,6 +1,7 @@
 #include <cstddef>
 #include <formats.hpp>
 #include <chrono>
+#include "EventStream.hpp"
 
 #ifndef SF_DAQ_BUFFER_FRAMESTATS_HPP
 #define SF_DAQ_BUFFER_FRAMESTATS_HPP
@@ -9,7 +10,9 @@
 class FrameStats {
     const std::string detector_name_;
     const int module_id_;
+    const uint64_t n_packets_per_frame_;
     size_t stats_time_;
+    const EventSender& sender_;
 
     int frames_counter_;
     int n_missed_packets_;
@@ -23,7 +26,9 @@ class FrameStats {
 public:
     FrameStats(const std::string &detector_name,
                const int module_id,
-               const size_t stats_time);
+               const uint64_t n_packets_per_frame,
+               const size_t stats_time,
+               const EventSender& sender);
     void record_stats(const ModuleFrame &meta, const bool bad_pulse_id);
 };
 
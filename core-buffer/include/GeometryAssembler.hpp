@@ -0,0 +1,78 @@
+#ifndef SF_DAQ_BUFFER_GEOMETRYASSEMBLER_HPP
+#define SF_DAQ_BUFFER_GEOMETRYASSEMBLER_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "BufferUtils.hpp"
+
+/** Assembly of RamBuffer images into the detector geometry
+
+    The modules of a RamBuffer image are stacked (n_modules*512 x 1024). The
+    assembler places each module at its position and rotation in the final
+    image, optionally with the gap pixels between the chips and with one of
+    the double pixel treatments. Modules are split among n_threads threads,
+    the calling thread included. **/
+class GeometryAssembler {
+    // Image index of the module pixel at local (0, 0) and the index steps
+    // for one pixel along the local x and y axes of the rotated module.
+    struct ModulePlacement {
+        int64_t origin;
+        int64_t step_x;
+        int64_t step_y;
+    };
+
+    const int n_modules_;
+    const int n_threads_;
+    const int gap_;
+    const BufferUtils::DoublePixels double_pixels_;
+    // Module size with the gap pixels, before rotation.
+    const int module_x_size_;
+    const int module_y_size_;
+    int image_x_size_;
+    int image_y_size_;
+    // The modules do not cover all image pixels, clear it first.
+    bool is_clear_needed_ = false;
+    std::vector<ModulePlacement> placements_;
+
+    // Helper threads, each assembles every n_threads-th module.
+    std::vector<std::thread> workers_;
+    std::mutex job_mutex_;
+    std::condition_variable job_cv_;
+    std::condition_variable done_cv_;
+    const char* job_data_ = nullptr;
+    uint16_t* job_image_ = nullptr;
+    uint64_t job_id_ = 0;
+    size_t n_done_workers_ = 0;
+    bool is_stopping_ = false;
+
+    void run_worker(const int i_thread);
+    void assemble_modules(const int i_thread,
+                          const char* data,
+                          uint16_t* image) const;
+    void assemble_module(const int i_module,
+                         const char* data,
+                         uint16_t* image) const;
+    void fill_gap_pixels(const ModulePlacement& placement,
+                         uint16_t* image) const;
+    void mask_double_pixels(const ModulePlacement& placement,
+                            uint16_t* image) const;
+
+public:
+    GeometryAssembler(const BufferUtils::DetectorGeometry& geometry,
+                   const int n_modules,
+                   const int n_threads=1);
+    ~GeometryAssembler();
+
+    int get_image_x_size() const;
+    int get_image_y_size() const;
+    size_t get_image_n_pixels() const;
+
+    // data: RamBuffer image, image: get_image_n_pixels() pixels.
+    void assemble(const char* data, uint16_t* image);
+};
+
+
+#endif //SF_DAQ_BUFFER_GEOMETRYASSEMBLER_HPP
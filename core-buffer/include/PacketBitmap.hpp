@@ -0,0 +1,70 @@
+#ifndef SF_DAQ_BUFFER_PACKETBITMAP_HPP
+#define SF_DAQ_BUFFER_PACKETBITMAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/** Received packets bitmap
+
+    Bit i is set when packet i of the frame was received. Used to zero only
+    the data of missing packets instead of the whole frame buffer. **/
+namespace PacketBitmap
+{
+    constexpr size_t n_words(const size_t n_packets)
+    {
+        return (n_packets + 63) / 64;
+    }
+
+    inline void clear(uint64_t* bitmap, const size_t n_packets)
+    {
+        memset(bitmap, 0, n_words(n_packets) * sizeof(uint64_t));
+    }
+
+    inline void set(uint64_t* bitmap, const size_t i_packet)
+    {
+        bitmap[i_packet / 64] |= (uint64_t(1) << (i_packet % 64));
+    }
+
+    inline bool is_set(const uint64_t* bitmap, const size_t i_packet)
+    {
+        return (bitmap[i_packet / 64] >> (i_packet % 64)) & 1;
+    }
+
+    // Zero the data of all missing packets, one memset per missing range.
+    inline void zero_missing(
+            const uint64_t* bitmap,
+            const size_t n_packets,
+            char* frame_buffer,
+            const size_t packet_n_bytes)
+    {
+        size_t i_packet = 0;
+
+        while (i_packet < n_packets) {
+            // Skip words with all packets received.
+            if (i_packet % 64 == 0 && i_packet + 64 <= n_packets &&
+                bitmap[i_packet / 64] == ~uint64_t(0)) {
+                i_packet += 64;
+                continue;
+            }
+
+            if (is_set(bitmap, i_packet)) {
+                i_packet++;
+                continue;
+            }
+
+            size_t range_end = i_packet + 1;
+            while (range_end < n_packets && !is_set(bitmap, range_end)) {
+                range_end++;
+            }
+
+            memset(frame_buffer + (packet_n_bytes * i_packet),
+                   0,
+                   packet_n_bytes * (range_end - i_packet));
+
+            i_packet = range_end;
+        }
+    }
+}
+
+#endif //SF_DAQ_BUFFER_PACKETBITMAP_HPP
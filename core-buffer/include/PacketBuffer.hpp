@@ -0,0 +1,105 @@
+#ifndef CIRCULAR_BUFFER_TEMPLATE_HPP
+#define CIRCULAR_BUFFER_TEMPLATE_HPP
+
+#include <cstddef>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include "SpscRing.hpp"
+
+
+/** Contiguous run of packets in a PacketBuffer **/
+template <typename T>
+struct PacketSpan {
+    T* data;
+    int size;
+
+    T* begin() const { return data; }
+    T* end() const { return data + size; }
+    bool empty() const { return size <= 0; }
+};
+
+
+/** Linear packet batch (NOT FIFO)
+
+    A batch of packets received with a single recvmmsg call. It bundles the
+    packet container with the metadata required by <sockets.h>, and hands out
+    the unread packets as one contiguous span.
+
+    A batch is owned by a single thread: there are no locks and no exceptions,
+    the caller checks is_empty/is_full. To hand batches over between a
+    receiving and a processing thread use PacketBufferRing. **/
+template <typename T, size_t CAPACITY>
+class PacketBuffer{
+public:
+    PacketBuffer() {
+        for (size_t i = 0; i < CAPACITY; i++) {
+            m_recv_buff_ptr[i].iov_base = (void*) &(m_container[i]);
+            m_recv_buff_ptr[i].iov_len = sizeof(T);
+
+            // C-structure as expected by <sockets.h>
+            m_msgs[i].msg_hdr.msg_iov = &m_recv_buff_ptr[i];
+            m_msgs[i].msg_hdr.msg_iovlen = 1;
+            m_msgs[i].msg_hdr.msg_name = &m_sock_from[i];
+            m_msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+            m_msgs[i].msg_hdr.msg_control = nullptr;
+            m_msgs[i].msg_hdr.msg_controllen = 0;
+        }
+    };
+
+    /**Diagnostics**/
+    int size() const { return ( idx_write-idx_read ); }
+    static constexpr size_t capacity() { return CAPACITY; }
+    bool is_full() const { return idx_write >= (int) CAPACITY; }
+    bool is_empty() const { return idx_write <= idx_read; }
+
+    /**Operators**/
+    void reset(){ idx_write = 0; idx_read = 0; };       // Reset the buffer
+    T* container(){ return m_container; };              // Direct container access
+    mmsghdr* msgs(){ return m_msgs; };
+
+    /**Batch access**/
+    PacketSpan<T> span(){ return {m_container + idx_read, size()}; };
+    void consume(const int n_packets){ idx_read += n_packets; };
+
+    /**Element access, unchecked**/
+    T& pop_front(){ return m_container[idx_read++]; };          // Destructive read
+    const T& peek_front() const { return m_container[idx_read]; }; // Non-destructive read
+    bool push_back(const T& item){                              // False if full
+        if (is_full()) { return false; }
+        m_container[idx_write++] = item;
+        return true;
+    };
+
+    /**Fill from UDP receiver**/
+    // Replaces the content with a new batch, returns the number of packets.
+    template <typename TY>
+    int fill_from(TY& recv, const int flags=0){
+        idx_write = recv.receive_many(m_msgs, CAPACITY, flags);
+        // Returns -1 if no data received
+        if (idx_write < 0) { idx_write = 0; }
+        idx_read = 0;
+        return idx_write;
+    }
+
+private:
+    // Main container
+    T m_container[CAPACITY];
+    /**Read and write index**/
+    int idx_write = 0;
+    int idx_read = 0;
+
+    // C-structures as expected by <sockets.h>
+    mmsghdr m_msgs[CAPACITY];
+    iovec m_recv_buff_ptr[CAPACITY];
+    sockaddr_in m_sock_from[CAPACITY];
+};
+
+
+/** Cross-thread handoff of packet batches
+
+    Pre-allocated PacketBuffers passed from one receiving to one processing
+    thread without locks (see SpscRing). **/
+template <typename T, size_t CAPACITY, size_t N_BATCHES>
+using PacketBufferRing = SpscRing<PacketBuffer<T, CAPACITY>, N_BATCHES>;
+
+#endif // CIRCULAR_BUFFER_TEMPLATE_HPP
@@ -0,0 +1,449 @@
+#ifndef SF_DAQ_BUFFER_PACKETFRAMEENGINE_HPP
+#define SF_DAQ_BUFFER_PACKETFRAMEENGINE_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include "PacketUdpReceiver.hpp"
+#include "PacketBuffer.hpp"
+#include "PacketBitmap.hpp"
+#include "formats.hpp"
+#include "buffer_config.hpp"
+#include "jungfrau.hpp"
+#include "jungfraujoch.hpp"
+
+/** Packet to frame engine
+
+    Assembles the frames of one UDP stream from batches of received packets.
+    The detector variant is fixed at compile time: packet_t is the packet
+    struct (framenum, packetnum, bunchid, debug and data fields), N_PACKETS
+    the number of packets per frame and DATA_BYTES the data bytes of each
+    packet. Packet copies and frame bitmap loops have constant sizes.
+
+    The data of each frame goes to the buffer returned by the get_frame_buffer
+    callback of the caller when the frame gets its first packet. Packets are
+    taken either as packet_t structs, or as headers with the address their
+    data was received at (zero-copy): data already in place is not copied.
+
+    Up to reorder_window consecutive frames are open at the same time, and
+    they are closed in frame_index order: the oldest one when it is complete,
+    or when a packet of a frame reorder_window frames newer arrives. With a
+    reorder_window of 1 the last packet of a frame also closes it. Only the
+    data of missing packets is zeroed. Late packets of closed frames are
+    dropped, unless the frame_index went back by more than
+    BUFFER_UDP_FRAME_RESET_LIMIT: then the detector counter was reset and
+    the open frames are closed before starting over.
+
+    An engine can be limited to the packets [packet_begin, packet_end) of
+    the frame, so that several engines assemble parts of the same frame
+    buffer. Its frames are then complete with packet_end-packet_begin
+    packets, their last packet is packet_end-1 and packets outside of the
+    range are dropped. **/
+template <typename packet_t, size_t N_PACKETS, size_t DATA_BYTES>
+class PacketFrameEngine {
+public:
+    static constexpr size_t FRAME_N_BYTES = N_PACKETS * DATA_BYTES;
+    static constexpr size_t BITMAP_N_WORDS = PacketBitmap::n_words(N_PACKETS);
+
+    static_assert(sizeof(packet_t::data) == DATA_BYTES,
+                  "DATA_BYTES must match the packet data field.");
+
+    struct Frame {
+        ModuleFrame meta;
+        // From get_frame_buffer, FRAME_N_BYTES.
+        char* buffer;
+        // Received packets, N_PACKETS bits.
+        uint64_t bitmap[BITMAP_N_WORDS];
+        // One past the highest received packetnum.
+        uint32_t next_packetnum;
+        // Receive time of the first packet of the frame.
+        uint64_t recv_ns;
+    };
+
+private:
+    const int module_id_;
+    const uint32_t packet_begin_;
+    const uint32_t packet_end_;
+    const int reorder_window_;
+
+    // Batch for get_frame, leftover packets start the next frame.
+    PacketBuffer<packet_t, buffer_config::BUFFER_UDP_N_RECV_MSG> packets_;
+
+    // Oldest first.
+    Frame open_frames_[buffer_config::BUFFER_UDP_MAX_REORDER_WINDOW];
+    int n_open_frames_ = 0;
+    Frame last_frame_;
+    uint64_t last_frame_index_ = 0;
+
+    inline bool is_complete(const Frame& frame) const
+    {
+        return frame.meta.n_recv_packets == packet_end_ - packet_begin_;
+    }
+
+    inline bool is_in_range(const uint32_t packetnum) const
+    {
+        return packetnum >= packet_begin_ && packetnum < packet_end_;
+    }
+
+    template <typename header_t, typename get_buffer_t>
+    inline Frame& get_open_frame(const header_t& header,
+                                 get_buffer_t& get_frame_buffer)
+    {
+        int i_frame = 0;
+
+        for (; i_frame < n_open_frames_; i_frame++) {
+            const auto frame_index = open_frames_[i_frame].meta.frame_index;
+
+            if (frame_index == header.framenum) {
+                return open_frames_[i_frame];
+            }
+
+            if (frame_index > header.framenum) {
+                break;
+            }
+        }
+
+        for (int i = n_open_frames_; i > i_frame; i--) {
+            open_frames_[i] = open_frames_[i-1];
+        }
+        n_open_frames_++;
+
+        auto& frame = open_frames_[i_frame];
+
+        frame.meta.pulse_id = (uint64_t) header.bunchid;
+        frame.meta.frame_index = header.framenum;
+        frame.meta.daq_rec = (uint64_t) header.debug;
+        frame.meta.n_recv_packets = 0;
+        frame.meta.module_id = (int64_t) module_id_;
+        // Instead of zeroing the whole frame buffer only missing packets
+        // are zeroed when the frame closes.
+        PacketBitmap::clear(frame.bitmap, N_PACKETS);
+        frame.next_packetnum = packet_begin_;
+        frame.recv_ns = 0;
+        frame.buffer = get_frame_buffer(frame.meta);
+
+        return frame;
+    }
+
+    inline void add_packet(Frame& frame,
+                           const uint32_t packetnum,
+                           const char* data,
+                           const uint64_t recv_ns)
+    {
+        char* frame_data = frame.buffer + (DATA_BYTES * packetnum);
+
+        if (frame.meta.n_recv_packets == 0) {
+            frame.recv_ns = recv_ns;
+        }
+
+        if (data != frame_data) {
+            memcpy(frame_data, data, DATA_BYTES);
+        }
+
+        if (!PacketBitmap::is_set(frame.bitmap, packetnum)) {
+            PacketBitmap::set(frame.bitmap, packetnum);
+            frame.meta.n_recv_packets++;
+        }
+
+        if (frame.next_packetnum <= packetnum) {
+            frame.next_packetnum = packetnum + 1;
+        }
+    }
+
+    inline bool is_window_passed(const uint64_t framenum) const
+    {
+        // The oldest frame fell out of the window.
+        if (framenum >= open_frames_[0].meta.frame_index + reorder_window_) {
+            return true;
+        }
+
+        // Window full, make room for a newer frame.
+        return n_open_frames_ == reorder_window_ &&
+               framenum > open_frames_[n_open_frames_ - 1].meta.frame_index;
+    }
+
+    // Packets of the oldest frame among [i_packet, n_packets) are taken
+    // before it is closed, and marked out of range to be skipped afterwards.
+    template <typename header_at_t, typename data_at_t>
+    inline void pull_oldest_frame(header_at_t& header_at,
+                                  data_at_t& data_at,
+                                  const uint64_t* recv_ns,
+                                  const int n_packets,
+                                  const int i_packet)
+    {
+        auto& frame = open_frames_[0];
+
+        for (int i = i_packet; i < n_packets && !is_complete(frame); i++) {
+            auto& header = header_at(i);
+
+            if (is_in_range(header.packetnum) &&
+                header.framenum == frame.meta.frame_index) {
+
+                add_packet(frame, header.packetnum, data_at(i),
+                           (recv_ns != nullptr) ? recv_ns[i] : 0);
+                header.packetnum = packet_end_;
+            }
+        }
+    }
+
+    inline uint64_t close_oldest_frame(ModuleFrame& metadata)
+    {
+        auto& frame = open_frames_[0];
+
+        const size_t n_part_packets = packet_end_ - packet_begin_;
+        if (frame.meta.n_recv_packets < n_part_packets) {
+            PacketBitmap::zero_missing(frame.bitmap + (packet_begin_ / 64),
+                                       n_part_packets,
+                                       frame.buffer + (DATA_BYTES * packet_begin_),
+                                       DATA_BYTES);
+        }
+
+        // Module frame metadata holds the bitmap of the first module.
+        constexpr size_t n_meta_bytes =
+                (sizeof(frame.meta.packets_bitmap) < sizeof(frame.bitmap)) ?
+                sizeof(frame.meta.packets_bitmap) : sizeof(frame.bitmap);
+        memcpy(frame.meta.packets_bitmap,
+               frame.bitmap + (packet_begin_ / 64),
+               n_meta_bytes);
+
+        last_frame_ = frame;
+        metadata = frame.meta;
+
+        for (int i = 1; i < n_open_frames_; i++) {
+            open_frames_[i-1] = open_frames_[i];
+        }
+        n_open_frames_--;
+
+        last_frame_index_ = metadata.frame_index;
+
+        return metadata.pulse_id;
+    }
+
+    template <typename header_at_t, typename data_at_t, typename get_buffer_t>
+    inline uint64_t add_packets_at(header_at_t&& header_at,
+                                   data_at_t&& data_at,
+                                   const uint64_t* recv_ns,
+                                   const int n_packets,
+                                   int& i_packet,
+                                   ModuleFrame& metadata,
+                                   get_buffer_t& get_frame_buffer)
+    {
+        // A newer frame completed before the oldest one was closed.
+        if (n_open_frames_ > 0 && is_complete(open_frames_[0])) {
+            pull_oldest_frame(header_at, data_at, recv_ns, n_packets, i_packet);
+            return close_oldest_frame(metadata);
+        }
+
+        for (; i_packet < n_packets; i_packet++) {
+            const auto& header = header_at(i_packet);
+
+            // Corrupted or not our part - it has no place in the frame.
+            if (!is_in_range(header.packetnum)) {
+                continue;
+            }
+
+            if (header.framenum <= last_frame_index_) {
+                // Late packet for a frame we already closed.
+                if (last_frame_index_ - header.framenum <
+                    buffer_config::BUFFER_UDP_FRAME_RESET_LIMIT) {
+                    continue;
+                }
+
+                // Frame counter was reset - pass on the open frames of the
+                // old counter first, then start over from this packet.
+                if (n_open_frames_ > 0) {
+                    pull_oldest_frame(
+                            header_at, data_at, recv_ns, n_packets, i_packet);
+                    return close_oldest_frame(metadata);
+                }
+
+                last_frame_index_ = 0;
+            }
+
+            // The window moves past the oldest frame - close it and continue
+            // on this packet. Also happens if the last packet of a frame gets
+            // lost.
+            if (n_open_frames_ > 0 && is_window_passed(header.framenum)) {
+                pull_oldest_frame(
+                        header_at, data_at, recv_ns, n_packets, i_packet);
+                return close_oldest_frame(metadata);
+            }
+
+            // Too old to open a frame for it in a full window.
+            if (n_open_frames_ == reorder_window_ &&
+                header.framenum < open_frames_[0].meta.frame_index) {
+                continue;
+            }
+
+            auto& frame = get_open_frame(header, get_frame_buffer);
+            add_packet(frame, header.packetnum, data_at(i_packet),
+                       (recv_ns != nullptr) ? recv_ns[i_packet] : 0);
+
+            // Without reordering the last packet closes the frame.
+            const bool is_last_packet = reorder_window_ == 1 &&
+                                        header.packetnum == packet_end_ - 1;
+
+            // Frames are passed on in order: only the oldest can be closed.
+            if (is_last_packet || is_complete(open_frames_[0])) {
+                i_packet++;
+                pull_oldest_frame(
+                        header_at, data_at, recv_ns, n_packets, i_packet);
+                return close_oldest_frame(metadata);
+            }
+        }
+
+        return 0;
+    }
+
+public:
+    // packet_begin must be a multiple of 64 (bitmap word). reorder_window
+    // must be between 1 and BUFFER_UDP_MAX_REORDER_WINDOW.
+    explicit PacketFrameEngine(const int module_id=0,
+                               const uint32_t packet_begin=0,
+                               const uint32_t packet_end=N_PACKETS,
+                               const int reorder_window=1) :
+            module_id_(module_id),
+            packet_begin_(packet_begin),
+            packet_end_(packet_end),
+            reorder_window_(reorder_window)
+    {
+    }
+
+    // Close the oldest open frame without waiting for more packets. Returns
+    // its pulse_id, 0 if no frame is open.
+    inline uint64_t flush_frame(ModuleFrame& metadata)
+    {
+        if (n_open_frames_ == 0) {
+            return 0;
+        }
+
+        return close_oldest_frame(metadata);
+    }
+
+    // Add packets [i_packet, n_packets) to the open frames. The frame data
+    // goes to get_frame_buffer(const ModuleFrame&), called with the metadata
+    // of each new frame. Returns the pulse_id of a closed frame, with
+    // i_packet on the next packet to process, or 0 when all packets were
+    // added.
+    template <typename get_buffer_t>
+    inline uint64_t add_packets(packet_t* packets,
+                                const int n_packets,
+                                int& i_packet,
+                                ModuleFrame& metadata,
+                                get_buffer_t&& get_frame_buffer)
+    {
+        return add_packets_at(
+                [packets](const int i) -> packet_t& { return packets[i]; },
+                [packets](const int i) -> const char* {
+                    return packets[i].data;
+                },
+                nullptr, n_packets, i_packet, metadata, get_frame_buffer);
+    }
+
+    // Zero-copy add_packets: the data of packet i was received at data[i].
+    // recv_ns holds the receive time of each packet, or is nullptr.
+    template <typename header_t, typename get_buffer_t>
+    inline uint64_t add_packets(header_t* headers,
+                                char* const* data,
+                                const uint64_t* recv_ns,
+                                const int n_packets,
+                                int& i_packet,
+                                ModuleFrame& metadata,
+                                get_buffer_t&& get_frame_buffer)
+    {
+        return add_packets_at(
+                [headers](const int i) -> header_t& { return headers[i]; },
+                [data](const int i) -> const char* { return data[i]; },
+                recv_ns, n_packets, i_packet, metadata, get_frame_buffer);
+    }
+
+    // add_packets over the unread span of a batch, consumes what was added.
+    template <size_t CAPACITY, typename get_buffer_t>
+    inline uint64_t add_packets(PacketBuffer<packet_t, CAPACITY>& batch,
+                                ModuleFrame& metadata,
+                                get_buffer_t&& get_frame_buffer)
+    {
+        const auto span = batch.span();
+
+        int i_packet = 0;
+        auto pulse_id = add_packets(
+                span.data, span.size, i_packet, metadata, get_frame_buffer);
+
+        batch.consume(i_packet);
+
+        return pulse_id;
+    }
+
+    // Receive the next frame into frame_buffer (FRAME_N_BYTES), with a
+    // reorder window of 1. Blocks until a frame is closed and returns its
+    // pulse_id. With timeout_ms >= 0 it returns 0 after timeout_ms without
+    // packets, dropping the open frame.
+    uint64_t get_frame(PacketUdpReceiver& receiver,
+                       ModuleFrame& metadata,
+                       char* frame_buffer,
+                       const int timeout_ms=-1)
+    {
+        auto get_frame_buffer = [frame_buffer](const ModuleFrame&) {
+            return frame_buffer;
+        };
+
+        auto last_packet_time = std::chrono::steady_clock::now();
+
+        while (true) {
+            // Leftover packets of the last batch are processed first.
+            if (packets_.is_empty() && packets_.fill_from(receiver) == 0) {
+                const auto idle_time =
+                        std::chrono::steady_clock::now() - last_packet_time;
+
+                if (timeout_ms >= 0 &&
+                    idle_time > std::chrono::milliseconds(timeout_ms)) {
+                    n_open_frames_ = 0;
+                    return 0;
+                }
+
+                continue;
+            }
+
+            last_packet_time = std::chrono::steady_clock::now();
+
+            auto pulse_id = add_packets(packets_, metadata, get_frame_buffer);
+
+            if (pulse_id != 0) {
+                return pulse_id;
+            }
+        }
+    }
+
+    // Newest open frame, nullptr if there is none.
+    const Frame* get_newest_frame() const
+    {
+        return (n_open_frames_ > 0) ? &open_frames_[n_open_frames_ - 1] : nullptr;
+    }
+
+    // Last closed frame, its bitmap has N_PACKETS bits.
+    const Frame& get_last_frame() const
+    {
+        return last_frame_;
+    }
+
+    const uint64_t* get_frame_bitmap() const
+    {
+        return last_frame_.bitmap;
+    }
+
+    uint64_t get_last_frame_index() const
+    {
+        return last_frame_index_;
+    }
+};
+
+typedef PacketFrameEngine<jungfrau_packet,
+                          JF_N_PACKETS_PER_FRAME,
+                          JUNGFRAU_DATA_BYTES_PER_PACKET> JungfrauFrameEngine;
+
+typedef PacketFrameEngine<jfjoch_packet_t,
+                          JFJOCH_N_PACKETS_PER_FRAME,
+                          JFJOCH_DATA_BYTES_PER_PACKET> JfjochFrameEngine;
+
+
+#endif //SF_DAQ_BUFFER_PACKETFRAMEENGINE_HPP
@@ -0,0 +1,50 @@
+#ifndef SF_DAQ_BUFFER_PACKETMMAPRING_HPP
+#define SF_DAQ_BUFFER_PACKETMMAPRING_HPP
+
+#include <string>
+#include <sys/socket.h>
+#include "buffer_config.hpp"
+
+/** AF_PACKET TPACKET_V3 receive ring
+
+    The kernel writes the UDP packets for one port into a memory mapped ring
+    of blocks. Blocks are polled as a whole, so there are no per packet
+    syscalls. Packets are read in place and scattered into the iovecs of the
+    caller, which lets it be used as a drop-in for recvmmsg.
+
+    Requires CAP_NET_RAW and an MTU large enough to avoid IP fragments. **/
+class PacketMmapRing {
+    const uint16_t port_;
+    const unsigned int n_blocks_;
+    const size_t ring_bytes_;
+
+    int socket_fd_;
+    char* ring_;
+
+    unsigned int i_block_ = 0;
+    char* next_packet_ = nullptr;
+    unsigned int n_block_packets_left_ = 0;
+
+    void attach_port_filter();
+    bool wait_for_block(const int timeout_us);
+    void release_block();
+
+public:
+    PacketMmapRing(const uint16_t port,
+                   const std::string& interface_name,
+                   const unsigned int n_blocks=
+                           buffer_config::BUFFER_PACKET_MMAP_N_BLOCKS);
+    ~PacketMmapRing();
+
+    // Same semantic as recvmmsg with SO_RCVTIMEO: returns the number of
+    // received messages, or -1 if nothing arrived within the timeout.
+    // MSG_DONTWAIT in flags returns immediately. Messages with a msg_control
+    // buffer get the packet timestamp as SCM_TIMESTAMPNS.
+    int receive_many(mmsghdr* msgs, const size_t n_msgs, const int flags=0);
+
+    // For poll/epoll: readable when a block is ready.
+    int get_fd() const;
+};
+
+
+#endif //SF_DAQ_BUFFER_PACKETMMAPRING_HPP
@@ -0,0 +1,50 @@
+#ifndef UDPRECEIVER_H
+#define UDPRECEIVER_H
+
+#include <sys/socket.h>
+#include <memory>
+#include <string>
+#include "BufferUtils.hpp"
+#include "PacketMmapRing.hpp"
+
+class PacketUdpReceiver {
+
+    int socket_fd_;
+    // Set only with the PACKET_MMAP backend.
+    std::unique_ptr<PacketMmapRing> ring_;
+    // Spin on non blocking receives instead of sleeping in the kernel.
+    bool busy_poll_ = false;
+
+    int receive_batch(mmsghdr* msgs, const size_t n_msgs, const int flags);
+    void set_busy_poll(const int busy_poll_us);
+
+public:
+    PacketUdpReceiver();
+    virtual ~PacketUdpReceiver();
+
+    bool receive(void* buffer, const size_t buffer_n_bytes);
+    int receive_many(mmsghdr* msgs, const size_t n_msgs, const int flags=0);
+
+    // With PACKET_MMAP the UDP socket only reserves the port, packets are
+    // read from the ring on the given interface (empty for all).
+    // busy_poll_us > 0 enables SO_BUSY_POLL and a spinning receive.
+    // With reuseport the socket joins the SO_REUSEPORT group of the port
+    // (RECVMMSG backend only).
+    void bind(const uint16_t port,
+              const BufferUtils::UdpRecvBackend backend=
+                      BufferUtils::UdpRecvBackend::RECVMMSG,
+              const std::string& interface_name="",
+              const int busy_poll_us=0,
+              const bool reuseport=false);
+    void disconnect();
+
+    // Kernel receive time of each packet as SCM_TIMESTAMPNS control message,
+    // for messages that provide a msg_control buffer.
+    void enable_timestamps();
+
+    // Descriptor to wait on with poll/epoll.
+    int get_fd() const;
+};
+
+
+#endif //LIB_CPP_H5_WRITER_UDPRECEIVER_H
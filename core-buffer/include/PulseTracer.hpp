@@ -0,0 +1,58 @@
+#ifndef SF_DAQ_BUFFER_PULSETRACER_HPP
+#define SF_DAQ_BUFFER_PULSETRACER_HPP
+
+#include <string>
+#include "formats.hpp"
+
+enum class TraceStage {
+    MODULE_RECV,
+    MODULE_COMMIT,
+    ASSEMBLER_EMIT,
+    STREAM_SEND,
+    WRITER_WRITE
+};
+
+/** Per pulse latency trace
+
+    One PulseTrace per RamBuffer slot in a separate shared memory region
+    (detector_name + PULSE_TRACE_SHM_SUFFIX). Each stage writes only its
+    own trace points, so processes do not need to synchronize. When
+    disabled nothing is mapped and record is a no-op. **/
+class PulseTracer {
+    const std::string shm_name_;
+    const int n_slots_;
+    const size_t buffer_bytes_;
+
+    int shm_fd_ = -1;
+    PulseTrace* trace_buffer_ = nullptr;
+
+public:
+    // n_slots must match the RamBuffer of the detector.
+    PulseTracer(const std::string& detector_name,
+                const bool enabled,
+                const int n_slots);
+    // Only unmaps, the trace stays for the other processes.
+    ~PulseTracer();
+
+    // Delete the trace of detector_name, processes that have it mapped
+    // keep their mapping.
+    static void remove(const std::string& detector_name);
+
+    bool is_enabled() const;
+
+    // module_id is used only by the module stages.
+    void record(const TraceStage stage,
+                const uint64_t pulse_id,
+                const uint64_t time_ns,
+                const int module_id=0) const;
+    void record_now(const TraceStage stage,
+                    const uint64_t pulse_id,
+                    const int module_id=0) const;
+
+    const PulseTrace& get_trace(const uint64_t pulse_id) const;
+
+    static uint64_t now_ns();
+};
+
+
+#endif //SF_DAQ_BUFFER_PULSETRACER_HPP
@@ -1,38 +1,180 @@
 #ifndef SF_DAQ_BUFFER_RAMBUFFER_HPP
 #define SF_DAQ_BUFFER_RAMBUFFER_HPP
 
+#include <atomic>
 #include <string>
+#include <vector>
 #include "formats.hpp"
+#include "BufferUtils.hpp"
+
+// Start of the RamBuffer shared memory, written once by the process that
+// creates the buffer. The processes attaching to it adopt its layout.
+struct RamBufferHeader {
+    // RAM_BUFFER_MAGIC, stored last when the header is complete.
+    std::atomic<uint64_t> magic;
+    uint32_t version;
+    uint32_t n_modules;
+    uint32_t n_slots;
+    uint32_t bits_per_pixel;
+    uint64_t frame_meta_bytes;
+    uint64_t frame_data_bytes;
+    // Offsets of the regions from the start of the buffer.
+    uint64_t meta_offset;
+    uint64_t module_meta_offset;
+    uint64_t image_offset;
+    uint64_t buffer_bytes;
+    // CLOCK_REALTIME nanoseconds.
+    uint64_t created_ns;
+};
 
 class RamBuffer {
     const std::string detector_name_;
     const int n_modules_;
-    const int n_slots_;
-
     const size_t meta_bytes_;
     const size_t image_bytes_;
-    const size_t buffer_bytes_;
+    // NUMA node of each module, empty when the buffer is not bound.
+    const std::vector<int> numa_nodes_;
+
+    // Module metadata arrays of a slot, cache line aligned and padded.
+    static constexpr int META_GENERATION = 0;
+    static constexpr int META_PULSE_ID = 1;
+    static constexpr int META_FRAME_INDEX = 2;
+    static constexpr int META_DAQ_REC = 3;
+    static constexpr int META_N_RECV_PACKETS = 4;
+    // Image values of the slot instead of one per module.
+    static constexpr int META_IMAGE = 5;
+    static constexpr int N_META_FIELDS = 6;
+    static constexpr int IMAGE_MISSING_MODULES = 0;
+    static constexpr int IMAGE_PULSE_ID = 1;
+    const size_t meta_stride_;
+
+    // Layout, from the header when attaching to an existing buffer.
+    int n_slots_;
+    size_t module_meta_offset_;
+    size_t image_offset_;
+    size_t buffer_bytes_;
 
     int shm_fd_;
+    // This process created the buffer and initialized the header.
+    bool is_creator_ = false;
     void* buffer_;
+    // buffer_bytes_ rounded up to the page size of the mapping.
+    size_t mapped_bytes_;
+    size_t page_bytes_;
+    bool is_locked_ = false;
 
+    RamBufferHeader* header_;
     ModuleFrame* meta_buffer_;
+    // Structure of arrays with the ModuleFrame fields assemble_image checks
+    // and the seqlock generation of each module frame slot (odd while the
+    // frame is being written, incremented again when it is committed).
+    // N_META_FIELDS arrays of meta_stride_ values per slot.
+    uint64_t* module_meta_buffer_;
     char* image_buffer_;
 
+    // Reads of this process that found the slot overwritten.
+    mutable std::atomic<uint64_t> n_stale_reads_{0};
+    mutable std::atomic<uint64_t> n_torn_reads_{0};
+
+    std::atomic<uint64_t>* get_generations(const uint64_t pulse_id) const;
+    uint64_t sum_generations(const uint64_t pulse_id) const;
+    void start_write(std::atomic<uint64_t>& generation) const;
+    void end_write(std::atomic<uint64_t>& generation) const;
+
+    uint64_t* get_module_meta(const uint64_t pulse_id,
+                              const int i_field) const;
+    void set_module_meta(const ModuleFrame& meta,
+                         const uint64_t module_id) const;
+
+    void set_layout(const int n_slots);
+    void attach_layout();
+    void init_header();
+    bool map_hugetlbfs(const BufferUtils::RamBufferOptions& options);
+    void map_shm(const BufferUtils::RamBufferOptions& options);
+    void bind_numa_nodes() const;
+
 public:
+    // Returned by begin_read_image when the slot cannot be read.
+    static constexpr uint64_t INVALID_GENERATION = UINT64_MAX;
+
+    // Attach to the buffer of detector_name, or create it with n_slots if
+    // it does not exist yet. Throws if the existing buffer has another
+    // number of modules or an incompatible layout. Huge pages and locking
+    // fall back to the default mapping with a warning when the system does
+    // not provide them.
     RamBuffer(const std::string& detector_name,
               const int n_modules,
-              const int n_slots=buffer_config::RAM_BUFFER_N_SLOTS);
+              const int n_slots=buffer_config::RAM_BUFFER_N_SLOTS,
+              const BufferUtils::RamBufferOptions& options={});
+    // Only unmaps, the buffer stays for the other processes.
     ~RamBuffer();
 
+    // Delete the buffer of detector_name, processes that have it mapped
+    // keep their mapping.
+    static void remove(const std::string& detector_name,
+                       const BufferUtils::RamBufferOptions& options={});
+
+    const RamBufferHeader& get_header() const;
+    int get_n_slots() const;
+
     void write_frame(const ModuleFrame &src_meta, const char *src_data) const;
-    void read_frame(const uint64_t pulse_id,
-                     const uint64_t module_id,
-                     ModuleFrame &meta,
-                     char *data) const;
+    // Slot to write the frame data into, only the address.
+    char* get_frame_slot(const uint64_t pulse_id,
+                         const uint64_t module_id) const;
+    // Mark the frame slot as being written before any data goes into it,
+    // until commit_frame or abort_frame_write.
+    void begin_frame_write(const uint64_t pulse_id,
+                           const uint64_t module_id) const;
+    // End the write of a frame that is not committed: the slot holds no
+    // frame anymore.
+    void abort_frame_write(const uint64_t pulse_id,
+                           const uint64_t module_id) const;
+    void commit_frame(const ModuleFrame &src_meta) const;
+    // Whole image slot, for receivers that assemble all modules at once.
+    // Same as the frame slots, for all modules of the image.
+    char* get_image_slot(const uint64_t pulse_id) const;
+    void begin_image_write(const uint64_t pulse_id) const;
+    void abort_image_write(const uint64_t pulse_id) const;
+    // Commit the metadata of all modules of an image written into its
+    // slot. The packets of each module and their count come from
+    // packets_bitmap (JF_N_PACKETS_PER_FRAME bits per module).
+    void commit_image(const ModuleFrame &src_meta,
+                      const uint64_t *packets_bitmap) const;
+    // Copy a frame, returns false if the slot does not hold the frame of
+    // pulse_id or it was overwritten during the copy.
+    bool read_frame(const uint64_t pulse_id,
+                    const uint64_t module_id,
+                    ModuleFrame &meta,
+                    char *data) const;
+    // The image data is used in place: take the generation before reading
+    // it and check with end_read_image after, the data is valid only if the
+    // image slot was not overwritten in between.
     char* read_image(const uint64_t pulse_id) const;
+    uint64_t begin_read_image(const uint64_t pulse_id) const;
+    bool end_read_image(const uint64_t pulse_id,
+                        const uint64_t generation) const;
+    // Modules being written or overwritten during the assembly make the
+    // image not good. Modules in missing_modules (bit per module) did not
+    // report the pulse, the image metadata is taken from the others. The
+    // missing_modules are stored in the image slot for its readers.
     void assemble_image(
-            const uint64_t pulse_id, ImageMetadata &image_meta) const;
+            const uint64_t pulse_id,
+            ImageMetadata &image_meta,
+            const uint64_t missing_modules=0) const;
+    // Bit i set if module i did not report the pulse to the assembler. All
+    // modules if the slot does not hold the assembled image of pulse_id.
+    uint64_t get_missing_modules(const uint64_t pulse_id) const;
+
+    // NUMA node the module frames are bound to, -1 if not bound.
+    int get_module_numa_node(const uint64_t module_id) const;
+    // NUMA node the frame slot currently is on, -1 if not in memory yet.
+    int get_frame_numa_node(const uint64_t pulse_id,
+                            const uint64_t module_id) const;
+
+    // Reads that found a newer pulse_id in the slot.
+    uint64_t get_n_stale_reads() const;
+    // Reads during which the slot was being written.
+    uint64_t get_n_torn_reads() const;
 };
 
 
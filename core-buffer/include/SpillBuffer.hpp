@@ -0,0 +1,78 @@
+#ifndef SF_DAQ_BUFFER_SPILLBUFFER_HPP
+#define SF_DAQ_BUFFER_SPILLBUFFER_HPP
+
+#include <string>
+#include "formats.hpp"
+#include "RamBuffer.hpp"
+
+/** Ring file of images on local disk, behind the RamBuffer
+
+    One record per image slot (pulse_id % n_slots): a header with the
+    record pulse_id and the ModuleFrame of each module, then the module
+    frames data, all aligned to SPILL_BUFFER_ALIGNMENT for O_DIRECT.
+
+    The writer copies images from the RamBuffer into records and writes
+    them before the RamBuffer overwrites them. It invalidates the record
+    header before writing the data, so readers that check the header
+    before and after reading the data never return torn frames. **/
+class SpillBuffer {
+    const std::string filename_;
+    const int n_modules_;
+    const int n_slots_;
+    const size_t header_bytes_;
+    const size_t record_bytes_;
+    const bool is_writer_;
+
+    mutable int fd_ = -1;
+    // Writer opened the file with O_DIRECT.
+    bool is_direct_ = false;
+    // Aligned header of an invalid record.
+    char* empty_header_ = nullptr;
+
+    bool open_file() const;
+    off_t get_record_offset(const uint64_t pulse_id) const;
+    uint64_t read_record_pulse_id(const off_t record_offset) const;
+    void pwrite_all(const char* buffer,
+                    const size_t n_bytes,
+                    const off_t offset) const;
+
+public:
+    // The writer creates the file, readers open it when it exists.
+    SpillBuffer(const std::string& filename,
+                const int n_modules,
+                const int n_slots=buffer_config::SPILL_BUFFER_N_SLOTS,
+                const bool is_writer=false);
+    virtual ~SpillBuffer();
+
+    // Bytes of a record, records must be SPILL_BUFFER_ALIGNMENT aligned.
+    size_t get_record_bytes() const;
+    bool is_direct() const;
+
+    // Copy the frames of pulse_id from the RamBuffer into record. Returns
+    // the number of modules copied, frames already overwritten in the
+    // RamBuffer are marked invalid and their data is zeroed.
+    int copy_image(const RamBuffer& ram_buffer,
+                   const uint64_t pulse_id,
+                   char* record) const;
+    void write_record(const char* record) const;
+
+    // Spill file only, false if the slot holds another pulse_id or was
+    // overwritten during the read.
+    bool read_spilled_frame(const uint64_t pulse_id,
+                            const uint64_t module_id,
+                            ModuleFrame& meta,
+                            char* data) const;
+    // Data of all modules, n_modules * MODULE_N_BYTES. False if a module
+    // was missing from the spilled image as well.
+    bool read_spilled_image(const uint64_t pulse_id, char* data) const;
+
+    // RamBuffer first, then the spill file.
+    bool read_frame(const RamBuffer& ram_buffer,
+                    const uint64_t pulse_id,
+                    const uint64_t module_id,
+                    ModuleFrame& meta,
+                    char* data) const;
+};
+
+
+#endif //SF_DAQ_BUFFER_SPILLBUFFER_HPP
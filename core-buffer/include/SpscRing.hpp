@@ -0,0 +1,110 @@
+#ifndef SF_DAQ_BUFFER_SPSCRING_HPP
+#define SF_DAQ_BUFFER_SPSCRING_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+
+/** Single producer, single consumer ring
+
+    Lock-free handoff of pre-allocated slots between two threads. The
+    producer fills the slot from acquire_write and publishes it with
+    commit_write; the consumer reads the slot from acquire_read and gives it
+    back with release_read. Slots are never copied or allocated.
+
+    The wait_ variants spin (yielding the core) until a slot is available. **/
+template <typename T, size_t CAPACITY>
+class SpscRing {
+    static_assert(CAPACITY > 0 && (CAPACITY & (CAPACITY - 1)) == 0,
+                  "CAPACITY must be a power of 2.");
+
+    T slots_[CAPACITY];
+
+    // Producer and consumer indexes on separate cache lines. Each side also
+    // keeps a copy of the other index to touch the shared line less often.
+    alignas(64) std::atomic<size_t> write_index_{0};
+    size_t cached_read_index_ = 0;
+
+    alignas(64) std::atomic<size_t> read_index_{0};
+    size_t cached_write_index_ = 0;
+
+public:
+    // Slot to fill, nullptr if the ring is full.
+    T* acquire_write()
+    {
+        const auto write_index = write_index_.load(std::memory_order_relaxed);
+
+        if (write_index - cached_read_index_ == CAPACITY) {
+            cached_read_index_ = read_index_.load(std::memory_order_acquire);
+
+            if (write_index - cached_read_index_ == CAPACITY) {
+                return nullptr;
+            }
+        }
+
+        return &slots_[write_index % CAPACITY];
+    }
+
+    void commit_write()
+    {
+        const auto write_index = write_index_.load(std::memory_order_relaxed);
+        write_index_.store(write_index + 1, std::memory_order_release);
+    }
+
+    // Oldest filled slot, nullptr if the ring is empty.
+    T* acquire_read()
+    {
+        const auto read_index = read_index_.load(std::memory_order_relaxed);
+
+        if (read_index == cached_write_index_) {
+            cached_write_index_ = write_index_.load(std::memory_order_acquire);
+
+            if (read_index == cached_write_index_) {
+                return nullptr;
+            }
+        }
+
+        return &slots_[read_index % CAPACITY];
+    }
+
+    void release_read()
+    {
+        const auto read_index = read_index_.load(std::memory_order_relaxed);
+        read_index_.store(read_index + 1, std::memory_order_release);
+    }
+
+    T& wait_write()
+    {
+        T* slot;
+        while ((slot = acquire_write()) == nullptr) {
+            std::this_thread::yield();
+        }
+
+        return *slot;
+    }
+
+    T& wait_read()
+    {
+        T* slot;
+        while ((slot = acquire_read()) == nullptr) {
+            std::this_thread::yield();
+        }
+
+        return *slot;
+    }
+
+    // Approximate when called concurrently with the other side.
+    size_t size() const
+    {
+        return write_index_.load(std::memory_order_acquire) -
+               read_index_.load(std::memory_order_acquire);
+    }
+
+    static constexpr size_t capacity()
+    {
+        return CAPACITY;
+    }
+};
+
+
+#endif //SF_DAQ_BUFFER_SPSCRING_HPP
@@ -2,6 +2,7 @@
 #define BUFFERCONFIG_HPP
 
 #include <cstddef>
+#include <cstdint>
 #include <string>
 
 namespace buffer_config {
@@ -11,6 +12,11 @@ namespace buffer_config {
     const size_t MODULE_N_PIXELS = MODULE_X_SIZE * MODULE_Y_SIZE;
     const size_t PIXEL_N_BYTES = 2;
     const size_t MODULE_N_BYTES = MODULE_N_PIXELS * PIXEL_N_BYTES;
+    // Modules have 2 rows of 4 chips (ASICs) of 256x256 pixels.
+    const size_t CHIP_SIZE = 256;
+    // Gap between chips in assembled images, covered by the double sized
+    // pixels at the inner chip borders.
+    const size_t CHIP_GAP_PIXELS = 2;
 
     // How many frames we store in each file.
     // Must be power of 10 and <= than FOLDER_MOD
@@ -28,9 +34,19 @@ namespace buffer_config {
     const size_t RB_READ_RETRY_INTERVAL_MS = 5;
     // How many frames to read at once from file.
     const size_t BUFFER_BLOCK_SIZE = 100;
+    // Marks a written frame in the file, changes with the frame layout.
+    // 0xBE was the layout without ModuleFrame.packets_bitmap.
+    const char BUFFER_FORMAT_MARKER = '\xBF';
 
 
     const size_t BUFFER_UDP_N_RECV_MSG = 128;
+    // Max number of frames a module receiver keeps open for late packets.
+    const int BUFFER_UDP_MAX_REORDER_WINDOW = 8;
+    // Largest pulse_id step between two frames of a module that is accepted.
+    const uint64_t BUFFER_UDP_MAX_PULSE_ID_STEP = 1000;
+    // A packet this many frames older than the last frame of a module means
+    // the detector frame counter was reset, not a late packet.
+    const uint64_t BUFFER_UDP_FRAME_RESET_LIMIT = 1000;
     // Size of UDP recv buffer
     const int BUFFER_UDP_RCVBUF_N_SLOTS = 100;
     // 8246 bytes for each UDP packet.
@@ -38,6 +54,21 @@ namespace buffer_config {
             (128 * BUFFER_UDP_RCVBUF_N_SLOTS * 8246);
     // Microseconds timeout for UDP recv.
     const int BUFFER_UDP_US_TIMEOUT = 2 * 1000;
+    // Block size of the packet mmap (TPACKET_V3) ring.
+    const unsigned int BUFFER_PACKET_MMAP_BLOCK_BYTES = 1 << 22;
+    // Max packet size in the packet mmap ring (8240 bytes + headers).
+    const unsigned int BUFFER_PACKET_MMAP_FRAME_BYTES = 1 << 14;
+    // Number of blocks in the packet mmap ring - 256MB per socket.
+    const unsigned int BUFFER_PACKET_MMAP_N_BLOCKS = 64;
+    // Ms after which the kernel passes a partially filled block to us.
+    const unsigned int BUFFER_PACKET_MMAP_BLOCK_TIMEOUT_MS = 1;
+    // Packet batches between the JFJ socket and assembly threads - 2 frames.
+    const size_t BUFFER_JFJ_N_PACKET_BATCHES = 64;
+    // Closed frames between the JFJ assembly and publish threads.
+    const size_t BUFFER_JFJ_N_FRAMES = 16;
+    // Ms without packets after which a JFJ stream adds empty parts for the
+    // frames the other streams receive.
+    const int BUFFER_JFJ_FLUSH_MS = 10;
     // HWM for live stream from buffer.
     const int BUFFER_ZMQ_SNDHWM = 100;
     // HWM for live stream from buffer.
@@ -46,6 +77,35 @@ namespace buffer_config {
     const std::string BUFFER_LIVE_IPC_URL = "ipc:///tmp/sf-live-";
     // Number of image slots in ram buffer - 10 seconds should be enough
     const int RAM_BUFFER_N_SLOTS = 100 * 10;
+    // Alignment of the ram buffer image region, module frames start on
+    // page boundaries so they can be bound to NUMA nodes.
+    const size_t RAM_BUFFER_IMAGE_ALIGNMENT = 2 * 1024 * 1024;
+    // Bytes reserved for the header at the start of the ram buffer.
+    const size_t RAM_BUFFER_HEADER_BYTES = 4096;
+    // Ram buffer header marker and version of the memory layout.
+    const uint64_t RAM_BUFFER_MAGIC = 0x5346524142554646;
+    const uint32_t RAM_BUFFER_VERSION = 3;
+    // How long to wait for the creator of the ram buffer to initialize it.
+    const int RAM_BUFFER_ATTACH_TIMEOUT_MS = 5000;
+    // Image slots in the spill buffer file - 5 minutes of history.
+    const int SPILL_BUFFER_N_SLOTS = 100 * 60 * 5;
+    // Spill buffer records are aligned for O_DIRECT writes.
+    const size_t SPILL_BUFFER_ALIGNMENT = 4096;
+    // Time the assembler waits for the other modules after the first
+    // module reported a pulse.
+    const int ASSEMBLER_DEADLINE_MS = 50;
+    // Events kept in each event ring - 10 seconds at 100 Hz.
+    const int EVENT_RING_N_SLOTS = 1024;
+    // Consumers that can read an event ring at the same time.
+    const int EVENT_RING_MAX_CONSUMERS = 16;
+    // Polls of the write index before waiting on the futex.
+    const int EVENT_RING_SPIN_COUNT = 1000;
+    // Event ring shared memory: detector name, suffix, stream name.
+    const std::string EVENT_RING_SHM_SUFFIX = "-events-";
+    const uint64_t EVENT_RING_MAGIC = 0x53464556454e5453;
+    const uint32_t EVENT_RING_VERSION = 2;
+    // Suffix of the latency trace shared memory, after the detector name.
+    const std::string PULSE_TRACE_SHM_SUFFIX = "-trace";
 }
 
 #endif //BUFFERCONFIG_HPP
@@ -12,6 +12,8 @@ struct ModuleFrame {
     uint64_t daq_rec;
     uint64_t n_recv_packets;
     uint64_t module_id;
+    // Bit i set if packet i (8 KB, 4 module rows) was received.
+    uint64_t packets_bitmap[JF_N_PACKETS_PER_FRAME / 64];
 };
 #pragma pack(pop)
 
@@ -26,6 +28,29 @@ struct ImageMetadata {
 };
 #pragma pack(pop)
 
+// Time of one trace point, in CLOCK_REALTIME nanoseconds. The pulse_id
+// tells which pulse the slot was last written for.
+#pragma pack(push)
+#pragma pack(1)
+struct TracePoint {
+    uint64_t pulse_id;
+    uint64_t time_ns;
+};
+#pragma pack(pop)
+
+#pragma pack(push)
+#pragma pack(1)
+struct PulseTrace {
+    // Kernel receive timestamp of the first frame packet.
+    TracePoint module_recv[JUNGFRAU_N_MODULES];
+    // Frame committed to the RamBuffer.
+    TracePoint module_commit[JUNGFRAU_N_MODULES];
+    TracePoint assembler_emit;
+    TracePoint stream_send;
+    TracePoint writer_write;
+};
+#pragma pack(pop)
+
 struct ModuleFrameBuffer {
     ModuleFrame module[JUNGFRAU_N_MODULES];
 };
@@ -33,7 +58,7 @@ struct ModuleFrameBuffer {
 #pragma pack(push)
 #pragma pack(1)
 struct BufferBinaryFormat {
-    const char FORMAT_MARKER = 0xBE;
+    const char FORMAT_MARKER = buffer_config::BUFFER_FORMAT_MARKER;
     ModuleFrame meta;
     char data[buffer_config::MODULE_N_BYTES];
 };
@@ -5,6 +5,7 @@
 
 #define JUNGFRAU_N_MODULES 32
 #define JUNGFRAU_BYTES_PER_PACKET 8240
+#define JUNGFRAU_HEADER_BYTES_PER_PACKET 48
 #define JUNGFRAU_DATA_BYTES_PER_PACKET 8192
 #define JF_N_PACKETS_PER_FRAME 128
 #define JUNGFRAU_DATA_BYTES_PER_FRAME 1048576
@@ -33,5 +34,31 @@ struct jungfrau_packet {
 };
 #pragma pack(pop)
 
+// Header part of jungfrau_packet, used to scatter header and data on receive.
+#pragma pack(push)
+#pragma pack(2)
+struct jungfrau_header {
+    uint64_t framenum;
+    uint32_t exptime;
+    uint32_t packetnum;
+
+    double bunchid;
+    uint64_t timestamp;
+
+    uint16_t moduleID;
+    uint16_t xCoord;
+    uint16_t yCoord;
+    uint16_t zCoord;
+
+    uint32_t debug;
+    uint16_t roundRobin;
+    uint8_t detectortype;
+    uint8_t headerVersion;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(jungfrau_header) == JUNGFRAU_HEADER_BYTES_PER_PACKET,
+              "jungfrau_header must match the jungfrau_packet header.");
+
 
 #endif
@@ -6,7 +6,8 @@
 #define JFJOCH_N_MODULES 32
 #define JFJOCH_BYTES_PER_PACKET 8240
 #define JFJOCH_DATA_BYTES_PER_PACKET 8192
-#define JFJOCH_N_PACKETS_PER_FRAME (JFJOCH_N_MODULES * 128)
+#define JFJOCH_N_PACKETS_PER_MODULE 128
+#define JFJOCH_N_PACKETS_PER_FRAME (JFJOCH_N_MODULES * JFJOCH_N_PACKETS_PER_MODULE)
 #define JFJOCH_DATA_BYTES_PER_FRAME (JFJOCH_N_MODULES * 1048576)
 
 // 48 bytes + 8192 bytes = 8240 bytes
@@ -8,6 +8,9 @@
 #include <rapidjson/document.h>
 #include <rapidjson/stringbuffer.h>
 #include <iostream>
+#include <cstring>
+#include <sched.h>
+#include <sys/mman.h>
 
 using namespace std;
 using namespace buffer_config;
@@ -158,6 +161,179 @@ BufferUtils::DetectorConfig BufferUtils::read_json_config(
     rapidjson::Document config_parameters;
     config_parameters.ParseStream(isw);
 
+    auto udp_recv_backend = UdpRecvBackend::RECVMMSG;
+    if (config_parameters.HasMember("udp_recv_backend")) {
+        const string backend = config_parameters["udp_recv_backend"].GetString();
+
+        if (backend == "packet_mmap") {
+            udp_recv_backend = UdpRecvBackend::PACKET_MMAP;
+        } else if (backend != "recvmmsg") {
+            throw runtime_error("Unknown udp_recv_backend " + backend);
+        }
+    }
+
+    string udp_recv_interface = "";
+    if (config_parameters.HasMember("udp_recv_interface")) {
+        udp_recv_interface = config_parameters["udp_recv_interface"].GetString();
+    }
+
+    vector<int> udp_recv_cores;
+    if (config_parameters.HasMember("udp_recv_cores")) {
+        for (const auto& core : config_parameters["udp_recv_cores"].GetArray()) {
+            udp_recv_cores.push_back(core.GetInt());
+        }
+    }
+
+    vector<int> udp_recv_module_cores;
+    if (config_parameters.HasMember("udp_recv_module_cores")) {
+        for (const auto& core :
+                config_parameters["udp_recv_module_cores"].GetArray()) {
+            udp_recv_module_cores.push_back(core.GetInt());
+        }
+    }
+
+    int udp_recv_busy_poll_us = 0;
+    if (config_parameters.HasMember("udp_recv_busy_poll_us")) {
+        udp_recv_busy_poll_us =
+                config_parameters["udp_recv_busy_poll_us"].GetInt();
+    }
+
+    int udp_recv_rt_priority = 0;
+    if (config_parameters.HasMember("udp_recv_rt_priority")) {
+        udp_recv_rt_priority =
+                config_parameters["udp_recv_rt_priority"].GetInt();
+    }
+
+    bool udp_recv_mlockall = false;
+    if (config_parameters.HasMember("udp_recv_mlockall")) {
+        udp_recv_mlockall = config_parameters["udp_recv_mlockall"].GetBool();
+    }
+
+    int udp_recv_reorder_window = 1;
+    if (config_parameters.HasMember("udp_recv_reorder_window")) {
+        udp_recv_reorder_window =
+                config_parameters["udp_recv_reorder_window"].GetInt();
+    }
+
+    int udp_recv_n_streams = 1;
+    if (config_parameters.HasMember("udp_recv_n_streams")) {
+        udp_recv_n_streams = config_parameters["udp_recv_n_streams"].GetInt();
+    }
+
+    bool udp_recv_reuseport = false;
+    if (config_parameters.HasMember("udp_recv_reuseport")) {
+        udp_recv_reuseport = config_parameters["udp_recv_reuseport"].GetBool();
+    }
+
+    bool latency_trace = false;
+    if (config_parameters.HasMember("latency_trace")) {
+        latency_trace = config_parameters["latency_trace"].GetBool();
+    }
+
+    RamBufferOptions ram_buffer;
+    if (config_parameters.HasMember("ram_buffer_n_slots")) {
+        ram_buffer.n_slots = config_parameters["ram_buffer_n_slots"].GetInt();
+    }
+
+    if (config_parameters.HasMember("ram_buffer_pages")) {
+        const string pages = config_parameters["ram_buffer_pages"].GetString();
+
+        if (pages == "transparent") {
+            ram_buffer.pages = RamBufferPages::TRANSPARENT_HUGE;
+        } else if (pages == "hugetlbfs") {
+            ram_buffer.pages = RamBufferPages::HUGETLBFS;
+        } else if (pages != "small") {
+            throw runtime_error("Unknown ram_buffer_pages " + pages);
+        }
+    }
+
+    if (config_parameters.HasMember("ram_buffer_hugetlbfs_dir")) {
+        ram_buffer.hugetlbfs_dir =
+                config_parameters["ram_buffer_hugetlbfs_dir"].GetString();
+    }
+
+    if (config_parameters.HasMember("ram_buffer_populate")) {
+        ram_buffer.populate = config_parameters["ram_buffer_populate"].GetBool();
+    }
+
+    if (config_parameters.HasMember("ram_buffer_mlock")) {
+        ram_buffer.lock = config_parameters["ram_buffer_mlock"].GetBool();
+    }
+
+    if (config_parameters.HasMember("ram_buffer_numa_nodes")) {
+        for (const auto& node :
+                config_parameters["ram_buffer_numa_nodes"].GetArray()) {
+            ram_buffer.numa_nodes.push_back(node.GetInt());
+        }
+    }
+
+    SpillBufferOptions spill_buffer;
+    if (config_parameters.HasMember("spill_buffer_file")) {
+        spill_buffer.filename =
+                config_parameters["spill_buffer_file"].GetString();
+    }
+
+    if (config_parameters.HasMember("spill_buffer_n_slots")) {
+        spill_buffer.n_slots =
+                config_parameters["spill_buffer_n_slots"].GetInt();
+    }
+
+    auto event_transport = EventTransport::ZMQ;
+    if (config_parameters.HasMember("event_transport")) {
+        const string transport =
+                config_parameters["event_transport"].GetString();
+
+        if (transport == "shm") {
+            event_transport = EventTransport::SHM;
+        } else if (transport != "zmq") {
+            throw runtime_error("Unknown event_transport " + transport);
+        }
+    }
+
+    int assembler_deadline_ms = ASSEMBLER_DEADLINE_MS;
+    if (config_parameters.HasMember("assembler_deadline_ms")) {
+        assembler_deadline_ms =
+                config_parameters["assembler_deadline_ms"].GetInt();
+    }
+
+    DetectorGeometry geometry;
+    if (config_parameters.HasMember("geometry")) {
+        const auto& geometry_config = config_parameters["geometry"];
+
+        for (const auto& module : geometry_config["modules"].GetArray()) {
+            ModuleGeometry module_geometry;
+            module_geometry.x = module["x"].GetInt();
+            module_geometry.y = module["y"].GetInt();
+            if (module.HasMember("rotation")) {
+                module_geometry.rotation = module["rotation"].GetInt();
+            }
+
+            geometry.modules.push_back(module_geometry);
+        }
+
+        if (geometry_config.HasMember("image_x_size")) {
+            geometry.image_x_size = geometry_config["image_x_size"].GetInt();
+            geometry.image_y_size = geometry_config["image_y_size"].GetInt();
+        }
+
+        if (geometry_config.HasMember("gap_pixels")) {
+            geometry.gap_pixels = geometry_config["gap_pixels"].GetBool();
+        }
+
+        if (geometry_config.HasMember("double_pixels")) {
+            const string double_pixels =
+                    geometry_config["double_pixels"].GetString();
+
+            if (double_pixels == "mask") {
+                geometry.double_pixels = DoublePixels::MASK;
+            } else if (double_pixels == "duplicate") {
+                geometry.double_pixels = DoublePixels::DUPLICATE;
+            } else if (double_pixels != "keep") {
+                throw runtime_error("Unknown double_pixels " + double_pixels);
+            }
+        }
+    }
+
     return {
             config_parameters["streamvis_stream"].GetString(),
             config_parameters["streamvis_rate"].GetInt(),
@@ -169,5 +345,112 @@ BufferUtils::DetectorConfig BufferUtils::read_json_config(
             config_parameters["n_modules"].GetInt(),
             config_parameters["start_udp_port"].GetInt(),
             config_parameters["buffer_folder"].GetString(),
+            udp_recv_backend,
+            udp_recv_interface,
+            udp_recv_cores,
+            udp_recv_module_cores,
+            udp_recv_busy_poll_us,
+            udp_recv_rt_priority,
+            udp_recv_mlockall,
+            udp_recv_reorder_window,
+            udp_recv_n_streams,
+            udp_recv_reuseport,
+            latency_trace,
+            ram_buffer,
+            geometry,
+            spill_buffer,
+            event_transport,
+            assembler_deadline_ms
     };
 }
+
+void BufferUtils::pin_thread_to_core(const int core_id)
+{
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(core_id, &cpu_set);
+
+    // pid 0 is the calling thread.
+    if (sched_setaffinity(0, sizeof(cpu_set_t), &cpu_set) != 0) {
+        stringstream err_msg;
+
+        err_msg << "[BufferUtils::pin_thread_to_core]";
+        err_msg << " Cannot pin thread to core " << core_id << ": ";
+        err_msg << strerror(errno) << endl;
+
+        throw runtime_error(err_msg.str());
+    }
+}
+
+void BufferUtils::pin_thread_to_numa_node(const int numa_node)
+{
+    const string cpulist_filename = "/sys/devices/system/node/node" +
+                                    to_string(numa_node) + "/cpulist";
+    ifstream cpulist_file(cpulist_filename);
+
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+
+    // Comma separated core ranges, for example "0-7,16-23".
+    string cpu_range;
+    while (getline(cpulist_file, cpu_range, ',')) {
+        int first_core, last_core;
+        const auto n_read = sscanf(
+                cpu_range.c_str(), "%d-%d", &first_core, &last_core);
+
+        if (n_read < 1) {
+            continue;
+        }
+        if (n_read == 1) {
+            last_core = first_core;
+        }
+
+        for (int core_id = first_core; core_id <= last_core; core_id++) {
+            CPU_SET(core_id, &cpu_set);
+        }
+    }
+
+    if (CPU_COUNT(&cpu_set) == 0) {
+        errno = ENODEV;
+    }
+
+    if (CPU_COUNT(&cpu_set) == 0 ||
+        sched_setaffinity(0, sizeof(cpu_set_t), &cpu_set) != 0) {
+        stringstream err_msg;
+
+        err_msg << "[BufferUtils::pin_thread_to_numa_node]";
+        err_msg << " Cannot pin thread to NUMA node " << numa_node << ": ";
+        err_msg << strerror(errno) << endl;
+
+        throw runtime_error(err_msg.str());
+    }
+}
+
+void BufferUtils::set_thread_rt_priority(const int priority)
+{
+    sched_param param = {};
+    param.sched_priority = priority;
+
+    // pid 0 is the calling thread.
+    if (sched_setscheduler(0, SCHED_FIFO, &param) != 0) {
+        stringstream err_msg;
+
+        err_msg << "[BufferUtils::set_thread_rt_priority]";
+        err_msg << " Cannot set SCHED_FIFO priority " << priority << ": ";
+        err_msg << strerror(errno) << endl;
+
+        throw runtime_error(err_msg.str());
+    }
+}
+
+void BufferUtils::lock_process_memory()
+{
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        stringstream err_msg;
+
+        err_msg << "[BufferUtils::lock_process_memory]";
+        err_msg << " Cannot mlockall: " << strerror(errno) << endl;
+
+        throw runtime_error(err_msg.str());
+    }
+}
@@ -0,0 +1,394 @@
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <ctime>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include "EventRing.hpp"
+
+using namespace std;
+using namespace buffer_config;
+
+static_assert(sizeof(atomic<uint32_t>) == sizeof(uint32_t),
+              "The futex word is shared with the kernel.");
+
+namespace {
+    size_t align_64(const size_t n_bytes)
+    {
+        return ((n_bytes + 63) / 64) * 64;
+    }
+
+    // Shared (not FUTEX_PRIVATE), the waiters are other processes.
+    long futex(atomic<uint32_t>* word,
+               const int op,
+               const uint32_t value,
+               const timespec* timeout)
+    {
+        return syscall(SYS_futex, (uint32_t*) word, op, value,
+                       timeout, nullptr, 0);
+    }
+
+    // Lock of the first byte of a consumer entry in the shared memory.
+    struct flock get_consumer_lock(const EventRingHeader* header,
+                                   const EventRingConsumer& consumer,
+                                   const short type)
+    {
+        struct flock lock = {};
+        lock.l_type = type;
+        lock.l_whence = SEEK_SET;
+        lock.l_start = (const char*) &consumer - (const char*) header;
+        lock.l_len = 1;
+        return lock;
+    }
+}
+
+EventRing::EventRing(
+        const string& detector_name,
+        const string& stream_name,
+        const size_t event_bytes,
+        const bool is_producer,
+        const int n_slots) :
+        shm_name_(detector_name + EVENT_RING_SHM_SUFFIX + stream_name),
+        event_bytes_(event_bytes),
+        // Sequence number and event, cache line aligned.
+        slot_bytes_(align_64(sizeof(uint64_t) + event_bytes)),
+        n_slots_(n_slots),
+        is_producer_(is_producer)
+{
+    if (n_slots_ < 1 || event_bytes_ == 0) {
+        throw runtime_error("[EventRing::EventRing] Invalid ring size.");
+    }
+
+    buffer_bytes_ = align_64(sizeof(EventRingHeader)) +
+                    (slot_bytes_ * n_slots_);
+
+    shm_fd_ = shm_open(shm_name_.c_str(), O_RDWR | O_CREAT | O_EXCL,
+                       S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH);
+    const bool is_creator = shm_fd_ != -1;
+
+    if (!is_creator) {
+        shm_fd_ = shm_open(shm_name_.c_str(), O_RDWR, 0);
+    }
+
+    if (shm_fd_ == -1) {
+        stringstream err_msg;
+        err_msg << "[EventRing::EventRing] Cannot open " << shm_name_;
+        err_msg << ": " << strerror(errno);
+        throw runtime_error(err_msg.str());
+    }
+
+    if (is_creator && ftruncate(shm_fd_, buffer_bytes_) != 0) {
+        stringstream err_msg;
+        err_msg << "[EventRing::EventRing] Cannot size " << shm_name_;
+        err_msg << ": " << strerror(errno);
+        close(shm_fd_);
+        throw runtime_error(err_msg.str());
+    }
+
+    if (!is_creator) {
+        attach_header();
+    }
+
+    buffer_ = mmap(NULL, buffer_bytes_, PROT_READ | PROT_WRITE,
+                   MAP_SHARED, shm_fd_, 0);
+    if (buffer_ == MAP_FAILED) {
+        stringstream err_msg;
+        err_msg << "[EventRing::EventRing] Cannot map " << shm_name_;
+        err_msg << ": " << strerror(errno);
+        close(shm_fd_);
+        throw runtime_error(err_msg.str());
+    }
+
+    header_ = (EventRingHeader*) buffer_;
+    slots_ = (char*) buffer_ + align_64(sizeof(EventRingHeader));
+
+    if (is_creator) {
+        init_header();
+    }
+
+    if (!is_producer_) {
+        register_consumer();
+    }
+}
+
+EventRing::~EventRing()
+{
+    if (consumer_ != nullptr) {
+        lock_consumer(*consumer_, F_UNLCK);
+    }
+
+    munmap(buffer_, buffer_bytes_);
+    close(shm_fd_);
+}
+
+void EventRing::remove(const string& detector_name, const string& stream_name)
+{
+    const auto shm_name = detector_name + EVENT_RING_SHM_SUFFIX + stream_name;
+    shm_unlink(shm_name.c_str());
+}
+
+void EventRing::init_header()
+{
+    header_->version = EVENT_RING_VERSION;
+    header_->event_bytes = event_bytes_;
+    header_->n_slots = n_slots_;
+    header_->slot_bytes = slot_bytes_;
+
+    // Attaching processes wait for the magic to read the header.
+    header_->magic.store(EVENT_RING_MAGIC, memory_order_release);
+}
+
+void EventRing::attach_header()
+{
+    stringstream err_msg;
+    err_msg << "[EventRing::attach_header] Ring " << shm_name_ << " ";
+
+    // The creator first sizes the ring, then writes the header.
+    const size_t header_bytes = sizeof(EventRingHeader);
+    struct stat fd_stats = {};
+    int wait_ms = 0;
+    for (; wait_ms < RAM_BUFFER_ATTACH_TIMEOUT_MS; wait_ms++) {
+        if (fstat(shm_fd_, &fd_stats) == 0 &&
+            (size_t) fd_stats.st_size >= header_bytes) {
+            break;
+        }
+        usleep(1000);
+    }
+
+    auto header = (EventRingHeader*) mmap(
+            NULL, header_bytes, PROT_READ, MAP_SHARED, shm_fd_, 0);
+
+    if (wait_ms == RAM_BUFFER_ATTACH_TIMEOUT_MS || header == MAP_FAILED) {
+        close(shm_fd_);
+        err_msg << "not initialized by its creator.";
+        throw runtime_error(err_msg.str());
+    }
+
+    for (; wait_ms < RAM_BUFFER_ATTACH_TIMEOUT_MS; wait_ms++) {
+        if (header->magic.load(memory_order_acquire) == EVENT_RING_MAGIC) {
+            break;
+        }
+        usleep(1000);
+    }
+
+    bool is_valid = false;
+    if (wait_ms == RAM_BUFFER_ATTACH_TIMEOUT_MS) {
+        err_msg << "not initialized by its creator.";
+    } else if (header->version != EVENT_RING_VERSION) {
+        err_msg << "has version " << header->version;
+        err_msg << ", expected " << EVENT_RING_VERSION << ".";
+    } else if (header->event_bytes != event_bytes_ ||
+               (int) header->n_slots != n_slots_ ||
+               header->slot_bytes != slot_bytes_) {
+        err_msg << "has " << header->n_slots << " events of ";
+        err_msg << header->event_bytes << " bytes, expected " << n_slots_;
+        err_msg << " events of " << event_bytes_ << " bytes.";
+    } else {
+        is_valid = true;
+    }
+
+    munmap(header, header_bytes);
+
+    if (!is_valid) {
+        close(shm_fd_);
+        throw runtime_error(err_msg.str());
+    }
+}
+
+bool EventRing::lock_consumer(const EventRingConsumer& consumer,
+                              const short type)
+{
+    auto lock = get_consumer_lock(header_, consumer, type);
+    return fcntl(shm_fd_, F_OFD_SETLK, &lock) == 0;
+}
+
+bool EventRing::is_consumer_alive(const EventRingConsumer& consumer) const
+{
+    // Our own lock does not conflict with us.
+    if (&consumer == consumer_) {
+        return true;
+    }
+
+    auto lock = get_consumer_lock(header_, consumer, F_WRLCK);
+    if (fcntl(shm_fd_, F_OFD_GETLK, &lock) != 0) {
+        return false;
+    }
+
+    return lock.l_type != F_UNLCK;
+}
+
+void EventRing::register_consumer()
+{
+    // Free entry, or left by a process that died.
+    for (auto& consumer : header_->consumers) {
+        if (lock_consumer(consumer, F_WRLCK)) {
+            consumer_ = &consumer;
+            break;
+        }
+    }
+
+    if (consumer_ == nullptr) {
+        stringstream err_msg;
+        err_msg << "[EventRing::register_consumer] Ring " << shm_name_;
+        err_msg << " has already " << EVENT_RING_MAX_CONSUMERS;
+        err_msg << " consumers.";
+        munmap(buffer_, buffer_bytes_);
+        close(shm_fd_);
+        throw runtime_error(err_msg.str());
+    }
+
+    cursor_ = header_->write_index.load(memory_order_acquire);
+    consumer_->cursor.store(cursor_, memory_order_relaxed);
+    consumer_->n_dropped.store(0, memory_order_relaxed);
+}
+
+char* EventRing::get_slot(const uint64_t index) const
+{
+    return slots_ + ((index % n_slots_) * slot_bytes_);
+}
+
+atomic<uint64_t>& EventRing::get_slot_seq(const uint64_t index) const
+{
+    return *(atomic<uint64_t>*) get_slot(index);
+}
+
+void EventRing::send(const void* event)
+{
+    // Only this process writes, the index does not change under us.
+    const auto index = header_->write_index.load(memory_order_relaxed);
+    auto& seq = get_slot_seq(index);
+
+    seq.store((2 * index) + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    memcpy(get_slot(index) + sizeof(uint64_t), event, event_bytes_);
+    seq.store((2 * index) + 2, memory_order_release);
+
+    header_->write_index.store(index + 1, memory_order_release);
+
+    // Pairs with the n_waiters increment before the futex value is read.
+    header_->futex_word.fetch_add(1, memory_order_seq_cst);
+    if (header_->n_waiters.load(memory_order_seq_cst) > 0) {
+        futex(&header_->futex_word, FUTEX_WAKE, INT_MAX, nullptr);
+    }
+}
+
+void EventRing::drop(const uint64_t n_events)
+{
+    n_dropped_ += n_events;
+    consumer_->n_dropped.store(n_dropped_, memory_order_relaxed);
+}
+
+bool EventRing::wait(const uint64_t write_index, const int timeout_ms)
+{
+    for (int i = 0; i < EVENT_RING_SPIN_COUNT; i++) {
+        if (header_->write_index.load(memory_order_acquire) != write_index) {
+            return true;
+        }
+        this_thread::yield();
+    }
+
+    header_->n_waiters.fetch_add(1, memory_order_seq_cst);
+    const auto futex_value =
+            header_->futex_word.load(memory_order_seq_cst);
+
+    bool is_timeout = false;
+    if (header_->write_index.load(memory_order_seq_cst) == write_index) {
+        timespec timeout = {timeout_ms / 1000, (timeout_ms % 1000) * 1000000L};
+
+        const auto result = futex(&header_->futex_word, FUTEX_WAIT,
+                                  futex_value,
+                                  timeout_ms >= 0 ? &timeout : nullptr);
+        is_timeout = result == -1 && errno == ETIMEDOUT;
+    }
+
+    header_->n_waiters.fetch_sub(1, memory_order_seq_cst);
+
+    return !is_timeout;
+}
+
+bool EventRing::recv(void* event, const int timeout_ms)
+{
+    while (true) {
+        const auto write_index =
+                header_->write_index.load(memory_order_acquire);
+
+        if (cursor_ == write_index) {
+            if (!wait(write_index, timeout_ms)) {
+                return false;
+            }
+            continue;
+        }
+
+        // Events older than the ring are gone.
+        if (write_index - cursor_ > (uint64_t) n_slots_) {
+            drop(write_index - n_slots_ - cursor_);
+            cursor_ = write_index - n_slots_;
+        }
+
+        const auto& seq = get_slot_seq(cursor_);
+        const auto expected_seq = (2 * cursor_) + 2;
+
+        bool is_valid = seq.load(memory_order_acquire) == expected_seq;
+        if (is_valid) {
+            memcpy(event, get_slot(cursor_) + sizeof(uint64_t), event_bytes_);
+            atomic_thread_fence(memory_order_acquire);
+            is_valid = seq.load(memory_order_relaxed) == expected_seq;
+        }
+
+        cursor_++;
+        consumer_->cursor.store(cursor_, memory_order_relaxed);
+
+        // Overwritten before or during the copy.
+        if (!is_valid) {
+            drop(1);
+            continue;
+        }
+
+        return true;
+    }
+}
+
+uint64_t EventRing::get_n_dropped() const
+{
+    return n_dropped_;
+}
+
+uint64_t EventRing::get_lag() const
+{
+    return header_->write_index.load(memory_order_acquire) - cursor_;
+}
+
+uint64_t EventRing::get_max_lag() const
+{
+    const auto write_index = header_->write_index.load(memory_order_acquire);
+    uint64_t max_lag = 0;
+
+    for (const auto& consumer : header_->consumers) {
+        if (is_consumer_alive(consumer)) {
+            max_lag = max(max_lag, write_index -
+                    consumer.cursor.load(memory_order_relaxed));
+        }
+    }
+
+    return max_lag;
+}
+
+int EventRing::get_n_consumers() const
+{
+    int n_consumers = 0;
+
+    for (const auto& consumer : header_->consumers) {
+        if (is_consumer_alive(consumer)) {
+            n_consumers++;
+        }
+    }
+
+    return n_consumers;
+}
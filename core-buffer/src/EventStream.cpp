@@ -0,0 +1,103 @@
+#include <zmq.h>
+#include <cerrno>
+#include <sstream>
+#include <stdexcept>
+#include "EventStream.hpp"
+
+using namespace std;
+using namespace BufferUtils;
+
+EventSender::EventSender(
+        void* ctx,
+        const string& detector_name,
+        const string& stream_name,
+        const size_t event_bytes,
+        const EventTransport transport) :
+        event_bytes_(event_bytes)
+{
+    if (transport == EventTransport::SHM) {
+        ring_ = make_unique<EventRing>(
+                detector_name, stream_name, event_bytes_, true);
+    } else {
+        socket_ = bind_socket(ctx, detector_name, stream_name);
+    }
+}
+
+EventSender::~EventSender()
+{
+    if (socket_ != nullptr) {
+        zmq_close(socket_);
+    }
+}
+
+void EventSender::send(const void* event)
+{
+    if (ring_) {
+        ring_->send(event);
+    } else {
+        zmq_send(socket_, event, event_bytes_, 0);
+    }
+}
+
+uint64_t EventSender::get_max_lag() const
+{
+    return ring_ ? ring_->get_max_lag() : 0;
+}
+
+EventReceiver::EventReceiver(
+        void* ctx,
+        const string& detector_name,
+        const string& stream_name,
+        const size_t event_bytes,
+        const EventTransport transport) :
+        event_bytes_(event_bytes)
+{
+    if (transport == EventTransport::SHM) {
+        ring_ = make_unique<EventRing>(
+                detector_name, stream_name, event_bytes_, false);
+    } else {
+        socket_ = connect_socket(ctx, detector_name, stream_name);
+    }
+}
+
+EventReceiver::~EventReceiver()
+{
+    if (socket_ != nullptr) {
+        zmq_close(socket_);
+    }
+}
+
+bool EventReceiver::recv(void* event, const int timeout_ms)
+{
+    if (ring_) {
+        return ring_->recv(event, timeout_ms);
+    }
+
+    while (true) {
+        if (timeout_ms >= 0) {
+            zmq_pollitem_t item = {socket_, 0, ZMQ_POLLIN, 0};
+            if (zmq_poll(&item, 1, timeout_ms) <= 0) {
+                return false;
+            }
+        }
+
+        const auto n_bytes = zmq_recv(socket_, event, event_bytes_, 0);
+        if (n_bytes == -1 && zmq_errno() == EINTR) {
+            continue;
+        }
+
+        if (n_bytes != (int) event_bytes_) {
+            stringstream err_msg;
+            err_msg << "[EventReceiver::recv] Received " << n_bytes;
+            err_msg << " bytes, expected " << event_bytes_ << ".";
+            throw runtime_error(err_msg.str());
+        }
+
+        return true;
+    }
+}
+
+uint64_t EventReceiver::get_n_dropped() const
+{
+    return ring_ ? ring_->get_n_dropped() : 0;
+}
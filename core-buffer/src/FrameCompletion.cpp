@@ -0,0 +1,194 @@
+#include <cstring>
+#include <stdexcept>
+#include "FrameCompletion.hpp"
+#include "PacketBitmap.hpp"
+
+using namespace std;
+
+FrameCompletion::FrameCompletion(
+        const vector<uint32_t>& part_packets, const int n_slots) :
+        n_parts_(part_packets.size() - 1),
+        n_slots_(n_slots),
+        part_packets_(part_packets),
+        n_bitmap_words_(PacketBitmap::n_words(part_packets.back())),
+        slot_state_(make_unique<atomic<uint64_t>[]>(n_slots_)),
+        parts_(make_unique<ModuleFrame[]>(n_parts_ * n_slots_)),
+        bitmaps_(make_unique<uint64_t[]>(n_bitmap_words_ * n_slots_))
+{
+    if (n_parts_ < 1 || n_parts_ >= (1 << PART_BITS)) {
+        throw runtime_error("Invalid number of frame parts.");
+    }
+
+    for (int i_part = 0; i_part < n_parts_; i_part++) {
+        if (part_packets_[i_part] % 64 != 0 ||
+            part_packets_[i_part] >= part_packets_[i_part + 1]) {
+            throw runtime_error("Invalid frame part boundaries.");
+        }
+    }
+
+    for (int i_slot = 0; i_slot < n_slots_; i_slot++) {
+        slot_state_[i_slot].store(0, memory_order_relaxed);
+    }
+}
+
+uint64_t* FrameCompletion::get_part_words(
+        const uint64_t frame_index, const int i_part)
+{
+    const size_t slot_n = frame_index % n_slots_;
+
+    return bitmaps_.get() +
+           (n_bitmap_words_ * slot_n) +
+           (part_packets_[i_part] / 64);
+}
+
+bool FrameCompletion::claim_slot(const uint64_t frame_index)
+{
+    auto& state = slot_state_[frame_index % n_slots_];
+    uint64_t current = state.load(memory_order_acquire);
+
+    while (true) {
+        const uint64_t slot_frame_index = current >> PART_BITS;
+
+        if (slot_frame_index == frame_index) {
+            return true;
+        }
+
+        // Late part, the slot already belongs to the next frame in it.
+        if (slot_frame_index > frame_index &&
+            slot_frame_index <= frame_index + n_slots_) {
+            return false;
+        }
+
+        // First part of this frame, or the frame_index restarted.
+        if (state.compare_exchange_weak(
+                current, frame_index << PART_BITS,
+                memory_order_acq_rel, memory_order_acquire)) {
+            newest_frame_index_.store(frame_index, memory_order_relaxed);
+            return true;
+        }
+    }
+}
+
+bool FrameCompletion::count_part(
+        const uint64_t frame_index,
+        ModuleFrame& frame,
+        uint64_t* frame_bitmap)
+{
+    const size_t slot_n = frame_index % n_slots_;
+    auto& state = slot_state_[slot_n];
+
+    uint64_t current = state.load(memory_order_relaxed);
+    uint64_t next;
+
+    do {
+        // A newer frame took the slot while the part was written.
+        if ((current >> PART_BITS) != frame_index) {
+            return false;
+        }
+
+        next = current + 1;
+
+    // Release our part, acquire the parts of the other threads.
+    } while (!state.compare_exchange_weak(
+            current, next, memory_order_acq_rel, memory_order_relaxed));
+
+    if ((next & ((1 << PART_BITS) - 1)) != (uint64_t) n_parts_) {
+        return false;
+    }
+
+    // Last part: merge the metadata of all parts of this frame.
+    const ModuleFrame* slot_parts = parts_.get() + (n_parts_ * slot_n);
+
+    frame.pulse_id = 0;
+    frame.n_recv_packets = 0;
+    frame.module_id = 0;
+
+    for (int i_part = 0; i_part < n_parts_; i_part++) {
+        const auto& part = slot_parts[i_part];
+
+        if (part.frame_index != frame_index || part.n_recv_packets == 0) {
+            continue;
+        }
+
+        if (frame.pulse_id == 0) {
+            frame.pulse_id = part.pulse_id;
+            frame.frame_index = part.frame_index;
+            frame.daq_rec = part.daq_rec;
+        }
+
+        frame.n_recv_packets += part.n_recv_packets;
+    }
+
+    memcpy(frame_bitmap,
+           bitmaps_.get() + (n_bitmap_words_ * slot_n),
+           n_bitmap_words_ * sizeof(uint64_t));
+
+    memcpy(frame.packets_bitmap, frame_bitmap,
+           min(sizeof(frame.packets_bitmap),
+               n_bitmap_words_ * sizeof(uint64_t)));
+
+    return frame.pulse_id != 0;
+}
+
+bool FrameCompletion::add_part(
+        const int i_part,
+        const ModuleFrame& part,
+        const uint64_t* part_bitmap,
+        ModuleFrame& frame,
+        uint64_t* frame_bitmap)
+{
+    if (!claim_slot(part.frame_index)) {
+        return false;
+    }
+
+    const size_t slot_n = part.frame_index % n_slots_;
+    parts_[(n_parts_ * slot_n) + i_part] = part;
+
+    const auto word_begin = part_packets_[i_part] / 64;
+    const auto n_words =
+            PacketBitmap::n_words(part_packets_[i_part + 1]) - word_begin;
+
+    memcpy(get_part_words(part.frame_index, i_part),
+           part_bitmap + word_begin,
+           n_words * sizeof(uint64_t));
+
+    return count_part(part.frame_index, frame, frame_bitmap);
+}
+
+bool FrameCompletion::add_empty_part(
+        const int i_part,
+        const uint64_t frame_index,
+        ModuleFrame& frame,
+        uint64_t* frame_bitmap)
+{
+    if (!claim_slot(frame_index)) {
+        return false;
+    }
+
+    const size_t slot_n = frame_index % n_slots_;
+    auto& part = parts_[(n_parts_ * slot_n) + i_part];
+
+    part.pulse_id = 0;
+    part.frame_index = frame_index;
+    part.n_recv_packets = 0;
+
+    PacketBitmap::clear(get_part_words(frame_index, i_part),
+                        part_packets_[i_part + 1] - part_packets_[i_part]);
+
+    return count_part(frame_index, frame, frame_bitmap);
+}
+
+uint64_t FrameCompletion::get_newest_frame_index() const
+{
+    return newest_frame_index_.load(memory_order_relaxed);
+}
+
+int FrameCompletion::get_n_parts() const
+{
+    return n_parts_;
+}
+
+int FrameCompletion::get_n_slots() const
+{
+    return n_slots_;
+}
@@ -7,10 +7,14 @@ using namespace chrono;
 FrameStats::FrameStats(
         const std::string &detector_name,
         const int module_id,
-        const size_t stats_time) :
+        const uint64_t n_packets_per_frame,
+        const size_t stats_time,
+        const EventSender& sender) :
             detector_name_(detector_name),
             module_id_(module_id),
-            stats_time_(stats_time)
+            n_packets_per_frame_(n_packets_per_frame),
+            stats_time_(stats_time),
+            sender_(sender)
 {
    reset_counters();
 }
@@ -31,8 +35,8 @@ void FrameStats::record_stats(const ModuleFrame &meta, const bool bad_pulse_id)
         n_corrupted_pulse_id_++;
     } 
 
-    if (meta.n_recv_packets < JF_N_PACKETS_PER_FRAME) {
-        n_missed_packets_ += JF_N_PACKETS_PER_FRAME - meta.n_recv_packets;
+    if (meta.n_recv_packets < n_packets_per_frame_) {
+        n_missed_packets_ += n_packets_per_frame_ - meta.n_recv_packets;
         n_corrupted_frames_++;
     }
 
@@ -65,6 +69,7 @@ void FrameStats::print_stats()
     cout << ",n_corrupted_frames=" << n_corrupted_frames_ << "i";
     cout << ",repetition_rate=" << rep_rate << "i";
     cout << ",n_corrupted_pulse_ids=" << n_corrupted_pulse_id_ << "i";
+    cout << ",max_event_lag=" << sender_.get_max_lag() << "i";
     cout << " ";
     cout << timestamp;
     cout << endl;
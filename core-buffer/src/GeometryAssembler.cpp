@@ -0,0 +1,320 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <sstream>
+#include "GeometryAssembler.hpp"
+#include "buffer_config.hpp"
+
+using namespace std;
+using namespace buffer_config;
+using namespace BufferUtils;
+
+GeometryAssembler::GeometryAssembler(
+        const DetectorGeometry& geometry,
+        const int n_modules,
+        const int n_threads) :
+        n_modules_(n_modules),
+        n_threads_(max(1, min(n_threads, n_modules))),
+        gap_(geometry.gap_pixels ? CHIP_GAP_PIXELS : 0),
+        double_pixels_(geometry.double_pixels),
+        module_x_size_(MODULE_X_SIZE + (gap_ * (MODULE_X_SIZE/CHIP_SIZE - 1))),
+        module_y_size_(MODULE_Y_SIZE + (gap_ * (MODULE_Y_SIZE/CHIP_SIZE - 1))),
+        image_x_size_(geometry.image_x_size),
+        image_y_size_(geometry.image_y_size)
+{
+    stringstream err_msg;
+    err_msg << "[GeometryAssembler::GeometryAssembler] ";
+
+    auto modules = geometry.modules;
+    if (modules.empty()) {
+        for (int i_module = 0; i_module < n_modules_; i_module++) {
+            modules.push_back({0, i_module * module_y_size_, 0});
+        }
+    }
+
+    if ((int) modules.size() != n_modules_) {
+        err_msg << "Geometry has " << modules.size() << " modules, ";
+        err_msg << "detector has " << n_modules_ << ".";
+        throw runtime_error(err_msg.str());
+    }
+
+    if (double_pixels_ == DoublePixels::DUPLICATE && gap_ == 0) {
+        err_msg << "Duplicated double pixels need gap pixels.";
+        throw runtime_error(err_msg.str());
+    }
+
+    // Rotated module sizes.
+    vector<int> x_sizes(n_modules_);
+    vector<int> y_sizes(n_modules_);
+
+    for (int i_module = 0; i_module < n_modules_; i_module++) {
+        const auto& module = modules[i_module];
+
+        if (module.rotation < 0 || module.rotation > 3) {
+            err_msg << "Invalid rotation " << module.rotation;
+            err_msg << " of module " << i_module << ".";
+            throw runtime_error(err_msg.str());
+        }
+
+        const bool is_turned = module.rotation % 2 == 1;
+        x_sizes[i_module] = is_turned ? module_y_size_ : module_x_size_;
+        y_sizes[i_module] = is_turned ? module_x_size_ : module_y_size_;
+    }
+
+    if (image_x_size_ == 0 || image_y_size_ == 0) {
+        for (int i_module = 0; i_module < n_modules_; i_module++) {
+            image_x_size_ = max(
+                    image_x_size_, modules[i_module].x + x_sizes[i_module]);
+            image_y_size_ = max(
+                    image_y_size_, modules[i_module].y + y_sizes[i_module]);
+        }
+    }
+
+    const int64_t W = image_x_size_;
+    vector<bool> is_covered(get_image_n_pixels(), false);
+
+    for (int i_module = 0; i_module < n_modules_; i_module++) {
+        const auto& module = modules[i_module];
+
+        if (module.x < 0 || module.y < 0 ||
+            module.x + x_sizes[i_module] > image_x_size_ ||
+            module.y + y_sizes[i_module] > image_y_size_) {
+            err_msg << "Module " << i_module << " at (" << module.x;
+            err_msg << ", " << module.y << ") outside of the ";
+            err_msg << image_x_size_ << "x" << image_y_size_ << " image.";
+            throw runtime_error(err_msg.str());
+        }
+
+        const int64_t mx = module_x_size_;
+        const int64_t my = module_y_size_;
+        const int64_t corner = (module.y * W) + module.x;
+
+        switch (module.rotation) {
+            case 0:
+                placements_.push_back({corner, 1, W});
+                break;
+            case 1:
+                placements_.push_back({corner + my - 1, W, -1});
+                break;
+            case 2:
+                placements_.push_back(
+                        {corner + ((my - 1) * W) + mx - 1, -1, -W});
+                break;
+            default:
+                placements_.push_back({corner + ((mx - 1) * W), -W, 1});
+                break;
+        }
+
+        for (int y = 0; y < y_sizes[i_module]; y++) {
+            const auto row = is_covered.begin() + ((module.y + y) * W) +
+                             module.x;
+
+            if (find(row, row + x_sizes[i_module], true) !=
+                row + x_sizes[i_module]) {
+                err_msg << "Module " << i_module << " overlaps another.";
+                throw runtime_error(err_msg.str());
+            }
+
+            fill_n(row, x_sizes[i_module], true);
+        }
+    }
+
+    is_clear_needed_ =
+            find(is_covered.begin(), is_covered.end(), false) !=
+            is_covered.end();
+
+    for (int i_thread = 1; i_thread < n_threads_; i_thread++) {
+        workers_.emplace_back(&GeometryAssembler::run_worker, this, i_thread);
+    }
+}
+
+GeometryAssembler::~GeometryAssembler()
+{
+    {
+        lock_guard<mutex> lock(job_mutex_);
+        is_stopping_ = true;
+    }
+    job_cv_.notify_all();
+
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+int GeometryAssembler::get_image_x_size() const
+{
+    return image_x_size_;
+}
+
+int GeometryAssembler::get_image_y_size() const
+{
+    return image_y_size_;
+}
+
+size_t GeometryAssembler::get_image_n_pixels() const
+{
+    return (size_t) image_x_size_ * image_y_size_;
+}
+
+void GeometryAssembler::assemble(const char* data, uint16_t* image)
+{
+    if (is_clear_needed_) {
+        memset(image, 0, get_image_n_pixels() * PIXEL_N_BYTES);
+    }
+
+    if (workers_.empty()) {
+        assemble_modules(0, data, image);
+        return;
+    }
+
+    {
+        lock_guard<mutex> lock(job_mutex_);
+        job_data_ = data;
+        job_image_ = image;
+        n_done_workers_ = 0;
+        job_id_++;
+    }
+    job_cv_.notify_all();
+
+    assemble_modules(0, data, image);
+
+    unique_lock<mutex> lock(job_mutex_);
+    done_cv_.wait(lock, [this] {
+        return n_done_workers_ == workers_.size();
+    });
+}
+
+void GeometryAssembler::run_worker(const int i_thread)
+{
+    uint64_t last_job_id = 0;
+
+    while (true) {
+        const char* data;
+        uint16_t* image;
+        {
+            unique_lock<mutex> lock(job_mutex_);
+            job_cv_.wait(lock, [this, last_job_id] {
+                return is_stopping_ || job_id_ != last_job_id;
+            });
+
+            if (is_stopping_) {
+                return;
+            }
+
+            last_job_id = job_id_;
+            data = job_data_;
+            image = job_image_;
+        }
+
+        assemble_modules(i_thread, data, image);
+
+        {
+            lock_guard<mutex> lock(job_mutex_);
+            n_done_workers_++;
+        }
+        done_cv_.notify_one();
+    }
+}
+
+void GeometryAssembler::assemble_modules(
+        const int i_thread, const char* data, uint16_t* image) const
+{
+    for (int i_module = i_thread;
+         i_module < n_modules_;
+         i_module += n_threads_) {
+        assemble_module(i_module, data, image);
+    }
+}
+
+void GeometryAssembler::assemble_module(
+        const int i_module, const char* data, uint16_t* image) const
+{
+    const auto& placement = placements_[i_module];
+    const auto* module = (const uint16_t*) (data + (i_module * MODULE_N_BYTES));
+    const int n_chips_x = MODULE_X_SIZE / CHIP_SIZE;
+
+    for (int y = 0; y < (int) MODULE_Y_SIZE; y++) {
+        const int64_t local_y = y + (gap_ * (y / CHIP_SIZE));
+
+        for (int i_chip = 0; i_chip < n_chips_x; i_chip++) {
+            const int64_t local_x = i_chip * (CHIP_SIZE + gap_);
+            const auto* src =
+                    module + (y * MODULE_X_SIZE) + (i_chip * CHIP_SIZE);
+            auto* dst = image + placement.origin +
+                        (local_x * placement.step_x) +
+                        (local_y * placement.step_y);
+
+            if (placement.step_x == 1) {
+                memcpy(dst, src, CHIP_SIZE * PIXEL_N_BYTES);
+            } else {
+                for (size_t i = 0; i < CHIP_SIZE; i++) {
+                    dst[i * placement.step_x] = src[i];
+                }
+            }
+        }
+    }
+
+    if (gap_ > 0) {
+        fill_gap_pixels(placement, image);
+    }
+
+    if (double_pixels_ == DoublePixels::MASK) {
+        mask_double_pixels(placement, image);
+    }
+}
+
+void GeometryAssembler::fill_gap_pixels(
+        const ModulePlacement& placement, uint16_t* image) const
+{
+    const bool is_duplicate = double_pixels_ == DoublePixels::DUPLICATE;
+    const int n_chips_x = MODULE_X_SIZE / CHIP_SIZE;
+
+    auto pixel = [&](const int64_t x, const int64_t y) -> uint16_t& {
+        return image[placement.origin +
+                     (x * placement.step_x) + (y * placement.step_y)];
+    };
+
+    // Gap columns of the chip rows, from the pixel on their side.
+    for (int y = 0; y < module_y_size_; y++) {
+        if (y >= (int) CHIP_SIZE && y < (int) CHIP_SIZE + gap_) {
+            continue;
+        }
+
+        for (int i_chip = 0; i_chip < n_chips_x - 1; i_chip++) {
+            const int64_t x = (i_chip * (CHIP_SIZE + gap_)) + CHIP_SIZE;
+            pixel(x, y) = is_duplicate ? pixel(x - 1, y) : 0;
+            pixel(x + 1, y) = is_duplicate ? pixel(x + 2, y) : 0;
+        }
+    }
+
+    // Gap rows, from the row on their side.
+    for (int x = 0; x < module_x_size_; x++) {
+        const int64_t y = CHIP_SIZE;
+        pixel(x, y) = is_duplicate ? pixel(x, y - 1) : 0;
+        pixel(x, y + 1) = is_duplicate ? pixel(x, y + 2) : 0;
+    }
+}
+
+void GeometryAssembler::mask_double_pixels(
+        const ModulePlacement& placement, uint16_t* image) const
+{
+    const int n_chips_x = MODULE_X_SIZE / CHIP_SIZE;
+
+    auto pixel = [&](const int64_t x, const int64_t y) -> uint16_t& {
+        return image[placement.origin +
+                     (x * placement.step_x) + (y * placement.step_y)];
+    };
+
+    for (int y = 0; y < module_y_size_; y++) {
+        for (int i_chip = 1; i_chip < n_chips_x; i_chip++) {
+            const int64_t x = i_chip * (CHIP_SIZE + gap_);
+            pixel(x - gap_ - 1, y) = 0;
+            pixel(x, y) = 0;
+        }
+    }
+
+    for (int x = 0; x < module_x_size_; x++) {
+        pixel(x, CHIP_SIZE - 1) = 0;
+        pixel(x, CHIP_SIZE + gap_) = 0;
+    }
+}
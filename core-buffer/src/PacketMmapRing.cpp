@@ -0,0 +1,275 @@
+#include "PacketMmapRing.hpp"
+
+#include <arpa/inet.h>
+#include <cstring>
+#include <linux/filter.h>
+#include <linux/if_packet.h>
+#include <net/ethernet.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace buffer_config;
+
+namespace {
+    // Copy the packet payload into the iovecs of the message.
+    size_t scatter_to_msg(const char* src, const size_t n_bytes, msghdr& msg)
+    {
+        size_t n_copied = 0;
+
+        for (size_t i = 0; i < msg.msg_iovlen && n_copied < n_bytes; i++) {
+            auto n_iov_bytes = min(msg.msg_iov[i].iov_len, n_bytes - n_copied);
+            memcpy(msg.msg_iov[i].iov_base, src + n_copied, n_iov_bytes);
+            n_copied += n_iov_bytes;
+        }
+
+        return n_copied;
+    }
+
+    // Same control message as a socket with SO_TIMESTAMPNS.
+    void set_timestamp_cmsg(const tpacket3_hdr* packet, msghdr& msg)
+    {
+        if (msg.msg_control == nullptr ||
+            msg.msg_controllen < CMSG_SPACE(sizeof(timespec))) {
+            msg.msg_controllen = 0;
+            return;
+        }
+
+        auto cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_TIMESTAMPNS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(timespec));
+
+        timespec packet_time = {};
+        packet_time.tv_sec = packet->tp_sec;
+        packet_time.tv_nsec = packet->tp_nsec;
+        memcpy(CMSG_DATA(cmsg), &packet_time, sizeof(timespec));
+
+        msg.msg_controllen = CMSG_SPACE(sizeof(timespec));
+    }
+}
+
+PacketMmapRing::PacketMmapRing(
+        const uint16_t port,
+        const string& interface_name,
+        const unsigned int n_blocks) :
+            port_(port),
+            n_blocks_(n_blocks),
+            ring_bytes_((size_t) BUFFER_PACKET_MMAP_BLOCK_BYTES * n_blocks)
+{
+    // Protocol 0 - do not receive anything until the filter is in place.
+    socket_fd_ = socket(AF_PACKET, SOCK_DGRAM, 0);
+    if (socket_fd_ < 0) {
+        throw runtime_error(
+                "Cannot open packet socket. " + string(strerror(errno)));
+    }
+
+    int version = TPACKET_V3;
+    if (setsockopt(socket_fd_, SOL_PACKET, PACKET_VERSION,
+                   &version, sizeof(version)) == -1) {
+        throw runtime_error(
+                "Cannot set PACKET_VERSION. " + string(strerror(errno)));
+    }
+
+    tpacket_req3 ring_request = {};
+    ring_request.tp_block_size = BUFFER_PACKET_MMAP_BLOCK_BYTES;
+    ring_request.tp_block_nr = n_blocks_;
+    ring_request.tp_frame_size = BUFFER_PACKET_MMAP_FRAME_BYTES;
+    ring_request.tp_frame_nr = n_blocks_ *
+            (BUFFER_PACKET_MMAP_BLOCK_BYTES / BUFFER_PACKET_MMAP_FRAME_BYTES);
+    ring_request.tp_retire_blk_tov = BUFFER_PACKET_MMAP_BLOCK_TIMEOUT_MS;
+
+    if (setsockopt(socket_fd_, SOL_PACKET, PACKET_RX_RING,
+                   &ring_request, sizeof(ring_request)) == -1) {
+        throw runtime_error(
+                "Cannot set PACKET_RX_RING. " + string(strerror(errno)));
+    }
+
+    ring_ = (char*) mmap(nullptr, ring_bytes_, PROT_READ | PROT_WRITE,
+                         MAP_SHARED, socket_fd_, 0);
+    if (ring_ == MAP_FAILED) {
+        throw runtime_error(
+                "Cannot mmap packet ring. " + string(strerror(errno)));
+    }
+
+    attach_port_filter();
+
+    sockaddr_ll ring_address = {};
+    ring_address.sll_family = AF_PACKET;
+    ring_address.sll_protocol = htons(ETH_P_IP);
+    // Index 0 means all interfaces.
+    ring_address.sll_ifindex = 0;
+
+    if (!interface_name.empty()) {
+        ring_address.sll_ifindex = if_nametoindex(interface_name.c_str());
+        if (ring_address.sll_ifindex == 0) {
+            throw runtime_error("Unknown interface " + interface_name);
+        }
+    }
+
+    if (::bind(socket_fd_, reinterpret_cast<const sockaddr *>(&ring_address),
+               sizeof(ring_address)) < 0) {
+        throw runtime_error(
+                "Cannot bind packet socket. " + string(strerror(errno)));
+    }
+}
+
+PacketMmapRing::~PacketMmapRing()
+{
+    munmap(ring_, ring_bytes_);
+    close(socket_fd_);
+}
+
+void PacketMmapRing::attach_port_filter()
+{
+    // Accept only non fragmented UDP packets for our port. With SOCK_DGRAM
+    // the filter offsets start at the IP header.
+    sock_filter port_filter[] = {
+        // IP protocol == UDP
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 9),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_UDP, 0, 6),
+        // No fragment offset
+        BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 6),
+        BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, 0x1fff, 4, 0),
+        // UDP destination port == port_
+        BPF_STMT(BPF_LDX | BPF_B | BPF_MSH, 0),
+        BPF_STMT(BPF_LD | BPF_H | BPF_IND, 2),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, port_, 0, 1),
+        BPF_STMT(BPF_RET | BPF_K, 0x40000),
+        BPF_STMT(BPF_RET | BPF_K, 0),
+    };
+
+    sock_fprog filter_program = {};
+    filter_program.len = sizeof(port_filter) / sizeof(port_filter[0]);
+    filter_program.filter = port_filter;
+
+    if (setsockopt(socket_fd_, SOL_SOCKET, SO_ATTACH_FILTER,
+                   &filter_program, sizeof(filter_program)) == -1) {
+        throw runtime_error(
+                "Cannot set SO_ATTACH_FILTER. " + string(strerror(errno)));
+    }
+}
+
+bool PacketMmapRing::wait_for_block(const int timeout_us)
+{
+    auto block = (tpacket_block_desc*) (
+            ring_ + ((size_t) BUFFER_PACKET_MMAP_BLOCK_BYTES * i_block_));
+
+    auto block_status = __atomic_load_n(
+            &block->hdr.bh1.block_status, __ATOMIC_ACQUIRE);
+
+    if (block_status & TP_STATUS_USER) {
+        return true;
+    }
+
+    pollfd socket_poll = {};
+    socket_poll.fd = socket_fd_;
+    socket_poll.events = POLLIN | POLLERR;
+
+    timespec poll_timeout = {};
+    poll_timeout.tv_sec = timeout_us / 1000000;
+    poll_timeout.tv_nsec = (timeout_us % 1000000) * 1000;
+
+    ppoll(&socket_poll, 1, &poll_timeout, nullptr);
+
+    block_status = __atomic_load_n(
+            &block->hdr.bh1.block_status, __ATOMIC_ACQUIRE);
+
+    return (block_status & TP_STATUS_USER) != 0;
+}
+
+void PacketMmapRing::release_block()
+{
+    auto block = (tpacket_block_desc*) (
+            ring_ + ((size_t) BUFFER_PACKET_MMAP_BLOCK_BYTES * i_block_));
+
+    __atomic_store_n(
+            &block->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+
+    i_block_ = (i_block_ + 1) % n_blocks_;
+    next_packet_ = nullptr;
+}
+
+int PacketMmapRing::get_fd() const
+{
+    return socket_fd_;
+}
+
+int PacketMmapRing::receive_many(
+        mmsghdr* msgs, const size_t n_msgs, const int flags)
+{
+    size_t n_received = 0;
+
+    while (n_received < n_msgs) {
+
+        if (next_packet_ == nullptr) {
+            // Wait only if we have nothing to return yet.
+            const bool wait = n_received == 0 && !(flags & MSG_DONTWAIT);
+            const int timeout_us = wait ? BUFFER_UDP_US_TIMEOUT : 0;
+            if (!wait_for_block(timeout_us)) {
+                break;
+            }
+
+            auto block = (tpacket_block_desc*) (
+                    ring_ + ((size_t) BUFFER_PACKET_MMAP_BLOCK_BYTES * i_block_));
+
+            next_packet_ = (char*) block + block->hdr.bh1.offset_to_first_pkt;
+            n_block_packets_left_ = block->hdr.bh1.num_pkts;
+        }
+
+        while (n_block_packets_left_ > 0 && n_received < n_msgs) {
+            auto packet = (tpacket3_hdr*) next_packet_;
+            auto link_address = (sockaddr_ll*) (
+                    next_packet_ + TPACKET_ALIGN(sizeof(tpacket3_hdr)));
+
+            next_packet_ += packet->tp_next_offset;
+            n_block_packets_left_--;
+
+            // On loopback we also see our own outgoing packets.
+            if (link_address->sll_pkttype == PACKET_OUTGOING) {
+                continue;
+            }
+
+            const char* ip_header = (char*) packet + packet->tp_net;
+            const size_t ip_n_bytes =
+                    packet->tp_snaplen - (packet->tp_net - packet->tp_mac);
+            const size_t ip_header_n_bytes = (ip_header[0] & 0x0f) * 4;
+
+            const char* udp_header = ip_header + ip_header_n_bytes;
+            uint16_t udp_n_bytes;
+            memcpy(&udp_n_bytes, udp_header + 4, sizeof(udp_n_bytes));
+
+            size_t payload_n_bytes = ntohs(udp_n_bytes) - 8;
+            payload_n_bytes = min(
+                    payload_n_bytes, ip_n_bytes - ip_header_n_bytes - 8);
+
+            auto& msg = msgs[n_received];
+            msg.msg_len = scatter_to_msg(
+                    udp_header + 8, payload_n_bytes, msg.msg_hdr);
+
+            set_timestamp_cmsg(packet, msg.msg_hdr);
+
+            if (msg.msg_hdr.msg_name != nullptr &&
+                msg.msg_hdr.msg_namelen >= sizeof(sockaddr_in)) {
+
+                auto from = (sockaddr_in*) msg.msg_hdr.msg_name;
+                from->sin_family = AF_INET;
+                memcpy(&from->sin_addr, ip_header + 12, sizeof(in_addr));
+                memcpy(&from->sin_port, udp_header, sizeof(uint16_t));
+                msg.msg_hdr.msg_namelen = sizeof(sockaddr_in);
+            }
+
+            n_received++;
+        }
+
+        if (n_block_packets_left_ == 0) {
+            release_block();
+        }
+    }
+
+    return n_received > 0 ? n_received : -1;
+}
@@ -0,0 +1,213 @@
+#include <netinet/in.h>
+#include <iostream>
+#include "PacketUdpReceiver.hpp"
+#include "jungfrau.hpp"
+#include <unistd.h>
+#include <cstring>
+#include <chrono>
+#include "buffer_config.hpp"
+
+// Available since Linux 5.11.
+#ifndef SO_PREFER_BUSY_POLL
+#define SO_PREFER_BUSY_POLL 69
+#endif
+
+using namespace std;
+using namespace chrono;
+using namespace buffer_config;
+
+PacketUdpReceiver::PacketUdpReceiver() :
+    socket_fd_(-1)
+{
+}
+
+PacketUdpReceiver::~PacketUdpReceiver()
+{
+    disconnect();
+}
+
+void PacketUdpReceiver::bind(
+        const uint16_t port,
+        const BufferUtils::UdpRecvBackend backend,
+        const string& interface_name,
+        const int busy_poll_us,
+        const bool reuseport)
+{
+    if (socket_fd_ > -1) {
+        throw runtime_error("Socket already bound.");
+    }
+
+    if (reuseport && backend == BufferUtils::UdpRecvBackend::PACKET_MMAP) {
+        throw runtime_error("SO_REUSEPORT needs the recvmmsg backend.");
+    }
+
+    socket_fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+    if (socket_fd_ < 0) {
+        throw runtime_error("Cannot open socket.");
+    }
+
+    sockaddr_in server_address = {0};
+    server_address.sin_family = AF_INET;
+    server_address.sin_addr.s_addr = INADDR_ANY;
+    server_address.sin_port = htons(port);
+
+    timeval udp_socket_timeout;
+    udp_socket_timeout.tv_sec = 0;
+    udp_socket_timeout.tv_usec = BUFFER_UDP_US_TIMEOUT;
+
+    if (setsockopt(socket_fd_, SOL_SOCKET, SO_RCVTIMEO,
+            &udp_socket_timeout, sizeof(timeval)) == -1) {
+        throw runtime_error(
+                "Cannot set SO_RCVTIMEO. " + string(strerror(errno)));
+    }
+
+    // The port is only reserved when packets come from the ring.
+    const int rcvbuf_bytes =
+            (backend == BufferUtils::UdpRecvBackend::PACKET_MMAP) ?
+            0 : BUFFER_UDP_RCVBUF_BYTES;
+
+    if (setsockopt(socket_fd_, SOL_SOCKET, SO_RCVBUF,
+                   &rcvbuf_bytes, sizeof(int)) == -1) {
+        throw runtime_error(
+                "Cannot set SO_RCVBUF. " + string(strerror(errno)));
+    };
+    //TODO: try to set SO_RCVLOWAT
+
+    // Packets of the port are spread over all sockets of the group.
+    const int enable_reuseport = 1;
+    if (reuseport && setsockopt(socket_fd_, SOL_SOCKET, SO_REUSEPORT,
+                                &enable_reuseport, sizeof(int)) == -1) {
+        throw runtime_error(
+                "Cannot set SO_REUSEPORT. " + string(strerror(errno)));
+    }
+
+    auto bind_result = ::bind(
+            socket_fd_,
+            reinterpret_cast<const sockaddr *>(&server_address),
+            sizeof(server_address));
+
+    if (bind_result < 0) {
+        throw runtime_error("Cannot bind socket.");
+    }
+
+    if (backend == BufferUtils::UdpRecvBackend::PACKET_MMAP) {
+        ring_ = make_unique<PacketMmapRing>(port, interface_name);
+    }
+
+    if (busy_poll_us > 0) {
+        set_busy_poll(busy_poll_us);
+    }
+}
+
+void PacketUdpReceiver::set_busy_poll(const int busy_poll_us)
+{
+    // Poll the NIC queue from the receiving socket.
+    if (setsockopt(get_fd(), SOL_SOCKET, SO_BUSY_POLL,
+                   &busy_poll_us, sizeof(int)) == -1) {
+        throw runtime_error(
+                "Cannot set SO_BUSY_POLL. " + string(strerror(errno)));
+    }
+
+    // Older kernels still busy poll, only without deferring the interrupts.
+    const int prefer_busy_poll = 1;
+    if (setsockopt(get_fd(), SOL_SOCKET, SO_PREFER_BUSY_POLL,
+                   &prefer_busy_poll, sizeof(int)) == -1) {
+        cerr << "[PacketUdpReceiver::set_busy_poll] Cannot set ";
+        cerr << "SO_PREFER_BUSY_POLL, continue with SO_BUSY_POLL only: ";
+        cerr << strerror(errno) << endl;
+    }
+
+    busy_poll_ = true;
+}
+
+void PacketUdpReceiver::enable_timestamps()
+{
+    // The ring always has the timestamp in the packet header.
+    if (ring_) {
+        return;
+    }
+
+    const int enable = 1;
+    if (setsockopt(socket_fd_, SOL_SOCKET, SO_TIMESTAMPNS,
+                   &enable, sizeof(int)) == -1) {
+        throw runtime_error(
+                "Cannot set SO_TIMESTAMPNS. " + string(strerror(errno)));
+    }
+}
+
+int PacketUdpReceiver::receive_many(
+        mmsghdr* msgs, const size_t n_msgs, const int flags)
+{
+    if (!busy_poll_ || (flags & MSG_DONTWAIT)) {
+        return receive_batch(msgs, n_msgs, flags);
+    }
+
+    // Spin up to the usual receive timeout to keep the same semantic.
+    const auto spin_start = steady_clock::now();
+
+    do {
+        auto n_recv_msgs = receive_batch(msgs, n_msgs, flags | MSG_DONTWAIT);
+
+        if (n_recv_msgs > 0) {
+            return n_recv_msgs;
+        }
+
+    } while (steady_clock::now() - spin_start <
+             microseconds(BUFFER_UDP_US_TIMEOUT));
+
+    return -1;
+}
+
+int PacketUdpReceiver::receive_batch(
+        mmsghdr* msgs, const size_t n_msgs, const int flags)
+{
+    if (ring_) {
+        return ring_->receive_many(msgs, n_msgs, flags);
+    }
+
+    return recvmmsg(socket_fd_, msgs, n_msgs, flags, 0);
+}
+
+bool PacketUdpReceiver::receive(void* buffer, const size_t buffer_n_bytes)
+{
+    if (ring_) {
+        iovec recv_buff_ptr = {buffer, buffer_n_bytes};
+        mmsghdr msg = {};
+        msg.msg_hdr.msg_iov = &recv_buff_ptr;
+        msg.msg_hdr.msg_iovlen = 1;
+
+        if (ring_->receive_many(&msg, 1) < 1) {
+            return false;
+        }
+
+        return msg.msg_len == buffer_n_bytes;
+    }
+
+    auto data_len = recv(socket_fd_, buffer, buffer_n_bytes, 0);
+
+    if (data_len < 0) {
+        return false;
+    }
+
+    if (data_len != buffer_n_bytes) {
+        return false;
+    }
+
+    return true;
+}
+
+void PacketUdpReceiver::disconnect()
+{
+    ring_.reset();
+    close(socket_fd_);
+    socket_fd_ = -1;
+}
+
+int PacketUdpReceiver::get_fd() const
+{
+    if (ring_) {
+        return ring_->get_fd();
+    }
+
+    return socket_fd_;
+}
@@ -0,0 +1,125 @@
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+#include <unistd.h>
+#include "PulseTracer.hpp"
+
+using namespace std;
+using namespace buffer_config;
+
+PulseTracer::PulseTracer(
+        const string& detector_name,
+        const bool enabled,
+        const int n_slots) :
+            shm_name_(detector_name + PULSE_TRACE_SHM_SUFFIX),
+            n_slots_(n_slots),
+            buffer_bytes_(sizeof(PulseTrace) * n_slots_)
+{
+    if (!enabled) {
+        return;
+    }
+
+    shm_fd_ = shm_open(shm_name_.c_str(), O_RDWR | O_CREAT, 0777);
+    if (shm_fd_ < 0) {
+        throw runtime_error(strerror(errno));
+    }
+
+    if ((ftruncate(shm_fd_, buffer_bytes_)) == -1) {
+        throw runtime_error(strerror(errno));
+    }
+
+    auto buffer = mmap(NULL, buffer_bytes_, PROT_READ | PROT_WRITE,
+                       MAP_SHARED, shm_fd_, 0);
+    if (buffer == MAP_FAILED) {
+        throw runtime_error(strerror(errno));
+    }
+
+    trace_buffer_ = (PulseTrace*) buffer;
+}
+
+PulseTracer::~PulseTracer()
+{
+    if (trace_buffer_ == nullptr) {
+        return;
+    }
+
+    munmap(trace_buffer_, buffer_bytes_);
+    close(shm_fd_);
+}
+
+void PulseTracer::remove(const string& detector_name)
+{
+    shm_unlink((detector_name + PULSE_TRACE_SHM_SUFFIX).c_str());
+}
+
+bool PulseTracer::is_enabled() const
+{
+    return trace_buffer_ != nullptr;
+}
+
+void PulseTracer::record(
+        const TraceStage stage,
+        const uint64_t pulse_id,
+        const uint64_t time_ns,
+        const int module_id) const
+{
+    if (trace_buffer_ == nullptr) {
+        return;
+    }
+
+    auto& trace = trace_buffer_[pulse_id % n_slots_];
+    TracePoint* point = nullptr;
+
+    switch (stage) {
+        case TraceStage::MODULE_RECV:
+            point = &trace.module_recv[module_id];
+            break;
+        case TraceStage::MODULE_COMMIT:
+            point = &trace.module_commit[module_id];
+            break;
+        case TraceStage::ASSEMBLER_EMIT:
+            point = &trace.assembler_emit;
+            break;
+        case TraceStage::STREAM_SEND:
+            point = &trace.stream_send;
+            break;
+        case TraceStage::WRITER_WRITE:
+            point = &trace.writer_write;
+            break;
+    }
+
+    point->pulse_id = pulse_id;
+    point->time_ns = time_ns;
+}
+
+void PulseTracer::record_now(
+        const TraceStage stage,
+        const uint64_t pulse_id,
+        const int module_id) const
+{
+    if (trace_buffer_ == nullptr) {
+        return;
+    }
+
+    record(stage, pulse_id, now_ns(), module_id);
+}
+
+const PulseTrace& PulseTracer::get_trace(const uint64_t pulse_id) const
+{
+    if (trace_buffer_ == nullptr) {
+        throw runtime_error("[PulseTracer::get_trace] Tracing not enabled.");
+    }
+
+    return trace_buffer_[pulse_id % n_slots_];
+}
+
+uint64_t PulseTracer::now_ns()
+{
+    // Same clock as the SO_TIMESTAMPNS kernel timestamps.
+    timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    return (now.tv_sec * 1000000000ULL) + now.tv_nsec;
+}
@@ -1,52 +1,467 @@
 #include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/vfs.h>
+#include <linux/magic.h>
 #include <fcntl.h>
 #include <cstring>
+#include <ctime>
 #include <stdexcept>
 #include <sstream>
+#include <iostream>
 #include <unistd.h>
 #include "RamBuffer.hpp"
 #include "buffer_config.hpp"
 
+// Available since Linux 5.14.
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23
+#endif
+
+// From numaif.h, without linking libnuma.
+#ifndef MPOL_BIND
+#define MPOL_BIND 2
+#endif
+#ifndef MPOL_MF_MOVE
+#define MPOL_MF_MOVE (1 << 1)
+#endif
+
 using namespace std;
 using namespace buffer_config;
 
+static_assert(atomic<uint64_t>::is_always_lock_free,
+              "RamBuffer generations are shared between processes.");
+
 RamBuffer::RamBuffer(
         const string &detector_name,
         const int n_modules,
-        const int n_slots) :
+        const int n_slots,
+        const BufferUtils::RamBufferOptions& options) :
         detector_name_(detector_name),
         n_modules_(n_modules),
-        n_slots_(n_slots),
         meta_bytes_(sizeof(ModuleFrame) * n_modules_),
         image_bytes_(MODULE_N_BYTES * n_modules_),
-        buffer_bytes_((meta_bytes_ + image_bytes_) * n_slots_)
+        numa_nodes_(options.numa_nodes),
+        // 8 values of 8 bytes per cache line.
+        meta_stride_(((n_modules_ + 7) / 8) * 8)
+{
+    if (!numa_nodes_.empty() && (int) numa_nodes_.size() != n_modules_) {
+        throw runtime_error("RamBuffer numa_nodes must have one node "
+                            "per module.");
+    }
+
+    for (const auto node : numa_nodes_) {
+        if (node < 0 || node >= 64) {
+            throw runtime_error("Invalid RamBuffer NUMA node.");
+        }
+    }
+
+    set_layout(n_slots);
+
+    if (options.pages != BufferUtils::RamBufferPages::HUGETLBFS ||
+        !map_hugetlbfs(options)) {
+        map_shm(options);
+    }
+
+    header_ = (RamBufferHeader *) buffer_;
+    // Metadata buffer is located right after the header.
+    meta_buffer_ = (ModuleFrame *) ((char*)buffer_ + RAM_BUFFER_HEADER_BYTES);
+    module_meta_buffer_ = (uint64_t *) ((char*)buffer_ + module_meta_offset_);
+    // Image buffer starts after the metadata buffer, page aligned.
+    image_buffer_ = (char*)buffer_ + image_offset_;
+
+    if (is_creator_) {
+        init_header();
+    }
+
+    // Pages must be bound before they are first touched.
+    const bool is_thp =
+            options.pages == BufferUtils::RamBufferPages::TRANSPARENT_HUGE;
+
+    if (!numa_nodes_.empty()) {
+        bind_numa_nodes();
+    }
+
+    if (options.populate && (is_thp || !numa_nodes_.empty()) &&
+        madvise(buffer_, mapped_bytes_, MADV_POPULATE_WRITE) != 0) {
+        cerr << "[RamBuffer::RamBuffer] Cannot madvise MADV_POPULATE_WRITE, ";
+        cerr << "continue without populate: " << strerror(errno) << endl;
+    }
+
+    if (options.lock) {
+        if (mlock(buffer_, mapped_bytes_) == 0) {
+            is_locked_ = true;
+        } else {
+            cerr << "[RamBuffer::RamBuffer] Cannot mlock, ";
+            cerr << "continue unlocked: " << strerror(errno) << endl;
+        }
+    }
+}
+
+void RamBuffer::set_layout(const int n_slots)
+{
+    n_slots_ = n_slots;
+
+    // Header, metadata of all slots, cache line aligned module metadata
+    // arrays and generations, page aligned images.
+    const size_t meta_end = RAM_BUFFER_HEADER_BYTES + (meta_bytes_ * n_slots_);
+    module_meta_offset_ = ((meta_end + 63) / 64) * 64;
+
+    const size_t module_meta_end = module_meta_offset_ +
+            (sizeof(uint64_t) * N_META_FIELDS * meta_stride_ * n_slots_);
+    image_offset_ = ((module_meta_end + RAM_BUFFER_IMAGE_ALIGNMENT - 1) /
+                     RAM_BUFFER_IMAGE_ALIGNMENT) * RAM_BUFFER_IMAGE_ALIGNMENT;
+    buffer_bytes_ = image_offset_ + (image_bytes_ * n_slots_);
+}
+
+void RamBuffer::init_header()
+{
+    header_->version = RAM_BUFFER_VERSION;
+    header_->n_modules = n_modules_;
+    header_->n_slots = n_slots_;
+    header_->bits_per_pixel = PIXEL_N_BYTES * 8;
+    header_->frame_meta_bytes = sizeof(ModuleFrame);
+    header_->frame_data_bytes = MODULE_N_BYTES;
+    header_->meta_offset = RAM_BUFFER_HEADER_BYTES;
+    header_->module_meta_offset = module_meta_offset_;
+    header_->image_offset = image_offset_;
+    header_->buffer_bytes = buffer_bytes_;
+
+    timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    header_->created_ns = (now.tv_sec * 1000000000ULL) + now.tv_nsec;
+
+    // Attaching processes wait for the magic to read the header.
+    header_->magic.store(RAM_BUFFER_MAGIC, memory_order_release);
+}
+
+void RamBuffer::attach_layout()
+{
+    stringstream err_msg;
+    err_msg << "[RamBuffer::attach_layout] Buffer " << detector_name_ << " ";
+
+    // The creator first sizes the buffer, then writes the header.
+    struct stat fd_stats = {};
+    int wait_ms = 0;
+    for (; wait_ms < RAM_BUFFER_ATTACH_TIMEOUT_MS; wait_ms++) {
+        if (fstat(shm_fd_, &fd_stats) == 0 &&
+            (size_t) fd_stats.st_size >= page_bytes_) {
+            break;
+        }
+        usleep(1000);
+    }
+
+    auto header = (RamBufferHeader *) mmap(
+            NULL, page_bytes_, PROT_READ, MAP_SHARED, shm_fd_, 0);
+
+    if (wait_ms == RAM_BUFFER_ATTACH_TIMEOUT_MS || header == MAP_FAILED) {
+        close(shm_fd_);
+        err_msg << "not initialized by its creator.";
+        throw runtime_error(err_msg.str());
+    }
+
+    for (; wait_ms < RAM_BUFFER_ATTACH_TIMEOUT_MS; wait_ms++) {
+        if (header->magic.load(memory_order_acquire) == RAM_BUFFER_MAGIC) {
+            break;
+        }
+        usleep(1000);
+    }
+
+    const RamBufferHeader& h = *header;
+    const bool is_ready = wait_ms < RAM_BUFFER_ATTACH_TIMEOUT_MS;
+
+    if (!is_ready) {
+        err_msg << "not initialized by its creator.";
+    } else if (h.version != RAM_BUFFER_VERSION) {
+        err_msg << "has layout version " << h.version;
+        err_msg << ", expected " << RAM_BUFFER_VERSION << ".";
+    } else if ((int) h.n_modules != n_modules_) {
+        err_msg << "has " << h.n_modules << " modules";
+        err_msg << ", expected " << n_modules_ << ".";
+    } else if (h.bits_per_pixel != PIXEL_N_BYTES * 8 ||
+               h.frame_meta_bytes != sizeof(ModuleFrame) ||
+               h.frame_data_bytes != MODULE_N_BYTES) {
+        err_msg << "has frames of " << h.frame_meta_bytes << "+";
+        err_msg << h.frame_data_bytes << " bytes, " << h.bits_per_pixel;
+        err_msg << " bits per pixel, expected " << sizeof(ModuleFrame);
+        err_msg << "+" << MODULE_N_BYTES << " bytes, ";
+        err_msg << PIXEL_N_BYTES * 8 << " bits per pixel.";
+    } else {
+        set_layout(h.n_slots);
+
+        if (h.module_meta_offset == module_meta_offset_ &&
+            h.image_offset == image_offset_ &&
+            h.buffer_bytes == buffer_bytes_ &&
+            (size_t) fd_stats.st_size >= buffer_bytes_) {
+            munmap(header, page_bytes_);
+            return;
+        }
+
+        err_msg << "has an inconsistent layout.";
+    }
+
+    munmap(header, page_bytes_);
+    close(shm_fd_);
+
+    err_msg << " Stop all its processes and remove it to recreate it.";
+    throw runtime_error(err_msg.str());
+}
+
+bool RamBuffer::map_hugetlbfs(const BufferUtils::RamBufferOptions& options)
+{
+    const string path = options.hugetlbfs_dir + "/" + detector_name_;
+
+    shm_fd_ = open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0777);
+    is_creator_ = shm_fd_ >= 0;
+    if (!is_creator_ && errno == EEXIST) {
+        shm_fd_ = open(path.c_str(), O_RDWR);
+    }
+
+    struct statfs fs_stats;
+    bool is_mapped = false;
+
+    if (shm_fd_ >= 0 && fstatfs(shm_fd_, &fs_stats) == 0) {
+
+        if (fs_stats.f_type != HUGETLBFS_MAGIC) {
+            errno = ENOTSUP;
+
+        } else {
+            // Mappings of hugetlbfs files are whole huge pages.
+            page_bytes_ = fs_stats.f_bsize;
+
+            if (!is_creator_) {
+                attach_layout();
+            }
+
+            mapped_bytes_ = ((buffer_bytes_ + page_bytes_ - 1) / page_bytes_) *
+                            page_bytes_;
+
+            // Bound pages are populated after binding.
+            const bool is_populate =
+                    options.populate && options.numa_nodes.empty();
+            const int flags = MAP_SHARED | (is_populate ? MAP_POPULATE : 0);
+
+            if (!is_creator_ || ftruncate(shm_fd_, mapped_bytes_) == 0) {
+                buffer_ = mmap(NULL, mapped_bytes_, PROT_READ | PROT_WRITE,
+                               flags, shm_fd_, 0);
+                is_mapped = buffer_ != MAP_FAILED;
+            }
+        }
+    }
+
+    if (is_mapped) {
+        return true;
+    }
+
+    cerr << "[RamBuffer::map_hugetlbfs] Cannot map " << path;
+    cerr << ", fall back to shared memory: " << strerror(errno) << endl;
+
+    if (shm_fd_ >= 0) {
+        close(shm_fd_);
+    }
+
+    if (is_creator_) {
+        unlink(path.c_str());
+        is_creator_ = false;
+    }
+
+    return false;
+}
+
+void RamBuffer::map_shm(const BufferUtils::RamBufferOptions& options)
 {
-    shm_fd_ = shm_open(detector_name_.c_str(), O_RDWR | O_CREAT, 0777);
+    shm_fd_ = shm_open(
+            detector_name_.c_str(), O_RDWR | O_CREAT | O_EXCL, 0777);
+    is_creator_ = shm_fd_ >= 0;
+    if (!is_creator_ && errno == EEXIST) {
+        shm_fd_ = shm_open(detector_name_.c_str(), O_RDWR, 0777);
+    }
+
     if (shm_fd_ < 0) {
         throw runtime_error(strerror(errno));
     }
 
-    if ((ftruncate(shm_fd_, buffer_bytes_)) == -1) {
+    page_bytes_ = sysconf(_SC_PAGESIZE);
+
+    if (!is_creator_) {
+        attach_layout();
+    } else if ((ftruncate(shm_fd_, buffer_bytes_)) == -1) {
         throw runtime_error(strerror(errno));
     }
 
-    // TODO: Test with MAP_HUGETLB
-    buffer_ = mmap(NULL, buffer_bytes_, PROT_WRITE, MAP_SHARED, shm_fd_, 0);
+    mapped_bytes_ = buffer_bytes_;
+
+    const bool is_thp =
+            options.pages == BufferUtils::RamBufferPages::TRANSPARENT_HUGE;
+
+    // With THP the pages are faulted in after the advice, or they stay
+    // small. Bound pages are populated after binding.
+    const bool is_populate =
+            options.populate && !is_thp && options.numa_nodes.empty();
+    const int flags = MAP_SHARED | (is_populate ? MAP_POPULATE : 0);
+
+    buffer_ = mmap(NULL, buffer_bytes_, PROT_READ | PROT_WRITE,
+                   flags, shm_fd_, 0);
     if (buffer_ == MAP_FAILED) {
         throw runtime_error(strerror(errno));
     }
 
-    // Metadata buffer is located at the start of the memory region.
-    meta_buffer_ = (ModuleFrame *) buffer_;
-    // Image buffer start right after metadata buffer.
-    image_buffer_ = (char*)buffer_ + (meta_bytes_ * n_slots_);
+    if (!is_thp) {
+        return;
+    }
+
+    if (madvise(buffer_, buffer_bytes_, MADV_HUGEPAGE) != 0) {
+        cerr << "[RamBuffer::map_shm] Cannot madvise MADV_HUGEPAGE, ";
+        cerr << "continue with small pages: " << strerror(errno) << endl;
+    }
+}
+
+void RamBuffer::bind_numa_nodes() const
+{
+    int n_unbound_ranges = 0;
+
+    for (int i_slot = 0; i_slot < n_slots_; i_slot++) {
+        char* slot_data = image_buffer_ + (image_bytes_ * i_slot);
+
+        // Consecutive modules on the same node are bound together.
+        int i_module = 0;
+        while (i_module < n_modules_) {
+            const int node = numa_nodes_[i_module];
+
+            int end_module = i_module + 1;
+            while (end_module < n_modules_ &&
+                   numa_nodes_[end_module] == node) {
+                end_module++;
+            }
+
+            // Only whole pages of the mapping can be bound.
+            const auto begin = (uintptr_t) (slot_data +
+                    (MODULE_N_BYTES * i_module));
+            const auto end = (uintptr_t) (slot_data +
+                    (MODULE_N_BYTES * end_module));
+            const auto page_begin =
+                    ((begin + page_bytes_ - 1) / page_bytes_) * page_bytes_;
+            const auto page_end = (end / page_bytes_) * page_bytes_;
+
+            const int first_module = i_module;
+            i_module = end_module;
+
+            if (page_begin >= page_end) {
+                n_unbound_ranges++;
+                continue;
+            }
+
+            const unsigned long node_mask = 1UL << node;
+            const auto status = syscall(
+                    SYS_mbind, page_begin, page_end - page_begin, MPOL_BIND,
+                    &node_mask, sizeof(node_mask) * 8, MPOL_MF_MOVE);
+
+            if (status != 0) {
+                stringstream err_msg;
+                err_msg << "[RamBuffer::bind_numa_nodes]";
+                err_msg << " Cannot bind module " << first_module;
+                err_msg << " to NUMA node " << node << ": ";
+                err_msg << strerror(errno) << endl;
+
+                throw runtime_error(err_msg.str());
+            }
+        }
+    }
+
+    if (n_unbound_ranges > 0) {
+        cerr << "[RamBuffer::bind_numa_nodes] " << n_unbound_ranges;
+        cerr << " module ranges smaller than a page of " << page_bytes_;
+        cerr << " bytes left to first touch placement." << endl;
+    }
 }
 
 RamBuffer::~RamBuffer()
 {
-    munmap(buffer_, buffer_bytes_);
+    if (is_locked_) {
+        munlock(buffer_, mapped_bytes_);
+    }
+
+    munmap(buffer_, mapped_bytes_);
     close(shm_fd_);
-    shm_unlink(detector_name_.c_str());
+}
+
+void RamBuffer::remove(
+        const string& detector_name,
+        const BufferUtils::RamBufferOptions& options)
+{
+    shm_unlink(detector_name.c_str());
+
+    if (options.pages == BufferUtils::RamBufferPages::HUGETLBFS) {
+        unlink((options.hugetlbfs_dir + "/" + detector_name).c_str());
+    }
+}
+
+const RamBufferHeader& RamBuffer::get_header() const
+{
+    return *header_;
+}
+
+int RamBuffer::get_n_slots() const
+{
+    return n_slots_;
+}
+
+atomic<uint64_t>* RamBuffer::get_generations(const uint64_t pulse_id) const
+{
+    return (atomic<uint64_t>*) get_module_meta(pulse_id, META_GENERATION);
+}
+
+uint64_t RamBuffer::sum_generations(const uint64_t pulse_id) const
+{
+    const auto generations = get_generations(pulse_id);
+
+    // Generations only grow, so the sum changes with any of them.
+    uint64_t sum = 0;
+    for (int i_module = 0; i_module < n_modules_; i_module++) {
+        sum += generations[i_module].load(memory_order_relaxed);
+    }
+
+    return sum;
+}
+
+void RamBuffer::start_write(atomic<uint64_t>& generation) const
+{
+    // Several threads can write parts of the same image slot.
+    if (generation.load(memory_order_relaxed) % 2 == 0) {
+        generation.fetch_or(1, memory_order_relaxed);
+    }
+
+    // The odd generation is visible before any data write.
+    atomic_thread_fence(memory_order_release);
+}
+
+void RamBuffer::end_write(atomic<uint64_t>& generation) const
+{
+    const auto odd_generation = generation.load(memory_order_relaxed) | 1;
+
+    // Publish the data written before.
+    generation.store(odd_generation + 1, memory_order_release);
+}
+
+uint64_t* RamBuffer::get_module_meta(
+        const uint64_t pulse_id, const int i_field) const
+{
+    const size_t slot_n = pulse_id % n_slots_;
+
+    return module_meta_buffer_ +
+           (N_META_FIELDS * meta_stride_ * slot_n) +
+           (meta_stride_ * i_field);
+}
+
+void RamBuffer::set_module_meta(
+        const ModuleFrame& meta, const uint64_t module_id) const
+{
+    get_module_meta(meta.pulse_id, META_PULSE_ID)[module_id] = meta.pulse_id;
+    get_module_meta(meta.pulse_id, META_FRAME_INDEX)[module_id] =
+            meta.frame_index;
+    get_module_meta(meta.pulse_id, META_DAQ_REC)[module_id] = meta.daq_rec;
+    get_module_meta(meta.pulse_id, META_N_RECV_PACKETS)[module_id] =
+            meta.n_recv_packets;
 }
 
 void RamBuffer::write_frame(
@@ -54,6 +469,7 @@ void RamBuffer::write_frame(
         const char *src_data) const
 {
     const int slot_n = src_meta.pulse_id % n_slots_;
+    auto& generation = get_generations(src_meta.pulse_id)[src_meta.module_id];
 
     ModuleFrame *dst_meta = meta_buffer_ +
                             (n_modules_ * slot_n) +
@@ -63,11 +479,118 @@ void RamBuffer::write_frame(
                      (image_bytes_ * slot_n) +
                      (MODULE_N_BYTES * src_meta.module_id);
 
+    start_write(generation);
     memcpy(dst_meta, &src_meta, sizeof(ModuleFrame));
+    set_module_meta(src_meta, src_meta.module_id);
     memcpy(dst_data, src_data, MODULE_N_BYTES);
+    end_write(generation);
+}
+
+char* RamBuffer::get_frame_slot(
+        const uint64_t pulse_id,
+        const uint64_t module_id) const
+{
+    const size_t slot_n = pulse_id % n_slots_;
+
+    return image_buffer_ +
+           (image_bytes_ * slot_n) +
+           (MODULE_N_BYTES * module_id);
+}
+
+void RamBuffer::begin_frame_write(
+        const uint64_t pulse_id,
+        const uint64_t module_id) const
+{
+    start_write(get_generations(pulse_id)[module_id]);
+}
+
+void RamBuffer::abort_frame_write(
+        const uint64_t pulse_id,
+        const uint64_t module_id) const
+{
+    const size_t slot_n = pulse_id % n_slots_;
+
+    // Readers of the old and of the new pulse_id find no frame.
+    meta_buffer_[(n_modules_ * slot_n) + module_id].pulse_id = 0;
+    get_module_meta(pulse_id, META_PULSE_ID)[module_id] = 0;
+    get_module_meta(pulse_id, META_N_RECV_PACKETS)[module_id] = 0;
+
+    end_write(get_generations(pulse_id)[module_id]);
+}
+
+void RamBuffer::commit_frame(const ModuleFrame& src_meta) const
+{
+    const size_t slot_n = src_meta.pulse_id % n_slots_;
+
+    ModuleFrame *dst_meta = meta_buffer_ +
+                            (n_modules_ * slot_n) +
+                            src_meta.module_id;
+    auto& generation = get_generations(src_meta.pulse_id)[src_meta.module_id];
+
+    start_write(generation);
+    memcpy(dst_meta, &src_meta, sizeof(ModuleFrame));
+    set_module_meta(src_meta, src_meta.module_id);
+    end_write(generation);
 }
 
-void RamBuffer::read_frame(
+char* RamBuffer::get_image_slot(const uint64_t pulse_id) const
+{
+    const size_t slot_n = pulse_id % n_slots_;
+
+    return image_buffer_ + (image_bytes_ * slot_n);
+}
+
+void RamBuffer::begin_image_write(const uint64_t pulse_id) const
+{
+    for (int i_module = 0; i_module < n_modules_; i_module++) {
+        begin_frame_write(pulse_id, i_module);
+    }
+}
+
+void RamBuffer::abort_image_write(const uint64_t pulse_id) const
+{
+    for (int i_module = 0; i_module < n_modules_; i_module++) {
+        abort_frame_write(pulse_id, i_module);
+    }
+}
+
+void RamBuffer::commit_image(
+        const ModuleFrame& src_meta,
+        const uint64_t* packets_bitmap) const
+{
+    const size_t slot_n = src_meta.pulse_id % n_slots_;
+    ModuleFrame *dst_meta = meta_buffer_ + (n_modules_ * slot_n);
+    const auto generations = get_generations(src_meta.pulse_id);
+
+    constexpr size_t module_n_words = JF_N_PACKETS_PER_FRAME / 64;
+
+    for (int i_module = 0; i_module < n_modules_; i_module++) {
+        ModuleFrame& frame_meta = dst_meta[i_module];
+        const uint64_t* module_bitmap =
+                packets_bitmap + (module_n_words * i_module);
+
+        start_write(generations[i_module]);
+
+        frame_meta.pulse_id = src_meta.pulse_id;
+        frame_meta.frame_index = src_meta.frame_index;
+        frame_meta.daq_rec = src_meta.daq_rec;
+        frame_meta.module_id = i_module;
+
+        frame_meta.n_recv_packets = 0;
+        for (size_t i_word = 0; i_word < module_n_words; i_word++) {
+            frame_meta.n_recv_packets += __builtin_popcountll(
+                    module_bitmap[i_word]);
+        }
+
+        memcpy(frame_meta.packets_bitmap, module_bitmap,
+               sizeof(frame_meta.packets_bitmap));
+        set_module_meta(frame_meta, i_module);
+
+        end_write(generations[i_module]);
+    }
+}
+
+bool RamBuffer::read_frame(
         const uint64_t pulse_id,
         const uint64_t module_id,
         ModuleFrame& dst_meta,
@@ -81,86 +604,225 @@ void RamBuffer::read_frame(
                      (image_bytes_ * slot_n) +
                      (MODULE_N_BYTES * module_id);
 
+    auto& generation = get_generations(pulse_id)[module_id];
+
+    const auto start_generation = generation.load(memory_order_acquire);
+
     memcpy(&dst_meta, src_meta, sizeof(ModuleFrame));
     memcpy(dst_data, src_data, MODULE_N_BYTES);
+
+    // The copy is done before the generation is checked again.
+    atomic_thread_fence(memory_order_acquire);
+
+    if (start_generation % 2 != 0 ||
+        generation.load(memory_order_relaxed) != start_generation) {
+        n_torn_reads_.fetch_add(1, memory_order_relaxed);
+        return false;
+    }
+
+    if (dst_meta.pulse_id > pulse_id) {
+        n_stale_reads_.fetch_add(1, memory_order_relaxed);
+        return false;
+    }
+
+    return dst_meta.pulse_id == pulse_id;
 }
 
 void RamBuffer::assemble_image(
-        const uint64_t pulse_id, ImageMetadata &image_meta) const
+        const uint64_t pulse_id,
+        ImageMetadata &image_meta,
+        const uint64_t missing_modules) const
 {
-    const size_t slot_n = pulse_id % n_slots_;
-    ModuleFrame *src_meta = meta_buffer_ + (n_modules_ * slot_n);
+    uint64_t* image_values = get_module_meta(pulse_id, META_IMAGE);
+    image_values[IMAGE_MISSING_MODULES] = missing_modules;
+    image_values[IMAGE_PULSE_ID] = pulse_id;
+
+    const auto generations = get_generations(pulse_id);
+    const uint64_t* pulse_ids = get_module_meta(pulse_id, META_PULSE_ID);
+    const uint64_t* frame_indexes =
+            get_module_meta(pulse_id, META_FRAME_INDEX);
+    const uint64_t* daq_recs = get_module_meta(pulse_id, META_DAQ_REC);
+    const uint64_t* n_recv_packets =
+            get_module_meta(pulse_id, META_N_RECV_PACKETS);
+
+    // Frames still being written are not good.
+    uint64_t start_generation = 0;
+    uint64_t is_written = 0;
+    for (int i_module = 0; i_module < n_modules_; i_module++) {
+        const auto generation =
+                generations[i_module].load(memory_order_acquire);
+
+        start_generation += generation;
+        is_written |= generation % 2;
+    }
 
-    auto is_pulse_init = false;
-    auto is_good_image = true;
+    // The first good frame gives the image metadata.
+    int i_first = 0;
+    for (; i_first < n_modules_; i_first++) {
+        if ((missing_modules >> i_first) % 2 == 0 &&
+            n_recv_packets[i_first] == JF_N_PACKETS_PER_FRAME &&
+            generations[i_first].load(memory_order_relaxed) % 2 == 0) {
+            break;
+        }
+    }
 
-    for (int i_module=0; i_module <  n_modules_; i_module++) {
-        ModuleFrame *frame_meta = src_meta + i_module;
+    if (i_first == n_modules_) {
+        image_meta.pulse_id = 0;
+        image_meta.frame_index = 0;
+        image_meta.daq_rec = 0;
+        image_meta.is_good_image = false;
+        return;
+    }
 
-        auto is_good_frame =
-                frame_meta->n_recv_packets == JF_N_PACKETS_PER_FRAME;
+    if (pulse_ids[i_first] != pulse_id) {
+        stringstream err_msg;
+        err_msg << "[RamBuffer::read_image]";
+        err_msg << " Unexpected pulse_id in ram buffer.";
+        err_msg << " expected=" << pulse_id;
+        err_msg << " got=" << pulse_ids[i_first];
 
-        if (!is_good_frame) {
-            is_good_image = false;
-            continue;
+        for (int i = 0; i < n_modules_; i++) {
+            err_msg << " (module " << i << ", ";
+            err_msg << pulse_ids[i] << "),";
         }
+        err_msg << endl;
 
-        if (!is_pulse_init) {
+        throw runtime_error(err_msg.str());
+    }
 
-            if (frame_meta->pulse_id != pulse_id) {
-                stringstream err_msg;
-                err_msg << "[RamBuffer::read_image]";
-                err_msg << " Unexpected pulse_id in ram buffer.";
-                err_msg << " expected=" << pulse_id;
-                err_msg << " got=" << frame_meta->pulse_id;
+    const auto frame_index = frame_indexes[i_first];
+    const auto daq_rec = daq_recs[i_first];
+
+    // Branch free over the module arrays, so the compiler vectorizes it.
+    uint64_t n_bad_frames = 0;
+    for (int i_module = 0; i_module < n_modules_; i_module++) {
+        n_bad_frames +=
+                (n_recv_packets[i_module] != JF_N_PACKETS_PER_FRAME) |
+                (pulse_ids[i_module] != pulse_id) |
+                (frame_indexes[i_module] != frame_index) |
+                (daq_recs[i_module] != daq_rec);
+    }
 
-                for (int i = 0; i < n_modules_; i++) {
-                    ModuleFrame *meta = src_meta + i_module;
+    auto is_good_image = n_bad_frames == 0 && is_written == 0;
 
-                    err_msg << " (module " << i << ", ";
-                    err_msg << meta->pulse_id << "),";
-                }
-                err_msg << endl;
+    atomic_thread_fence(memory_order_acquire);
+    if (sum_generations(pulse_id) != start_generation) {
+        n_torn_reads_.fetch_add(1, memory_order_relaxed);
+        is_good_image = false;
+    }
 
-                throw runtime_error(err_msg.str());
-            }
+    image_meta.pulse_id = pulse_id;
+    image_meta.frame_index = frame_index;
+    image_meta.daq_rec = daq_rec;
+    image_meta.is_good_image = is_good_image && missing_modules == 0;
+}
 
-            image_meta.pulse_id = frame_meta->pulse_id;
-            image_meta.frame_index = frame_meta->frame_index;
-            image_meta.daq_rec = frame_meta->daq_rec;
+uint64_t RamBuffer::get_missing_modules(const uint64_t pulse_id) const
+{
+    static_assert(JUNGFRAU_N_MODULES <= 64,
+                  "The missing modules have one bit per module.");
 
-            is_pulse_init = 1;
-        }
+    const uint64_t* image_values = get_module_meta(pulse_id, META_IMAGE);
 
-        if (is_good_image) {
-            if (frame_meta->pulse_id != image_meta.pulse_id) {
-                is_good_image = false;
-                // TODO: Add some diagnostics in case this happens.
-            }
+    if (image_values[IMAGE_PULSE_ID] != pulse_id) {
+        return (n_modules_ == 64) ?
+                ~uint64_t(0) : (uint64_t(1) << n_modules_) - 1;
+    }
 
-            if (frame_meta->frame_index != image_meta.frame_index) {
-                is_good_image = false;
-            }
+    return image_values[IMAGE_MISSING_MODULES];
+}
 
-            if (frame_meta->daq_rec != image_meta.daq_rec) {
-                is_good_image = false;
-            }
+char* RamBuffer::read_image(const uint64_t pulse_id) const
+{
+    const size_t slot_n = pulse_id % n_slots_;
+    char *src_data = image_buffer_ + (image_bytes_ * slot_n);
+
+    return src_data;
+}
+
+uint64_t RamBuffer::begin_read_image(const uint64_t pulse_id) const
+{
+    const uint64_t* pulse_ids = get_module_meta(pulse_id, META_PULSE_ID);
+    const auto generations = get_generations(pulse_id);
+
+    uint64_t generation = 0;
+    bool is_written = false;
+
+    for (int i_module = 0; i_module < n_modules_; i_module++) {
+        const auto module_generation =
+                generations[i_module].load(memory_order_acquire);
+
+        is_written |= module_generation % 2 != 0;
+        generation += module_generation;
+    }
+
+    if (is_written) {
+        n_torn_reads_.fetch_add(1, memory_order_relaxed);
+        return INVALID_GENERATION;
+    }
+
+    // Modules with lost frames still hold an older pulse_id.
+    for (int i_module = 0; i_module < n_modules_; i_module++) {
+        if (pulse_ids[i_module] > pulse_id) {
+            n_stale_reads_.fetch_add(1, memory_order_relaxed);
+            return INVALID_GENERATION;
         }
     }
 
-    image_meta.is_good_image = is_good_image;
+    return generation;
+}
 
-    if (!is_pulse_init) {
-        image_meta.pulse_id = 0;
-        image_meta.frame_index = 0;
-        image_meta.daq_rec = 0;
+bool RamBuffer::end_read_image(
+        const uint64_t pulse_id, const uint64_t generation) const
+{
+    if (generation == INVALID_GENERATION) {
+        return false;
+    }
+
+    // The image data is used before the generations are checked again.
+    atomic_thread_fence(memory_order_acquire);
+
+    if (sum_generations(pulse_id) != generation) {
+        n_torn_reads_.fetch_add(1, memory_order_relaxed);
+        return false;
     }
+
+    return true;
 }
 
-char* RamBuffer::read_image(const uint64_t pulse_id) const
+uint64_t RamBuffer::get_n_stale_reads() const
+{
+    return n_stale_reads_.load(memory_order_relaxed);
+}
+
+uint64_t RamBuffer::get_n_torn_reads() const
+{
+    return n_torn_reads_.load(memory_order_relaxed);
+}
+
+int RamBuffer::get_module_numa_node(const uint64_t module_id) const
+{
+    if (numa_nodes_.empty()) {
+        return -1;
+    }
+
+    return numa_nodes_[module_id];
+}
+
+int RamBuffer::get_frame_numa_node(
+        const uint64_t pulse_id, const uint64_t module_id) const
 {
     const size_t slot_n = pulse_id % n_slots_;
-    char *src_data = image_buffer_ + (image_bytes_ * slot_n);
+    void* page = image_buffer_ +
+                 (image_bytes_ * slot_n) +
+                 (MODULE_N_BYTES * module_id);
+    int node = -1;
+
+    // move_pages without target nodes reports the node of each page.
+    if (syscall(SYS_move_pages, 0, 1, &page, nullptr, &node, 0) != 0 ||
+        node < 0) {
+        return -1;
+    }
 
-    return src_data;
+    return node;
 }
@@ -0,0 +1,299 @@
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+#include "SpillBuffer.hpp"
+#include "buffer_config.hpp"
+
+using namespace std;
+using namespace buffer_config;
+
+namespace {
+    size_t align_bytes(const size_t n_bytes)
+    {
+        return ((n_bytes + SPILL_BUFFER_ALIGNMENT - 1) /
+                SPILL_BUFFER_ALIGNMENT) * SPILL_BUFFER_ALIGNMENT;
+    }
+}
+
+SpillBuffer::SpillBuffer(
+        const string& filename,
+        const int n_modules,
+        const int n_slots,
+        const bool is_writer) :
+        filename_(filename),
+        n_modules_(n_modules),
+        n_slots_(n_slots),
+        header_bytes_(align_bytes(
+                sizeof(uint64_t) + (n_modules * sizeof(ModuleFrame)))),
+        record_bytes_(header_bytes_ + (n_modules * MODULE_N_BYTES)),
+        is_writer_(is_writer)
+{
+    if (n_slots_ < 1) {
+        stringstream err_msg;
+        err_msg << "[SpillBuffer::SpillBuffer] Invalid n_slots ";
+        err_msg << n_slots_ << ".";
+        throw runtime_error(err_msg.str());
+    }
+
+    if (!is_writer_) {
+        // The writer may start later, reads retry to open the file.
+        open_file();
+        return;
+    }
+
+    empty_header_ = (char*) aligned_alloc(SPILL_BUFFER_ALIGNMENT,
+                                          header_bytes_);
+    memset(empty_header_, 0, header_bytes_);
+
+    fd_ = open(filename_.c_str(), O_RDWR | O_CREAT | O_DIRECT,
+               S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH);
+    is_direct_ = fd_ != -1;
+
+    if (!is_direct_) {
+        cerr << "[SpillBuffer::SpillBuffer] Cannot open " << filename_;
+        cerr << " with O_DIRECT (" << strerror(errno) << "),";
+        cerr << " falling back to the page cache." << endl;
+
+        fd_ = open(filename_.c_str(), O_RDWR | O_CREAT,
+                   S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH);
+    }
+
+    if (fd_ == -1) {
+        stringstream err_msg;
+        err_msg << "[SpillBuffer::SpillBuffer] Cannot open ";
+        err_msg << filename_ << ": " << strerror(errno);
+        free(empty_header_);
+        throw runtime_error(err_msg.str());
+    }
+
+    // Records of an earlier run are dropped, readers see empty slots.
+    const off_t file_bytes = (off_t) n_slots_ * record_bytes_;
+    if (ftruncate(fd_, 0) != 0 || ftruncate(fd_, file_bytes) != 0) {
+        stringstream err_msg;
+        err_msg << "[SpillBuffer::SpillBuffer] Cannot resize ";
+        err_msg << filename_ << " to " << file_bytes << " bytes: ";
+        err_msg << strerror(errno);
+        close(fd_);
+        free(empty_header_);
+        throw runtime_error(err_msg.str());
+    }
+
+    // Reserve the blocks, so spilling does not fail on a full disk later.
+    const auto fallocate_error = posix_fallocate(fd_, 0, file_bytes);
+    if (fallocate_error != 0) {
+        stringstream err_msg;
+        err_msg << "[SpillBuffer::SpillBuffer] Cannot allocate ";
+        err_msg << file_bytes << " bytes for " << filename_ << ": ";
+        err_msg << strerror(fallocate_error);
+        close(fd_);
+        free(empty_header_);
+        throw runtime_error(err_msg.str());
+    }
+}
+
+SpillBuffer::~SpillBuffer()
+{
+    if (fd_ != -1) {
+        close(fd_);
+    }
+
+    free(empty_header_);
+}
+
+bool SpillBuffer::open_file() const
+{
+    if (fd_ != -1) {
+        return true;
+    }
+
+    const auto fd = open(filename_.c_str(), O_RDONLY);
+    if (fd == -1) {
+        return false;
+    }
+
+    // The writer is still creating the file, or it was created for
+    // another layout - not ready, reads retry to open it.
+    struct stat file_stat;
+    const off_t file_bytes = (off_t) n_slots_ * record_bytes_;
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size != file_bytes) {
+        close(fd);
+        return false;
+    }
+
+    fd_ = fd;
+    return true;
+}
+
+size_t SpillBuffer::get_record_bytes() const
+{
+    return record_bytes_;
+}
+
+bool SpillBuffer::is_direct() const
+{
+    return is_direct_;
+}
+
+off_t SpillBuffer::get_record_offset(const uint64_t pulse_id) const
+{
+    return (off_t) (pulse_id % n_slots_) * record_bytes_;
+}
+
+uint64_t SpillBuffer::read_record_pulse_id(const off_t record_offset) const
+{
+    uint64_t pulse_id = 0;
+    if (pread(fd_, &pulse_id, sizeof(pulse_id), record_offset) !=
+            sizeof(pulse_id)) {
+        return 0;
+    }
+
+    return pulse_id;
+}
+
+void SpillBuffer::pwrite_all(
+        const char* buffer, const size_t n_bytes, const off_t offset) const
+{
+    size_t n_written = 0;
+    while (n_written < n_bytes) {
+        const auto result = pwrite(fd_, buffer + n_written,
+                                   n_bytes - n_written, offset + n_written);
+        if (result < 0) {
+            stringstream err_msg;
+            err_msg << "[SpillBuffer::write_record] Error while writing to ";
+            err_msg << filename_ << ": " << strerror(errno);
+            throw runtime_error(err_msg.str());
+        }
+
+        n_written += result;
+    }
+}
+
+int SpillBuffer::copy_image(
+        const RamBuffer& ram_buffer,
+        const uint64_t pulse_id,
+        char* record) const
+{
+    auto* metas = (ModuleFrame*) (record + sizeof(uint64_t));
+    char* data = record + header_bytes_;
+    int n_copied = 0;
+
+    for (int i_module = 0; i_module < n_modules_; i_module++) {
+        ModuleFrame meta;
+        if (ram_buffer.read_frame(pulse_id, i_module, meta,
+                                  data + (i_module * MODULE_N_BYTES))) {
+            n_copied++;
+        } else {
+            // No stale staging data in the record for a missing module.
+            meta = {};
+            memset(data + (i_module * MODULE_N_BYTES), 0, MODULE_N_BYTES);
+        }
+
+        memcpy(metas + i_module, &meta, sizeof(meta));
+    }
+
+    memcpy(record, &pulse_id, sizeof(pulse_id));
+
+    return n_copied;
+}
+
+void SpillBuffer::write_record(const char* record) const
+{
+    uint64_t pulse_id;
+    memcpy(&pulse_id, record, sizeof(pulse_id));
+    const auto offset = get_record_offset(pulse_id);
+
+    // Invalid header, data, then the header of the new record.
+    pwrite_all(empty_header_, header_bytes_, offset);
+    pwrite_all(record + header_bytes_,
+               record_bytes_ - header_bytes_,
+               offset + header_bytes_);
+    pwrite_all(record, header_bytes_, offset);
+}
+
+bool SpillBuffer::read_spilled_frame(
+        const uint64_t pulse_id,
+        const uint64_t module_id,
+        ModuleFrame& meta,
+        char* data) const
+{
+    if (!open_file()) {
+        return false;
+    }
+
+    const auto offset = get_record_offset(pulse_id);
+    if (read_record_pulse_id(offset) != pulse_id) {
+        return false;
+    }
+
+    const off_t meta_offset =
+            offset + sizeof(uint64_t) + (module_id * sizeof(ModuleFrame));
+    if (pread(fd_, &meta, sizeof(meta), meta_offset) != sizeof(meta) ||
+        meta.pulse_id != pulse_id) {
+        return false;
+    }
+
+    const off_t data_offset =
+            offset + header_bytes_ + (module_id * MODULE_N_BYTES);
+    if (pread(fd_, data, MODULE_N_BYTES, data_offset) !=
+            (ssize_t) MODULE_N_BYTES) {
+        return false;
+    }
+
+    // The writer invalidates the header before overwriting the data.
+    return read_record_pulse_id(offset) == pulse_id;
+}
+
+bool SpillBuffer::read_spilled_image(
+        const uint64_t pulse_id, char* data) const
+{
+    if (!open_file()) {
+        return false;
+    }
+
+    const auto offset = get_record_offset(pulse_id);
+    if (read_record_pulse_id(offset) != pulse_id) {
+        return false;
+    }
+
+    // Modules missing when the image was spilled make it a partial image.
+    vector<ModuleFrame> metas(n_modules_);
+    const size_t n_meta_bytes = n_modules_ * sizeof(ModuleFrame);
+    if (pread(fd_, metas.data(), n_meta_bytes, offset + sizeof(uint64_t)) !=
+            (ssize_t) n_meta_bytes) {
+        return false;
+    }
+
+    for (const auto& meta : metas) {
+        if (meta.pulse_id != pulse_id) {
+            return false;
+        }
+    }
+
+    const size_t n_bytes = n_modules_ * MODULE_N_BYTES;
+    if (pread(fd_, data, n_bytes, offset + header_bytes_) !=
+            (ssize_t) n_bytes) {
+        return false;
+    }
+
+    return read_record_pulse_id(offset) == pulse_id;
+}
+
+bool SpillBuffer::read_frame(
+        const RamBuffer& ram_buffer,
+        const uint64_t pulse_id,
+        const uint64_t module_id,
+        ModuleFrame& meta,
+        char* data) const
+{
+    if (ram_buffer.read_frame(pulse_id, module_id, meta, data)) {
+        return true;
+    }
+
+    return read_spilled_frame(pulse_id, module_id, meta, data);
+}
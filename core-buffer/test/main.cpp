@@ -2,6 +2,14 @@
 #include "test_buffer_utils.cpp"
 #include "test_bitshuffle.cpp"
 #include "test_RamBuffer.cpp"
+#include "test_PacketBitmap.cpp"
+#include "test_PulseTracer.cpp"
+#include "test_SpscRing.cpp"
+#include "test_PacketBuffer.cpp"
+#include "test_FrameCompletion.cpp"
+#include "test_GeometryAssembler.cpp"
+#include "test_SpillBuffer.cpp"
+#include "test_EventRing.cpp"
 
 using namespace std;
 
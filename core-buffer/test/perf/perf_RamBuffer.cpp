@@ -0,0 +1,244 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <memory>
+#include <cstring>
+#include "buffer_config.hpp"
+#include "BufferUtils.hpp"
+#include "RamBuffer.hpp"
+
+using namespace std;
+using namespace chrono;
+using namespace buffer_config;
+using namespace BufferUtils;
+
+const string PERF_DETECTOR_NAME = "perf_ram_buffer";
+
+double get_elapsed_ms(const steady_clock::time_point start_time)
+{
+    return duration_cast<microseconds>(
+            steady_clock::now() - start_time).count() / 1000.0;
+}
+
+double get_elapsed_us(const steady_clock::time_point start_time)
+{
+    return duration_cast<nanoseconds>(
+            steady_clock::now() - start_time).count() / 1000.0;
+}
+
+void print_pass(const string& pass_name,
+                const double elapsed_ms,
+                const size_t n_bytes)
+{
+    cout << " " << pass_name << "_ms=" << elapsed_ms;
+    cout << " " << pass_name << "_gb_per_s=";
+    cout << (n_bytes / 1e6) / max(elapsed_ms, 0.001);
+}
+
+void run_mapping(const string& name,
+                 const RamBufferOptions& options,
+                 const int n_modules,
+                 const int n_slots)
+{
+    const size_t n_bytes = MODULE_N_BYTES * n_modules * n_slots;
+
+    auto frame_buffer = make_unique<char[]>(MODULE_N_BYTES);
+    memset(frame_buffer.get(), 1, MODULE_N_BYTES);
+
+    ModuleFrame meta = {};
+    meta.n_recv_packets = JF_N_PACKETS_PER_FRAME;
+
+    // Every mapping creates a new buffer.
+    RamBuffer::remove(PERF_DETECTOR_NAME, options);
+
+    auto start_time = steady_clock::now();
+    RamBuffer buffer(PERF_DETECTOR_NAME, n_modules, n_slots, options);
+    cout << name << " map_ms=" << get_elapsed_ms(start_time);
+
+    // First pass pays the page faults not taken by populate.
+    for (const auto& pass_name : {"first_write", "write"}) {
+        start_time = steady_clock::now();
+
+        for (int i_slot = 0; i_slot < n_slots; i_slot++) {
+            meta.pulse_id = i_slot;
+            meta.frame_index = i_slot;
+
+            for (int i_module = 0; i_module < n_modules; i_module++) {
+                meta.module_id = i_module;
+                buffer.write_frame(meta, frame_buffer.get());
+            }
+        }
+
+        print_pass(pass_name, get_elapsed_ms(start_time), n_bytes);
+    }
+
+    start_time = steady_clock::now();
+    for (int i_slot = 0; i_slot < n_slots; i_slot++) {
+        for (int i_module = 0; i_module < n_modules; i_module++) {
+            buffer.read_frame(i_slot, i_module, meta, frame_buffer.get());
+        }
+    }
+    print_pass("read", get_elapsed_ms(start_time), n_bytes);
+
+    ImageMetadata image_meta;
+    start_time = steady_clock::now();
+    for (int i_slot = 0; i_slot < n_slots; i_slot++) {
+        buffer.assemble_image(i_slot, image_meta);
+    }
+    cout << " assemble_us_per_image=";
+    cout << (get_elapsed_ms(start_time) * 1000) / n_slots;
+    cout << endl;
+}
+
+// Reference for assemble_image: the scan over the packed ModuleFrame
+// metadata, one module at a time.
+uint32_t assemble_packed(const ModuleFrame* slot_meta,
+                         const int n_modules,
+                         ImageMetadata& image_meta)
+{
+    auto is_pulse_init = false;
+    auto is_good_image = true;
+
+    for (int i_module = 0; i_module < n_modules; i_module++) {
+        const ModuleFrame* frame_meta = slot_meta + i_module;
+
+        if (frame_meta->n_recv_packets != JF_N_PACKETS_PER_FRAME) {
+            is_good_image = false;
+            continue;
+        }
+
+        if (!is_pulse_init) {
+            image_meta.pulse_id = frame_meta->pulse_id;
+            image_meta.frame_index = frame_meta->frame_index;
+            image_meta.daq_rec = frame_meta->daq_rec;
+            is_pulse_init = true;
+        }
+
+        if (frame_meta->pulse_id != image_meta.pulse_id ||
+            frame_meta->frame_index != image_meta.frame_index ||
+            frame_meta->daq_rec != image_meta.daq_rec) {
+            is_good_image = false;
+        }
+    }
+
+    image_meta.is_good_image = is_good_image;
+    return is_good_image;
+}
+
+// Image metadata assembly at 1 kHz (metadata hot in the cache) and at
+// 100 Hz (caches flushed by the image data between two pulses).
+void run_assemble(const int n_modules, const int n_slots)
+{
+    RamBuffer::remove(PERF_DETECTOR_NAME);
+    RamBuffer buffer(PERF_DETECTOR_NAME, n_modules, n_slots);
+    auto packed_meta = make_unique<ModuleFrame[]>(n_modules * n_slots);
+
+    ModuleFrame meta = {};
+    meta.n_recv_packets = JF_N_PACKETS_PER_FRAME;
+    for (int i_slot = 0; i_slot < n_slots; i_slot++) {
+        meta.pulse_id = i_slot;
+        meta.frame_index = i_slot;
+
+        for (int i_module = 0; i_module < n_modules; i_module++) {
+            meta.module_id = i_module;
+            buffer.commit_frame(meta);
+            packed_meta[(n_modules * i_slot) + i_module] = meta;
+        }
+    }
+
+    // Larger than the last level cache.
+    const size_t flush_n_bytes = 64 * 1024 * 1024;
+    auto flush_buffer = make_unique<char[]>(flush_n_bytes);
+
+    const int n_repeats = 1000;
+    ImageMetadata image_meta;
+    uint64_t n_good_images = 0;
+
+    for (const bool is_cold : {false, true}) {
+        double packed_us = 0;
+        double soa_us = 0;
+
+        for (int i_repeat = 0; i_repeat < n_repeats; i_repeat++) {
+            const int i_slot = is_cold ? (i_repeat * 7) % n_slots : 0;
+
+            if (is_cold) {
+                memset(flush_buffer.get(), i_repeat, flush_n_bytes);
+            }
+            auto start_time = steady_clock::now();
+            n_good_images += assemble_packed(
+                    packed_meta.get() + (n_modules * i_slot),
+                    n_modules, image_meta);
+            packed_us += get_elapsed_us(start_time);
+
+            if (is_cold) {
+                memset(flush_buffer.get(), i_repeat, flush_n_bytes);
+            }
+            start_time = steady_clock::now();
+            buffer.assemble_image(i_slot, image_meta);
+            soa_us += get_elapsed_us(start_time);
+            n_good_images += image_meta.is_good_image;
+        }
+
+        packed_us /= n_repeats;
+        soa_us /= n_repeats;
+        // Time budget per image in us.
+        const double budget_us = is_cold ? 10000 : 1000;
+
+        cout << "assemble_" << (is_cold ? "100hz" : "1khz");
+        cout << " n_modules=" << n_modules;
+        cout << " packed_us_per_image=" << packed_us;
+        cout << " soa_us_per_image=" << soa_us;
+        cout << " packed_budget_percent=" << (packed_us * 100) / budget_us;
+        cout << " soa_budget_percent=" << (soa_us * 100) / budget_us;
+        cout << endl;
+    }
+
+    if (n_good_images != 2 * 2 * n_repeats) {
+        cout << "Unexpected bad images in assemble benchmark." << endl;
+    }
+}
+
+int main (int argc, char *argv[])
+{
+    if (argc != 3 && argc != 4) {
+        cout << endl;
+        cout << "Usage: ram_buffer_perf [n_modules] [n_slots]";
+        cout << " [hugetlbfs_dir]" << endl;
+        cout << "\tn_modules: Number of modules per image." << endl;
+        cout << "\tn_slots: Number of RamBuffer slots." << endl;
+        cout << "\thugetlbfs_dir: Optional hugetlbfs mount.";
+        cout << endl;
+        cout << endl;
+
+        exit(-1);
+    }
+
+    const int n_modules = atoi(argv[1]);
+    const int n_slots = atoi(argv[2]);
+
+    RamBufferOptions options;
+    if (argc == 4) {
+        options.hugetlbfs_dir = argv[3];
+    }
+
+    run_mapping("small", options, n_modules, n_slots);
+
+    options.populate = true;
+    run_mapping("small_populate", options, n_modules, n_slots);
+
+    options.lock = true;
+    run_mapping("small_populate_mlock", options, n_modules, n_slots);
+    options.lock = false;
+
+    options.pages = RamBufferPages::TRANSPARENT_HUGE;
+    run_mapping("transparent_populate", options, n_modules, n_slots);
+
+    options.pages = RamBufferPages::HUGETLBFS;
+    run_mapping("hugetlbfs_populate", options, n_modules, n_slots);
+    RamBuffer::remove(PERF_DETECTOR_NAME, options);
+
+    run_assemble(n_modules, n_slots);
+    RamBuffer::remove(PERF_DETECTOR_NAME);
+
+    return 0;
+}
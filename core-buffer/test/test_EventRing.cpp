@@ -0,0 +1,129 @@
+#include <thread>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "gtest/gtest.h"
+#include "EventRing.hpp"
+
+using namespace std;
+using namespace buffer_config;
+
+TEST(EventRing, broadcast)
+{
+    EventRing::remove("test_detector", "test_events");
+    EventRing producer("test_detector", "test_events", sizeof(uint64_t), true);
+    EventRing consumer_1("test_detector", "test_events", sizeof(uint64_t), false);
+    EventRing consumer_2("test_detector", "test_events", sizeof(uint64_t), false);
+    ASSERT_EQ(producer.get_n_consumers(), 2);
+
+    for (uint64_t pulse_id = 1; pulse_id <= 10; pulse_id++) {
+        producer.send(&pulse_id);
+    }
+    ASSERT_EQ(producer.get_max_lag(), 10);
+
+    uint64_t pulse_id = 0;
+    for (uint64_t expected = 1; expected <= 10; expected++) {
+        ASSERT_TRUE(consumer_1.recv(&pulse_id, 0));
+        ASSERT_EQ(pulse_id, expected);
+    }
+    ASSERT_EQ(consumer_1.get_lag(), 0);
+    ASSERT_EQ(consumer_2.get_lag(), 10);
+    ASSERT_EQ(producer.get_max_lag(), 10);
+
+    ASSERT_TRUE(consumer_2.recv(&pulse_id, 0));
+    ASSERT_EQ(pulse_id, 1);
+
+    // Nothing new for consumer_1.
+    ASSERT_FALSE(consumer_1.recv(&pulse_id, 10));
+
+    EventRing::remove("test_detector", "test_events");
+}
+
+TEST(EventRing, drop_slow_consumer)
+{
+    const int n_slots = 16;
+    EventRing::remove("test_detector", "test_events");
+    EventRing producer("test_detector", "test_events",
+                       sizeof(uint64_t), true, n_slots);
+    EventRing consumer("test_detector", "test_events",
+                       sizeof(uint64_t), false, n_slots);
+
+    for (uint64_t pulse_id = 0; pulse_id < 40; pulse_id++) {
+        producer.send(&pulse_id);
+    }
+
+    // Only the last n_slots events are left.
+    uint64_t pulse_id = 0;
+    ASSERT_TRUE(consumer.recv(&pulse_id, 0));
+    ASSERT_EQ(pulse_id, 40 - n_slots);
+    ASSERT_EQ(consumer.get_n_dropped(), 40 - n_slots);
+    ASSERT_EQ(consumer.get_lag(), n_slots - 1);
+
+    // A different layout cannot attach.
+    ASSERT_THROW(EventRing("test_detector", "test_events",
+                           sizeof(uint64_t), false, n_slots * 2),
+                 runtime_error);
+
+    EventRing::remove("test_detector", "test_events");
+}
+
+TEST(EventRing, wake_up)
+{
+    EventRing::remove("test_detector", "test_events");
+    EventRing consumer("test_detector", "test_events", sizeof(uint64_t), false);
+    EventRing producer("test_detector", "test_events", sizeof(uint64_t), true);
+
+    const uint64_t n_events = 10000;
+    thread sender([&] {
+        for (uint64_t pulse_id = 1; pulse_id <= n_events; pulse_id++) {
+            producer.send(&pulse_id);
+            if (pulse_id % 1000 == 0) {
+                this_thread::sleep_for(chrono::milliseconds(5));
+            }
+        }
+    });
+
+    uint64_t n_received = 0;
+    uint64_t pulse_id = 0;
+    while (pulse_id < n_events) {
+        uint64_t previous_pulse_id = pulse_id;
+        ASSERT_TRUE(consumer.recv(&pulse_id, 1000));
+        ASSERT_GT(pulse_id, previous_pulse_id);
+        n_received++;
+    }
+
+    sender.join();
+    ASSERT_EQ(n_received + consumer.get_n_dropped(), n_events);
+
+    EventRing::remove("test_detector", "test_events");
+}
+
+TEST(EventRing, reuse_dead_consumer)
+{
+    EventRing::remove("test_detector", "test_events");
+    EventRing producer("test_detector", "test_events", sizeof(uint64_t), true);
+
+    // The child exits without releasing its entry.
+    auto pid = fork();
+    if (pid == 0) {
+        new EventRing("test_detector", "test_events", sizeof(uint64_t), false);
+        _exit(0);
+    }
+    ASSERT_GT(pid, 0);
+    waitpid(pid, nullptr, 0);
+    ASSERT_EQ(producer.get_n_consumers(), 0);
+
+    vector<unique_ptr<EventRing>> consumers;
+    for (int i = 0; i < EVENT_RING_MAX_CONSUMERS; i++) {
+        consumers.push_back(make_unique<EventRing>(
+                "test_detector", "test_events", sizeof(uint64_t), false));
+    }
+    ASSERT_EQ(producer.get_n_consumers(), EVENT_RING_MAX_CONSUMERS);
+    ASSERT_THROW(EventRing("test_detector", "test_events",
+                           sizeof(uint64_t), false),
+                 runtime_error);
+
+    consumers.pop_back();
+    ASSERT_EQ(producer.get_n_consumers(), EVENT_RING_MAX_CONSUMERS - 1);
+
+    EventRing::remove("test_detector", "test_events");
+}
@@ -0,0 +1,117 @@
+#include "gtest/gtest.h"
+#include "FrameCompletion.hpp"
+#include "PacketBitmap.hpp"
+
+using namespace std;
+
+ModuleFrame get_part(const uint64_t frame_index, const uint64_t n_packets)
+{
+    ModuleFrame part = {};
+    part.pulse_id = frame_index + 1;
+    part.frame_index = frame_index;
+    part.daq_rec = 10;
+    part.n_recv_packets = n_packets;
+
+    return part;
+}
+
+TEST(FrameCompletion, last_part)
+{
+    FrameCompletion completion({0, 128, 256, 384}, 10);
+    ModuleFrame frame;
+    uint64_t frame_bitmap[6];
+
+    // Only packets 300 and 301 received in the first word of part 2.
+    uint64_t part_bitmap[6];
+    memset(part_bitmap, 0xFF, sizeof(part_bitmap));
+    PacketBitmap::clear(part_bitmap + 4, 64);
+    PacketBitmap::set(part_bitmap, 300);
+    PacketBitmap::set(part_bitmap, 301);
+
+    ASSERT_FALSE(completion.add_part(
+            0, get_part(100, 128), part_bitmap, frame, frame_bitmap));
+    ASSERT_FALSE(completion.add_part(
+            2, get_part(100, 127), part_bitmap, frame, frame_bitmap));
+    // Next frame in another slot does not interfere.
+    ASSERT_FALSE(completion.add_part(
+            0, get_part(101, 128), part_bitmap, frame, frame_bitmap));
+
+    ASSERT_TRUE(completion.add_part(
+            1, get_part(100, 128), part_bitmap, frame, frame_bitmap));
+    ASSERT_EQ(frame.pulse_id, 101);
+    ASSERT_EQ(frame.frame_index, 100);
+    ASSERT_EQ(frame.daq_rec, 10);
+    ASSERT_EQ(frame.n_recv_packets, 128 + 127 + 128);
+
+    for (size_t i_packet = 0; i_packet < 384; i_packet++) {
+        ASSERT_EQ(PacketBitmap::is_set(frame_bitmap, i_packet),
+                  i_packet < 256 || i_packet >= 320 ||
+                  i_packet == 300 || i_packet == 301);
+    }
+}
+
+TEST(FrameCompletion, missing_and_late_parts)
+{
+    FrameCompletion completion({0, 128, 256}, 10);
+    ModuleFrame frame;
+    uint64_t frame_bitmap[4];
+    uint64_t part_bitmap[4];
+    memset(part_bitmap, 0xFF, sizeof(part_bitmap));
+
+    // Part 1 got no packets of frame 100.
+    ASSERT_FALSE(completion.add_part(
+            0, get_part(100, 128), part_bitmap, frame, frame_bitmap));
+    ASSERT_TRUE(completion.add_empty_part(1, 100, frame, frame_bitmap));
+    ASSERT_EQ(frame.pulse_id, 101);
+    ASSERT_EQ(frame.n_recv_packets, 128);
+    ASSERT_EQ(frame_bitmap[1], ~uint64_t(0));
+    ASSERT_EQ(frame_bitmap[2], 0);
+
+    // Frame without packets is not passed on.
+    ASSERT_FALSE(completion.add_empty_part(0, 102, frame, frame_bitmap));
+    ASSERT_FALSE(completion.add_empty_part(1, 102, frame, frame_bitmap));
+
+    // Frame 105 takes over the slot of frame 95, which arrives late.
+    ASSERT_FALSE(completion.add_part(
+            0, get_part(105, 128), part_bitmap, frame, frame_bitmap));
+    ASSERT_FALSE(completion.add_part(
+            1, get_part(95, 128), part_bitmap, frame, frame_bitmap));
+    ASSERT_TRUE(completion.add_part(
+            1, get_part(105, 128), part_bitmap, frame, frame_bitmap));
+    ASSERT_EQ(frame.frame_index, 105);
+
+    // frame_index restarted, in the slot of frame 105.
+    ASSERT_FALSE(completion.add_part(
+            0, get_part(5, 128), part_bitmap, frame, frame_bitmap));
+    ASSERT_TRUE(completion.add_part(
+            1, get_part(5, 128), part_bitmap, frame, frame_bitmap));
+    ASSERT_EQ(frame.frame_index, 5);
+}
+
+TEST(FrameCompletion, late_part_of_same_stream)
+{
+    FrameCompletion completion({0, 128, 256}, 10);
+    ModuleFrame frame;
+    uint64_t frame_bitmap[4];
+    uint64_t full_bitmap[4];
+    memset(full_bitmap, 0xFF, sizeof(full_bitmap));
+    uint64_t empty_bitmap[4] = {};
+
+    ASSERT_FALSE(completion.add_part(
+            0, get_part(105, 128), full_bitmap, frame, frame_bitmap));
+    ASSERT_EQ(completion.get_newest_frame_index(), 105);
+
+    // Part 0 of frame 95 arrives late, it must not touch frame 105.
+    ASSERT_FALSE(completion.add_part(
+            0, get_part(95, 3), empty_bitmap, frame, frame_bitmap));
+    ASSERT_FALSE(completion.add_empty_part(0, 95, frame, frame_bitmap));
+    ASSERT_EQ(completion.get_newest_frame_index(), 105);
+
+    ASSERT_TRUE(completion.add_part(
+            1, get_part(105, 128), full_bitmap, frame, frame_bitmap));
+    ASSERT_EQ(frame.frame_index, 105);
+    ASSERT_EQ(frame.n_recv_packets, 256);
+    for (int i_word = 0; i_word < 4; i_word++) {
+        ASSERT_EQ(frame_bitmap[i_word], ~uint64_t(0));
+    }
+}
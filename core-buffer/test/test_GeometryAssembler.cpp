@@ -0,0 +1,170 @@
+#include <memory>
+#include "gtest/gtest.h"
+#include "GeometryAssembler.hpp"
+#include "buffer_config.hpp"
+
+using namespace std;
+using namespace buffer_config;
+using namespace BufferUtils;
+
+// Pixel value encodes module, row and column.
+unique_ptr<uint16_t[]> get_modules(const int n_modules)
+{
+    auto data = make_unique<uint16_t[]>(n_modules * MODULE_N_PIXELS);
+
+    for (int i_module = 0; i_module < n_modules; i_module++) {
+        for (size_t y = 0; y < MODULE_Y_SIZE; y++) {
+            for (size_t x = 0; x < MODULE_X_SIZE; x++) {
+                data[(i_module * MODULE_N_PIXELS) + (y * MODULE_X_SIZE) + x] =
+                        (i_module << 14) + ((y % 8) << 10) + x;
+            }
+        }
+    }
+
+    return data;
+}
+
+uint16_t get_pixel(const int i_module, const size_t x, const size_t y)
+{
+    return (i_module << 14) + ((y % 8) << 10) + x;
+}
+
+TEST(GeometryAssembler, stacked)
+{
+    const int n_modules = 3;
+    auto data = get_modules(n_modules);
+
+    GeometryAssembler assembler({}, n_modules);
+    ASSERT_EQ(assembler.get_image_x_size(), MODULE_X_SIZE);
+    ASSERT_EQ(assembler.get_image_y_size(), n_modules * MODULE_Y_SIZE);
+
+    auto image = make_unique<uint16_t[]>(assembler.get_image_n_pixels());
+    assembler.assemble((char*) data.get(), image.get());
+
+    ASSERT_EQ(0, memcmp(data.get(), image.get(),
+                        n_modules * MODULE_N_BYTES));
+}
+
+TEST(GeometryAssembler, gap_pixels)
+{
+    DetectorGeometry geometry;
+    geometry.modules = {{0, 0, 0}};
+    geometry.gap_pixels = true;
+    geometry.double_pixels = DoublePixels::DUPLICATE;
+
+    auto data = get_modules(1);
+    GeometryAssembler assembler(geometry, 1);
+    const size_t W = 1030;
+    ASSERT_EQ(assembler.get_image_x_size(), W);
+    ASSERT_EQ(assembler.get_image_y_size(), 514);
+
+    auto image = make_unique<uint16_t[]>(assembler.get_image_n_pixels());
+    assembler.assemble((char*) data.get(), image.get());
+
+    // Chips shift by the gaps.
+    ASSERT_EQ(image[0], get_pixel(0, 0, 0));
+    ASSERT_EQ(image[258], get_pixel(0, 256, 0));
+    ASSERT_EQ(image[(258 * W) + 1029], get_pixel(0, 1023, 256));
+    // Gap pixels duplicate their double pixel.
+    ASSERT_EQ(image[(10 * W) + 256], get_pixel(0, 255, 10));
+    ASSERT_EQ(image[(10 * W) + 257], get_pixel(0, 256, 10));
+    ASSERT_EQ(image[(256 * W) + 10], get_pixel(0, 10, 255));
+    ASSERT_EQ(image[(257 * W) + 10], get_pixel(0, 10, 256));
+    ASSERT_EQ(image[(256 * W) + 256], get_pixel(0, 255, 255));
+}
+
+TEST(GeometryAssembler, mask_double_pixels)
+{
+    DetectorGeometry geometry;
+    geometry.modules = {{0, 0, 0}};
+    geometry.double_pixels = DoublePixels::MASK;
+
+    auto data = get_modules(1);
+    GeometryAssembler assembler(geometry, 1);
+    const size_t W = MODULE_X_SIZE;
+
+    auto image = make_unique<uint16_t[]>(assembler.get_image_n_pixels());
+    assembler.assemble((char*) data.get(), image.get());
+
+    ASSERT_EQ(image[(10 * W) + 254], get_pixel(0, 254, 10));
+    ASSERT_EQ(image[(10 * W) + 255], 0);
+    ASSERT_EQ(image[(10 * W) + 256], 0);
+    ASSERT_EQ(image[(10 * W) + 767], 0);
+    ASSERT_EQ(image[(10 * W) + 768], 0);
+    ASSERT_EQ(image[(255 * W) + 10], 0);
+    ASSERT_EQ(image[(256 * W) + 10], 0);
+    ASSERT_EQ(image[(257 * W) + 10], get_pixel(0, 10, 257));
+}
+
+TEST(GeometryAssembler, rotation)
+{
+    DetectorGeometry geometry;
+    // Module 0 upside down on top, module 1 turned clockwise below it.
+    geometry.modules = {{0, 0, 2}, {0, 512, 1}};
+
+    auto data = get_modules(2);
+    GeometryAssembler assembler(geometry, 2);
+    const size_t W = MODULE_X_SIZE;
+    ASSERT_EQ(assembler.get_image_x_size(), W);
+    ASSERT_EQ(assembler.get_image_y_size(), 512 + 1024);
+
+    auto image = make_unique<uint16_t[]>(assembler.get_image_n_pixels());
+    assembler.assemble((char*) data.get(), image.get());
+
+    ASSERT_EQ(image[0], get_pixel(0, 1023, 511));
+    ASSERT_EQ(image[(511 * W) + 1023], get_pixel(0, 0, 0));
+    // Module pixel (x, y) at (511 - y, x).
+    ASSERT_EQ(image[(512 * W) + 511], get_pixel(1, 0, 0));
+    ASSERT_EQ(image[((512 + 100) * W) + 511 - 3], get_pixel(1, 100, 3));
+    // Not covered by modules.
+    ASSERT_EQ(image[(512 * W) + 512], 0);
+}
+
+TEST(GeometryAssembler, threads)
+{
+    const int n_modules = 7;
+    DetectorGeometry geometry;
+    geometry.gap_pixels = true;
+    for (int i_module = 0; i_module < n_modules; i_module++) {
+        geometry.modules.push_back({i_module * 1030, 0, i_module % 4});
+    }
+
+    auto data = get_modules(n_modules);
+    GeometryAssembler single(geometry, n_modules);
+    GeometryAssembler multi(geometry, n_modules, 3);
+
+    const auto n_pixels = single.get_image_n_pixels();
+    auto expected = make_unique<uint16_t[]>(n_pixels);
+    auto image = make_unique<uint16_t[]>(n_pixels);
+
+    for (int i = 0; i < 3; i++) {
+        memset(image.get(), 0xFF, n_pixels * PIXEL_N_BYTES);
+        single.assemble((char*) data.get(), expected.get());
+        multi.assemble((char*) data.get(), image.get());
+        ASSERT_EQ(0, memcmp(expected.get(), image.get(),
+                            n_pixels * PIXEL_N_BYTES));
+    }
+}
+
+TEST(GeometryAssembler, invalid_geometry)
+{
+    DetectorGeometry geometry;
+    geometry.modules = {{0, 0, 0}};
+    ASSERT_THROW(GeometryAssembler(geometry, 2), runtime_error);
+
+    geometry.modules = {{0, 0, 4}};
+    ASSERT_THROW(GeometryAssembler(geometry, 1), runtime_error);
+
+    geometry.modules = {{1, 0, 0}};
+    geometry.image_x_size = 1024;
+    geometry.image_y_size = 512;
+    ASSERT_THROW(GeometryAssembler(geometry, 1), runtime_error);
+
+    geometry.modules = {{0, 0, 0}, {1000, 0, 0}};
+    geometry.image_x_size = 0;
+    ASSERT_THROW(GeometryAssembler(geometry, 2), runtime_error);
+
+    geometry.modules = {{0, 0, 0}};
+    geometry.double_pixels = DoublePixels::DUPLICATE;
+    ASSERT_THROW(GeometryAssembler(geometry, 1), runtime_error);
+}
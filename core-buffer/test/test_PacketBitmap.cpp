@@ -0,0 +1,57 @@
+#include "gtest/gtest.h"
+#include "PacketBitmap.hpp"
+#include "jungfraujoch.hpp"
+
+using namespace std;
+
+TEST(PacketBitmap, set_and_clear)
+{
+    const size_t n_packets = JFJOCH_N_PACKETS_PER_FRAME;
+    uint64_t bitmap[PacketBitmap::n_words(n_packets)];
+
+    PacketBitmap::clear(bitmap, n_packets);
+    for (size_t i = 0; i < n_packets; i++) {
+        ASSERT_FALSE(PacketBitmap::is_set(bitmap, i));
+    }
+
+    PacketBitmap::set(bitmap, 0);
+    PacketBitmap::set(bitmap, 63);
+    PacketBitmap::set(bitmap, 64);
+    PacketBitmap::set(bitmap, n_packets-1);
+
+    ASSERT_TRUE(PacketBitmap::is_set(bitmap, 0));
+    ASSERT_FALSE(PacketBitmap::is_set(bitmap, 1));
+    ASSERT_TRUE(PacketBitmap::is_set(bitmap, 63));
+    ASSERT_TRUE(PacketBitmap::is_set(bitmap, 64));
+    ASSERT_FALSE(PacketBitmap::is_set(bitmap, 65));
+    ASSERT_TRUE(PacketBitmap::is_set(bitmap, n_packets-1));
+}
+
+TEST(PacketBitmap, zero_missing)
+{
+    const size_t n_packets = 200;
+    const size_t packet_n_bytes = 16;
+    uint64_t bitmap[PacketBitmap::n_words(n_packets)];
+    char frame_buffer[n_packets * packet_n_bytes];
+
+    memset(frame_buffer, 1, sizeof(frame_buffer));
+
+    PacketBitmap::clear(bitmap, n_packets);
+    for (size_t i = 0; i < n_packets; i++) {
+        // Missing packets: 5, 70-130, 199.
+        if (i == 5 || (i >= 70 && i <= 130) || i == 199) {
+            continue;
+        }
+        PacketBitmap::set(bitmap, i);
+    }
+
+    PacketBitmap::zero_missing(bitmap, n_packets, frame_buffer, packet_n_bytes);
+
+    for (size_t i = 0; i < n_packets; i++) {
+        char expected = PacketBitmap::is_set(bitmap, i) ? 1 : 0;
+
+        for (size_t i_byte = 0; i_byte < packet_n_bytes; i_byte++) {
+            ASSERT_EQ(frame_buffer[(i * packet_n_bytes) + i_byte], expected);
+        }
+    }
+}
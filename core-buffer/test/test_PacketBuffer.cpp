@@ -2,253 +2,108 @@
 #include <jungfraujoch.hpp>
 #include "gtest/gtest.h"
 #include "PacketBuffer.hpp"
+#include "PacketFrameEngine.hpp"
 
 #include <thread>
-#include <chrono>
-#include <future>
 
 using namespace std;
 
-template <typename TY>
-class MockReceiver<TY>{
+// Returns num_packets packets of consecutive frames per receive.
+class MockReceiver {
     public:
-        int idx_packet = 42000;
-        int packet_per_frame = 512;
-        int num_bunches = 100;
-        int num_packets =50;
-
-        int receive_many(mmsghdr* msgs, const size_t n_msgs){
-            // Receive 'num_packets numner of packets'
-
-            for(int ii=0; ii<std::min(num_packets, n_msgs); ii++){
-                jfjoch_packet_t& refer = std::reinterpret_cast<jfjoch_packet_t&>(mmsghdr[ii].msg_hdr.msg_iov->iov_base);
-                refer.bunchid = idx_packet / packet_per_frame;
-                refer.packetnum = idx_packet % packet_per_frame;
+        int idx_packet = 0;
+        int packet_per_frame = JFJOCH_N_PACKETS_PER_FRAME;
+        int num_packets = 50;
+
+        int receive_many(mmsghdr* msgs, const size_t n_msgs, const int flags=0){
+            const int n_recv = min(num_packets, (int) n_msgs);
+
+            for (int ii=0; ii<n_recv; ii++) {
+                auto packet = (jfjoch_packet_t*) msgs[ii].msg_hdr.msg_iov->iov_base;
+                packet->bunchid = 1 + (idx_packet / packet_per_frame);
+                packet->framenum = 1000 + (idx_packet / packet_per_frame);
+                packet->packetnum = idx_packet % packet_per_frame;
+                packet->debug = 0;
                 idx_packet++;
             }
-            return std::min(num_packets, n_msgs);
+            return n_recv;
         };
 };
 
-//
-//
-//
-//
-//TEST(BufferUdpReceiver, simple_recv)
-//{
-//    auto n_packets = JF_N_PACKETS_PER_FRAME;
-//    int n_frames = 5;
-//
-//    uint16_t udp_port = MOCK_UDP_PORT;
-//    auto server_address = get_server_address(udp_port);
-//    auto send_socket_fd = socket(AF_INET, SOCK_DGRAM, 0);
-//    ASSERT_TRUE(send_socket_fd >= 0);
-//
-//    JfjFrameUdpReceiver udp_receiver(udp_port);
-//
-//    auto handle = async(launch::async, [&](){
-//        for (int i_frame=0; i_frame < n_frames; i_frame++){
-//            for (size_t i_packet=0; i_packet<n_packets; i_packet++) {
-//                jungfrau_packet send_udp_buffer;
-//                send_udp_buffer.packetnum = i_packet;
-//                send_udp_buffer.bunchid = i_frame + 1;
-//                send_udp_buffer.framenum = i_frame + 1000;
-//                send_udp_buffer.debug = i_frame + 10000;
-//
-//                ::sendto(
-//                        send_socket_fd,
-//                        &send_udp_buffer,
-//                        JUNGFRAU_BYTES_PER_PACKET,
-//                        0,
-//                        (sockaddr*) &server_address,
-//                        sizeof(server_address));
-//            }
-//        }
-//    });
-//
-//    handle.wait();
-//
-//    ModuleFrame metadata;
-//    auto frame_buffer = make_unique<char[]>(JUNGFRAU_DATA_BYTES_PER_FRAME);
-//
-//    for (int i_frame=0; i_frame < n_frames; i_frame++) {
-//        auto pulse_id = udp_receiver.get_frame_from_udp(
-//                metadata, frame_buffer.get());
-//
-//        ASSERT_EQ(i_frame + 1, pulse_id);
-//        ASSERT_EQ(metadata.frame_index, i_frame + 1000);
-//        ASSERT_EQ(metadata.daq_rec, i_frame + 10000);
-//        // -1 because we skipped a packet.
-//        ASSERT_EQ(metadata.n_recv_packets, n_packets);
-//    }
-//
-//    ::close(send_socket_fd);
-//}
-//
-//TEST(BufferUdpReceiver, missing_middle_packet)
-//{
-//    auto n_packets = JF_N_PACKETS_PER_FRAME;
-//    int n_frames = 3;
-//
-//    uint16_t udp_port = MOCK_UDP_PORT;
-//    auto server_address = get_server_address(udp_port);
-//    auto send_socket_fd = socket(AF_INET, SOCK_DGRAM, 0);
-//    ASSERT_TRUE(send_socket_fd >= 0);
-//
-//    JfjFrameUdpReceiver udp_receiver(udp_port, source_id);
-//
-//    auto handle = async(launch::async, [&](){
-//        for (int i_frame=0; i_frame < n_frames; i_frame++){
-//            for (size_t i_packet=0; i_packet<n_packets; i_packet++) {
-//                // Skip some random middle packet.
-//                if (i_packet == 10) {
-//                    continue;
-//                }
-//
-//                jungfrau_packet send_udp_buffer;
-//                send_udp_buffer.packetnum = i_packet;
-//                send_udp_buffer.bunchid = i_frame + 1;
-//                send_udp_buffer.framenum = i_frame + 1000;
-//                send_udp_buffer.debug = i_frame + 10000;
-//
-//                ::sendto(
-//                        send_socket_fd,
-//                        &send_udp_buffer,
-//                        JUNGFRAU_BYTES_PER_PACKET,
-//                        0,
-//                        (sockaddr*) &server_address,
-//                        sizeof(server_address));
-//            }
-//        }
-//    });
-//
-//    handle.wait();
-//
-//    ModuleFrame metadata;
-//    auto frame_buffer = make_unique<char[]>(JUNGFRAU_DATA_BYTES_PER_FRAME);
-//
-//    for (int i_frame=0; i_frame < n_frames; i_frame++) {
-//        auto pulse_id = udp_receiver.get_frame_from_udp(
-//                metadata, frame_buffer.get());
-//
-//        ASSERT_EQ(i_frame + 1, pulse_id);
-//        ASSERT_EQ(metadata.frame_index, i_frame + 1000);
-//        ASSERT_EQ(metadata.daq_rec, i_frame + 10000);
-//        // -1 because we skipped a packet.
-//        ASSERT_EQ(metadata.n_recv_packets, n_packets - 1);
-//    }
-//
-//    ::close(send_socket_fd);
-//}
-//
-//TEST(BufferUdpReceiver, missing_first_packet)
-//{
-//    auto n_packets = JF_N_PACKETS_PER_FRAME;
-//    int n_frames = 3;
-//
-//    uint16_t udp_port = MOCK_UDP_PORT;
-//    auto server_address = get_server_address(udp_port);
-//    auto send_socket_fd = socket(AF_INET, SOCK_DGRAM, 0);
-//    ASSERT_TRUE(send_socket_fd >= 0);
-//
-//    JfjFrameUdpReceiver udp_receiver(udp_port);
-//
-//    auto handle = async(launch::async, [&](){
-//        for (int i_frame=0; i_frame < n_frames; i_frame++){
-//            for (size_t i_packet=0; i_packet<n_packets; i_packet++) {
-//                // Skip first packet.
-//                if (i_packet == 0) {
-//                    continue;
-//                }
-//
-//                jungfrau_packet send_udp_buffer;
-//                send_udp_buffer.packetnum = i_packet;
-//                send_udp_buffer.bunchid = i_frame + 1;
-//                send_udp_buffer.framenum = i_frame + 1000;
-//                send_udp_buffer.debug = i_frame + 10000;
-//
-//                ::sendto(
-//                        send_socket_fd,
-//                        &send_udp_buffer,
-//                        JUNGFRAU_BYTES_PER_PACKET,
-//                        0,
-//                        (sockaddr*) &server_address,
-//                        sizeof(server_address));
-//            }
-//        }
-//    });
-//
-//    handle.wait();
-//
-//    ModuleFrame metadata;
-//    auto frame_buffer = make_unique<char[]>(JUNGFRAU_DATA_BYTES_PER_FRAME);
-//
-//    for (int i_frame=0; i_frame < n_frames; i_frame++) {
-//        auto pulse_id = udp_receiver.get_frame_from_udp(
-//                metadata, frame_buffer.get());
-//
-//        ASSERT_EQ(i_frame + 1, pulse_id);
-//        ASSERT_EQ(metadata.frame_index, i_frame + 1000);
-//        ASSERT_EQ(metadata.daq_rec, i_frame + 10000);
-//        // -1 because we skipped a packet.
-//        ASSERT_EQ(metadata.n_recv_packets, n_packets - 1);
-//    }
-//
-//    ::close(send_socket_fd);
-//}
-//
-//TEST(BufferUdpReceiver, missing_last_packet)
-//{
-//    auto n_packets = JF_N_PACKETS_PER_FRAME;
-//    int n_frames = 3;
-//
-//    uint16_t udp_port = MOCK_UDP_PORT;
-//    auto server_address = get_server_address(udp_port);
-//    auto send_socket_fd = socket(AF_INET, SOCK_DGRAM, 0);
-//    ASSERT_TRUE(send_socket_fd >= 0);
-//
-//    JfjFrameUdpReceiver udp_receiver(udp_port);
-//
-//    auto handle = async(launch::async, [&](){
-//        for (int i_frame=0; i_frame < n_frames; i_frame++){
-//            for (size_t i_packet=0; i_packet<n_packets; i_packet++) {
-//                // Skip the last packet.
-//                if (i_packet == n_packets-1) {
-//                    continue;
-//                }
-//
-//                jungfrau_packet send_udp_buffer;
-//                send_udp_buffer.packetnum = i_packet;
-//                send_udp_buffer.bunchid = i_frame + 1;
-//                send_udp_buffer.framenum = i_frame + 1000;
-//                send_udp_buffer.debug = i_frame + 10000;
-//
-//                ::sendto(
-//                        send_socket_fd,
-//                        &send_udp_buffer,
-//                        JUNGFRAU_BYTES_PER_PACKET,
-//                        0,
-//                        (sockaddr*) &server_address,
-//                        sizeof(server_address));
-//            }
-//        }
-//    });
-//
-//    handle.wait();
-//
-//    ModuleFrame metadata;
-//    auto frame_buffer = make_unique<char[]>(JUNGFRAU_DATA_BYTES_PER_FRAME);
-//
-//    // n_frames -1 because the last frame is not complete.
-//    for (int i_frame=0; i_frame < n_frames - 1; i_frame++) {
-//        auto pulse_id = udp_receiver.get_frame_from_udp(metadata, frame_buffer.get());
-//
-//        ASSERT_EQ(i_frame + 1, pulse_id);
-//        ASSERT_EQ(metadata.frame_index, i_frame + 1000);
-//        ASSERT_EQ(metadata.daq_rec, i_frame + 10000);
-//        // -1 because we skipped a packet.
-//        ASSERT_EQ(metadata.n_recv_packets, n_packets - 1);
-//    }
-//
-//    ::close(send_socket_fd);
-//}
+TEST(PacketBuffer, fill_and_span)
+{
+    MockReceiver receiver;
+    auto buffer = make_unique<PacketBuffer<jfjoch_packet_t, 64>>();
+
+    ASSERT_TRUE(buffer->is_empty());
+    ASSERT_EQ(buffer->fill_from(receiver), 50);
+    ASSERT_EQ(buffer->size(), 50);
+    ASSERT_FALSE(buffer->is_full());
+
+    ASSERT_EQ(buffer->pop_front().packetnum, 0);
+    ASSERT_EQ(buffer->peek_front().packetnum, 1);
+
+    auto span = buffer->span();
+    ASSERT_EQ(span.size, 49);
+
+    uint32_t packetnum = 1;
+    for (auto& packet : span) {
+        ASSERT_EQ(packet.packetnum, packetnum++);
+    }
+
+    buffer->consume(span.size);
+    ASSERT_TRUE(buffer->is_empty());
+    ASSERT_TRUE(buffer->span().empty());
+
+    // Next fill replaces the batch.
+    receiver.num_packets = 100;
+    ASSERT_EQ(buffer->fill_from(receiver), 64);
+    ASSERT_TRUE(buffer->is_full());
+    ASSERT_FALSE(buffer->push_back(buffer->peek_front()));
+    ASSERT_EQ(buffer->peek_front().packetnum, 50);
+}
+
+TEST(PacketBuffer, ring_handoff)
+{
+    const int n_frames = 3;
+    MockReceiver receiver;
+    receiver.num_packets = 64;
+
+    auto batches = make_unique<PacketBufferRing<jfjoch_packet_t, 64, 4>>();
+    auto frame_buffer = make_unique<char[]>(JFJOCH_DATA_BYTES_PER_FRAME);
+
+    const int n_batches = (n_frames * JFJOCH_N_PACKETS_PER_FRAME) / 64;
+
+    thread producer([&]() {
+        for (int i_batch = 0; i_batch < n_batches; i_batch++) {
+            batches->wait_write().fill_from(receiver);
+            batches->commit_write();
+        }
+    });
+
+    auto engine = make_unique<JfjochFrameEngine>();
+    auto get_frame_buffer = [&](const ModuleFrame&) {
+        return frame_buffer.get();
+    };
+
+    ModuleFrame metadata;
+
+    int i_frame = 0;
+    for (int i_batch = 0; i_batch < n_batches; i_batch++) {
+        auto& batch = batches->wait_read();
+
+        while (engine->add_packets(batch, metadata, get_frame_buffer) != 0) {
+            ASSERT_EQ(metadata.pulse_id, i_frame + 1);
+            ASSERT_EQ(metadata.frame_index, i_frame + 1000);
+            ASSERT_EQ(metadata.n_recv_packets, JFJOCH_N_PACKETS_PER_FRAME);
+
+            i_frame++;
+        }
+
+        ASSERT_TRUE(batch.is_empty());
+        batches->release_read();
+    }
+
+    producer.join();
+    ASSERT_EQ(i_frame, n_frames);
+}
@@ -0,0 +1,56 @@
+#include "gtest/gtest.h"
+#include "PulseTracer.hpp"
+
+using namespace std;
+using namespace buffer_config;
+
+TEST(PulseTracer, record)
+{
+    const int n_slots = 10;
+    PulseTracer::remove("test_detector");
+    PulseTracer tracer("test_detector", true, n_slots);
+    ASSERT_TRUE(tracer.is_enabled());
+
+    const uint64_t pulse_id = 123523;
+
+    tracer.record(TraceStage::MODULE_RECV, pulse_id, 1000, 2);
+    tracer.record(TraceStage::MODULE_COMMIT, pulse_id, 2000, 2);
+    tracer.record(TraceStage::ASSEMBLER_EMIT, pulse_id, 3000);
+
+    auto before_ns = PulseTracer::now_ns();
+    tracer.record_now(TraceStage::WRITER_WRITE, pulse_id);
+
+    auto& trace = tracer.get_trace(pulse_id);
+    ASSERT_EQ(trace.module_recv[2].pulse_id, pulse_id);
+    ASSERT_EQ(trace.module_recv[2].time_ns, 1000);
+    ASSERT_EQ(trace.module_commit[2].pulse_id, pulse_id);
+    ASSERT_EQ(trace.module_commit[2].time_ns, 2000);
+    ASSERT_EQ(trace.assembler_emit.time_ns, 3000);
+    ASSERT_EQ(trace.writer_write.pulse_id, pulse_id);
+    ASSERT_GE(trace.writer_write.time_ns, before_ns);
+
+    // Same slot, the points tell which pulse wrote them.
+    tracer.record(TraceStage::ASSEMBLER_EMIT, pulse_id + n_slots, 4000);
+    ASSERT_EQ(trace.assembler_emit.pulse_id, pulse_id + n_slots);
+    ASSERT_EQ(trace.module_recv[2].pulse_id, pulse_id);
+
+    // The trace outlives the tracer until it is removed.
+    {
+        PulseTracer other_tracer("test_detector", true, n_slots);
+    }
+    ASSERT_EQ(tracer.get_trace(pulse_id).module_recv[2].time_ns, 1000);
+    PulseTracer reader("test_detector", true, n_slots);
+    ASSERT_EQ(reader.get_trace(pulse_id).module_recv[2].time_ns, 1000);
+
+    PulseTracer::remove("test_detector");
+}
+
+TEST(PulseTracer, disabled)
+{
+    PulseTracer tracer("test_detector", false, 10);
+    ASSERT_FALSE(tracer.is_enabled());
+
+    // No-op without a buffer.
+    tracer.record_now(TraceStage::STREAM_SEND, 1234);
+    ASSERT_THROW(tracer.get_trace(1234), runtime_error);
+}
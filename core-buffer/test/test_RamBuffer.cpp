@@ -7,6 +7,7 @@ using namespace buffer_config;
 TEST(RamBuffer, simple_store)
 {
     const int n_modules = 3;
+    RamBuffer::remove("test_detector");
     RamBuffer buffer("test_detector", n_modules, 10);
 
     ModuleFrame frame_meta;
@@ -35,3 +36,280 @@ TEST(RamBuffer, simple_store)
     ASSERT_EQ(image_meta.frame_index, frame_meta.frame_index);
     ASSERT_EQ(image_meta.is_good_image, 1);
 }
+
+TEST(RamBuffer, commit_image)
+{
+    const int n_modules = 3;
+    RamBuffer::remove("test_detector");
+    RamBuffer buffer("test_detector", n_modules, 10);
+
+    ModuleFrame image_frame;
+    image_frame.pulse_id = 123523;
+    image_frame.daq_rec = 1234;
+    image_frame.frame_index = 12342300;
+
+    // Image slot is the module slots in a row.
+    ASSERT_EQ(buffer.get_image_slot(image_frame.pulse_id),
+              buffer.get_frame_slot(image_frame.pulse_id, 0));
+    ASSERT_EQ(buffer.get_image_slot(image_frame.pulse_id) + MODULE_N_BYTES,
+              buffer.get_frame_slot(image_frame.pulse_id, 1));
+
+    // Module 1 misses one packet.
+    const size_t module_n_words = JF_N_PACKETS_PER_FRAME / 64;
+    uint64_t packets_bitmap[n_modules * module_n_words];
+    memset(packets_bitmap, 0xFF, sizeof(packets_bitmap));
+    packets_bitmap[module_n_words] &= ~uint64_t(1 << 5);
+
+    buffer.commit_image(image_frame, packets_bitmap);
+
+    ModuleFrame frame_meta;
+    auto frame_buffer = make_unique<char[]>(MODULE_N_BYTES);
+    for (int i_module = 0; i_module < n_modules; i_module++) {
+        buffer.read_frame(image_frame.pulse_id, i_module,
+                          frame_meta, frame_buffer.get());
+
+        ASSERT_EQ(frame_meta.pulse_id, image_frame.pulse_id);
+        ASSERT_EQ(frame_meta.frame_index, image_frame.frame_index);
+        ASSERT_EQ(frame_meta.module_id, i_module);
+        ASSERT_EQ(frame_meta.n_recv_packets,
+                  JF_N_PACKETS_PER_FRAME - ((i_module == 1) ? 1 : 0));
+    }
+
+    ImageMetadata image_meta;
+    buffer.assemble_image(image_frame.pulse_id, image_meta);
+    ASSERT_EQ(image_meta.pulse_id, image_frame.pulse_id);
+    ASSERT_EQ(image_meta.is_good_image, 0);
+}
+
+TEST(RamBuffer, hugetlbfs_fallback)
+{
+    const int n_modules = 2;
+
+    BufferUtils::RamBufferOptions options;
+    options.pages = BufferUtils::RamBufferPages::HUGETLBFS;
+    options.hugetlbfs_dir = "/this/dir/does/not/exist";
+    options.populate = true;
+
+    // Falls back to shared memory with small pages.
+    RamBuffer::remove("test_detector");
+    RamBuffer buffer("test_detector", n_modules, 10, options);
+
+    ModuleFrame frame_meta;
+    frame_meta.pulse_id = 123523;
+    frame_meta.daq_rec = 1234;
+    frame_meta.frame_index = 12342300;
+    frame_meta.n_recv_packets = JF_N_PACKETS_PER_FRAME;
+
+    auto frame_buffer = make_unique<uint16_t[]>(MODULE_N_PIXELS);
+    for (size_t i = 0; i < MODULE_N_PIXELS; i++) {
+        frame_buffer[i] = i % 100;
+    }
+
+    for (int i_module=0; i_module<n_modules; i_module++) {
+        frame_meta.module_id = i_module;
+        buffer.write_frame(frame_meta, (char *) (frame_buffer.get()));
+    }
+
+    ModuleFrame read_meta;
+    auto read_buffer = make_unique<uint16_t[]>(MODULE_N_PIXELS);
+    buffer.read_frame(frame_meta.pulse_id, 1,
+                      read_meta, (char *) (read_buffer.get()));
+
+    ASSERT_EQ(read_meta.pulse_id, frame_meta.pulse_id);
+    ASSERT_EQ(read_meta.module_id, 1);
+    ASSERT_EQ(memcmp(read_buffer.get(), frame_buffer.get(), MODULE_N_BYTES), 0);
+}
+
+TEST(RamBuffer, overwrite_detection)
+{
+    const int n_modules = 2;
+    const int n_slots = 10;
+    RamBuffer::remove("test_detector");
+    RamBuffer buffer("test_detector", n_modules, n_slots);
+
+    ModuleFrame frame_meta;
+    frame_meta.pulse_id = 100;
+    frame_meta.daq_rec = 1234;
+    frame_meta.frame_index = 12342300;
+    frame_meta.n_recv_packets = JF_N_PACKETS_PER_FRAME;
+
+    auto frame_buffer = make_unique<char[]>(MODULE_N_BYTES);
+
+    for (int i_module=0; i_module<n_modules; i_module++) {
+        frame_meta.module_id = i_module;
+        buffer.write_frame(frame_meta, frame_buffer.get());
+    }
+
+    ModuleFrame read_meta;
+    ASSERT_TRUE(buffer.read_frame(100, 0, read_meta, frame_buffer.get()));
+
+    // Image overwritten while it is used.
+    auto generation = buffer.begin_read_image(100);
+    ASSERT_NE(generation, RamBuffer::INVALID_GENERATION);
+    ASSERT_TRUE(buffer.end_read_image(100, generation));
+
+    generation = buffer.begin_read_image(100);
+    frame_meta.pulse_id = 100 + n_slots;
+    frame_meta.module_id = 1;
+    buffer.write_frame(frame_meta, frame_buffer.get());
+    ASSERT_FALSE(buffer.end_read_image(100, generation));
+    ASSERT_EQ(buffer.get_n_torn_reads(), 1);
+
+    // Image already overwritten before it is used.
+    ASSERT_EQ(buffer.begin_read_image(100), RamBuffer::INVALID_GENERATION);
+    ASSERT_FALSE(buffer.read_frame(100, 1, read_meta, frame_buffer.get()));
+    ASSERT_EQ(buffer.get_n_stale_reads(), 2);
+
+    // Only the address, the committed frame stays readable.
+    buffer.get_frame_slot(100, 0);
+    ASSERT_TRUE(buffer.read_frame(100, 0, read_meta, frame_buffer.get()));
+
+    // Frame being written.
+    buffer.begin_frame_write(100 + n_slots, 0);
+    ASSERT_FALSE(buffer.read_frame(
+            100 + n_slots, 0, read_meta, frame_buffer.get()));
+    ASSERT_EQ(buffer.begin_read_image(100 + n_slots),
+              RamBuffer::INVALID_GENERATION);
+    ASSERT_EQ(buffer.get_n_torn_reads(), 3);
+
+    ImageMetadata image_meta;
+    buffer.assemble_image(100 + n_slots, image_meta);
+    ASSERT_EQ(image_meta.pulse_id, 100 + n_slots);
+    ASSERT_EQ(image_meta.is_good_image, 0);
+
+    frame_meta.module_id = 0;
+    buffer.commit_frame(frame_meta);
+    ASSERT_TRUE(buffer.read_frame(
+            100 + n_slots, 0, read_meta, frame_buffer.get()));
+    buffer.assemble_image(100 + n_slots, image_meta);
+    ASSERT_EQ(image_meta.is_good_image, 1);
+
+    // A write that is not committed leaves no frame behind.
+    buffer.begin_frame_write(100 + (2 * n_slots), 0);
+    buffer.abort_frame_write(100 + (2 * n_slots), 0);
+    ASSERT_FALSE(buffer.read_frame(
+            100 + n_slots, 0, read_meta, frame_buffer.get()));
+    ASSERT_FALSE(buffer.read_frame(
+            100 + (2 * n_slots), 0, read_meta, frame_buffer.get()));
+    ASSERT_NE(buffer.begin_read_image(100 + (2 * n_slots)),
+              RamBuffer::INVALID_GENERATION);
+}
+
+TEST(RamBuffer, numa_nodes)
+{
+    const int n_modules = 2;
+
+    BufferUtils::RamBufferOptions options;
+    options.numa_nodes = {0};
+    ASSERT_THROW(RamBuffer("test_detector", n_modules, 10, options),
+                 runtime_error);
+
+    options.numa_nodes = {0, 0};
+    options.populate = true;
+    RamBuffer::remove("test_detector");
+    RamBuffer buffer("test_detector", n_modules, 10, options);
+
+    ASSERT_EQ(buffer.get_module_numa_node(1), 0);
+    ASSERT_EQ(buffer.get_frame_numa_node(5, 1), 0);
+
+    RamBuffer::remove("test_detector_unbound");
+    RamBuffer unbound_buffer("test_detector_unbound", n_modules, 10);
+    ASSERT_EQ(unbound_buffer.get_module_numa_node(1), -1);
+}
+
+TEST(RamBuffer, attach_layout)
+{
+    const int n_modules = 2;
+    RamBuffer::remove("test_detector");
+
+    ModuleFrame frame_meta = {};
+    frame_meta.pulse_id = 15;
+    frame_meta.module_id = 1;
+    frame_meta.n_recv_packets = JF_N_PACKETS_PER_FRAME;
+    auto frame_buffer = make_unique<char[]>(MODULE_N_BYTES);
+
+    {
+        RamBuffer buffer("test_detector", n_modules, 10);
+        buffer.write_frame(frame_meta, frame_buffer.get());
+
+        const auto& header = buffer.get_header();
+        ASSERT_EQ(header.magic, RAM_BUFFER_MAGIC);
+        ASSERT_EQ(header.version, RAM_BUFFER_VERSION);
+        ASSERT_EQ(header.n_modules, n_modules);
+        ASSERT_EQ(header.n_slots, 10);
+        ASSERT_EQ(header.bits_per_pixel, 16);
+        ASSERT_GT(header.created_ns, 0);
+
+        // Other number of modules.
+        ASSERT_THROW(RamBuffer("test_detector", n_modules + 1, 10),
+                     runtime_error);
+    }
+
+    // The buffer outlives its creator, attaching adopts its slots.
+    RamBuffer buffer("test_detector", n_modules, 20);
+    ASSERT_EQ(buffer.get_n_slots(), 10);
+
+    ModuleFrame read_meta;
+    ASSERT_TRUE(buffer.read_frame(15, 1, read_meta, frame_buffer.get()));
+
+    RamBuffer::remove("test_detector");
+}
+
+TEST(RamBuffer, assemble_image_mismatch)
+{
+    // Not a multiple of the 8 modules of a metadata cache line.
+    const int n_modules = 11;
+    RamBuffer::remove("test_detector");
+    RamBuffer buffer("test_detector", n_modules, 10);
+
+    ModuleFrame frame_meta = {};
+    frame_meta.pulse_id = 25;
+    frame_meta.frame_index = 5;
+    frame_meta.daq_rec = 3;
+    frame_meta.n_recv_packets = JF_N_PACKETS_PER_FRAME;
+
+    for (int i_module = 0; i_module < n_modules; i_module++) {
+        frame_meta.module_id = i_module;
+        buffer.commit_frame(frame_meta);
+    }
+
+    ImageMetadata image_meta;
+    buffer.assemble_image(25, image_meta);
+    ASSERT_EQ(image_meta.frame_index, 5);
+    ASSERT_EQ(image_meta.is_good_image, 1);
+
+    // Last module with another frame_index.
+    frame_meta.frame_index = 6;
+    buffer.commit_frame(frame_meta);
+    buffer.assemble_image(25, image_meta);
+    ASSERT_EQ(image_meta.frame_index, 5);
+    ASSERT_EQ(image_meta.is_good_image, 0);
+
+    // First module incomplete, the image metadata comes from the second.
+    frame_meta.frame_index = 5;
+    buffer.commit_frame(frame_meta);
+    frame_meta.module_id = 0;
+    frame_meta.n_recv_packets = 10;
+    buffer.commit_frame(frame_meta);
+    buffer.assemble_image(25, image_meta);
+    ASSERT_EQ(image_meta.pulse_id, 25);
+    ASSERT_EQ(image_meta.daq_rec, 3);
+    ASSERT_EQ(image_meta.is_good_image, 0);
+
+    // First complete module of another pulse.
+    frame_meta.module_id = 1;
+    frame_meta.pulse_id = 15;
+    frame_meta.n_recv_packets = JF_N_PACKETS_PER_FRAME;
+    buffer.commit_frame(frame_meta);
+    ASSERT_THROW(buffer.assemble_image(25, image_meta), runtime_error);
+
+    // Unless the module did not report the pulse.
+    buffer.assemble_image(25, image_meta, 1 << 1);
+    ASSERT_EQ(image_meta.pulse_id, 25);
+    ASSERT_EQ(image_meta.frame_index, 5);
+    ASSERT_EQ(buffer.get_missing_modules(25), 1 << 1);
+    ASSERT_EQ(image_meta.is_good_image, 0);
+
+    // The slot holds the image of another pulse.
+    ASSERT_EQ(buffer.get_missing_modules(15), (1 << n_modules) - 1);
+}
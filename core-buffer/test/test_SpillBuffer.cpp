@@ -0,0 +1,115 @@
+#include <cstdlib>
+#include <memory>
+#include "gtest/gtest.h"
+#include "SpillBuffer.hpp"
+
+using namespace std;
+using namespace buffer_config;
+
+TEST(SpillBuffer, read_after_overwrite)
+{
+    const int n_modules = 2;
+    const int n_slots = 10;
+    const string filename = "test_spill_buffer.bin";
+    remove(filename.c_str());
+
+    RamBuffer::remove("test_detector");
+    RamBuffer ram_buffer("test_detector", n_modules, n_slots);
+
+    // No spill file yet.
+    SpillBuffer reader(filename, n_modules, 100);
+    ModuleFrame meta;
+    auto data = make_unique<char[]>(n_modules * MODULE_N_BYTES);
+    ASSERT_FALSE(reader.read_spilled_frame(5, 0, meta, data.get()));
+
+    SpillBuffer writer(filename, n_modules, 100, true);
+    auto record = (char*) aligned_alloc(SPILL_BUFFER_ALIGNMENT,
+                                        writer.get_record_bytes());
+
+    ModuleFrame frame_meta = {};
+    frame_meta.n_recv_packets = JF_N_PACKETS_PER_FRAME;
+    auto frame_buffer = make_unique<uint16_t[]>(MODULE_N_PIXELS);
+
+    for (uint64_t pulse_id = 1; pulse_id <= 20; pulse_id++) {
+        for (int i_module = 0; i_module < n_modules; i_module++) {
+            frame_meta.pulse_id = pulse_id;
+            frame_meta.frame_index = pulse_id + 100;
+            frame_meta.module_id = i_module;
+            frame_buffer[0] = pulse_id;
+            frame_buffer[MODULE_N_PIXELS - 1] = i_module;
+
+            ram_buffer.write_frame(frame_meta, (char*) frame_buffer.get());
+        }
+
+        ASSERT_EQ(writer.copy_image(ram_buffer, pulse_id, record), n_modules);
+        writer.write_record(record);
+    }
+
+    // Pulse 5 only on disk, pulse 15 still in RAM.
+    for (uint64_t pulse_id : {5, 15}) {
+        for (int i_module = 0; i_module < n_modules; i_module++) {
+            ASSERT_TRUE(reader.read_frame(
+                    ram_buffer, pulse_id, i_module, meta, data.get()));
+            ASSERT_EQ(meta.pulse_id, pulse_id);
+            ASSERT_EQ(meta.frame_index, pulse_id + 100);
+            ASSERT_EQ(meta.module_id, i_module);
+
+            auto pixels = (uint16_t*) data.get();
+            ASSERT_EQ(pixels[0], pulse_id);
+            ASSERT_EQ(pixels[MODULE_N_PIXELS - 1], i_module);
+        }
+    }
+
+    ASSERT_TRUE(reader.read_spilled_image(5, data.get()));
+    auto pixels = (uint16_t*) data.get();
+    ASSERT_EQ(pixels[0], 5);
+    ASSERT_EQ(pixels[MODULE_N_PIXELS], 5);
+    ASSERT_EQ(pixels[(2 * MODULE_N_PIXELS) - 1], 1);
+
+    // Never spilled, or already overwritten in the spill file.
+    ASSERT_FALSE(reader.read_spilled_frame(25, 0, meta, data.get()));
+    ASSERT_FALSE(reader.read_spilled_image(105, data.get()));
+
+    // Frames overwritten before the copy are not spilled.
+    frame_meta.pulse_id = 31;
+    frame_meta.module_id = 0;
+    ram_buffer.write_frame(frame_meta, (char*) frame_buffer.get());
+    ASSERT_EQ(writer.copy_image(ram_buffer, 21, record), 0);
+    ASSERT_EQ(writer.copy_image(ram_buffer, 31, record), 1);
+    writer.write_record(record);
+    ASSERT_TRUE(reader.read_spilled_frame(31, 0, meta, data.get()));
+    ASSERT_FALSE(reader.read_spilled_frame(31, 1, meta, data.get()));
+
+    // The missing module is zeroed, the partial image is not recovered.
+    auto record_pixels = (uint16_t*) (record + writer.get_record_bytes() -
+                                      (n_modules * MODULE_N_BYTES));
+    ASSERT_EQ(record_pixels[MODULE_N_PIXELS], 0);
+    ASSERT_EQ(record_pixels[(2 * MODULE_N_PIXELS) - 1], 0);
+    ASSERT_FALSE(reader.read_spilled_image(31, data.get()));
+
+    free(record);
+    remove(filename.c_str());
+}
+
+TEST(SpillBuffer, open_during_create)
+{
+    const int n_modules = 1;
+    const string filename = "test_spill_buffer.bin";
+    remove(filename.c_str());
+
+    // File created, but not resized by the writer yet.
+    FILE* file = fopen(filename.c_str(), "w");
+    fclose(file);
+
+    SpillBuffer reader(filename, n_modules, 10);
+    ModuleFrame meta;
+    auto data = make_unique<char[]>(MODULE_N_BYTES);
+    ASSERT_FALSE(reader.read_spilled_frame(5, 0, meta, data.get()));
+
+    // Readable once the writer resized it.
+    SpillBuffer writer(filename, n_modules, 10, true);
+    ASSERT_FALSE(reader.read_spilled_frame(5, 0, meta, data.get()));
+    ASSERT_FALSE(reader.read_spilled_image(5, data.get()));
+
+    remove(filename.c_str());
+}
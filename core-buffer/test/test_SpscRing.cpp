@@ -0,0 +1,53 @@
+#include "gtest/gtest.h"
+#include "SpscRing.hpp"
+
+#include <thread>
+
+using namespace std;
+
+TEST(SpscRing, full_and_empty)
+{
+    SpscRing<int, 4> ring;
+
+    ASSERT_EQ(ring.acquire_read(), nullptr);
+
+    for (int i = 0; i < 4; i++) {
+        auto slot = ring.acquire_write();
+        ASSERT_NE(slot, nullptr);
+        *slot = i;
+        ring.commit_write();
+    }
+
+    ASSERT_EQ(ring.acquire_write(), nullptr);
+    ASSERT_EQ(ring.size(), 4);
+
+    for (int i = 0; i < 4; i++) {
+        auto slot = ring.acquire_read();
+        ASSERT_NE(slot, nullptr);
+        ASSERT_EQ(*slot, i);
+        ring.release_read();
+    }
+
+    ASSERT_EQ(ring.acquire_read(), nullptr);
+    ASSERT_EQ(ring.size(), 0);
+}
+
+TEST(SpscRing, cross_thread)
+{
+    const uint64_t n_items = 100000;
+    auto ring = make_unique<SpscRing<uint64_t, 8>>();
+
+    thread producer([&]() {
+        for (uint64_t i = 0; i < n_items; i++) {
+            ring->wait_write() = i;
+            ring->commit_write();
+        }
+    });
+
+    for (uint64_t i = 0; i < n_items; i++) {
+        ASSERT_EQ(ring->wait_read(), i);
+        ring->release_read();
+    }
+
+    producer.join();
+}
@@ -4,14 +4,25 @@
 #include <chrono>
 #include <string>
 #include <formats.hpp>
+#include <EventStream.hpp>
+
+#include "assembler_config.hpp"
+#include "ZmqPulseSyncReceiver.hpp"
 
 class AssemblerStats {
     const std::string detector_name_;
     const size_t stats_modulo_;
+    const ZmqPulseSyncReceiver& receiver_;
+    const EventSender& sender_;
+    uint64_t n_dropped_events_reported_ = 0;
 
     int image_counter_;
     int n_corrupted_images_;
     int n_sync_lost_images_;
+    int n_partial_images_;
+    int n_resyncs_;
+    // Bin i counts the images after 2^i to 2^(i+1)-1 lost pulses.
+    int lost_pulses_hist_[assembler_config::LOST_PULSES_N_BINS];
     std::chrono::time_point<std::chrono::steady_clock> stats_interval_start_;
 
     void reset_counters();
@@ -19,9 +30,14 @@ class AssemblerStats {
 
 public:
     AssemblerStats(const std::string &detector_name,
-                   const size_t stats_modulo);
-
-    void record_stats(const ImageMetadata &meta, const uint32_t n_lost_pulses);
+                   const size_t stats_modulo,
+                   const ZmqPulseSyncReceiver& receiver,
+                   const EventSender& sender);
+
+    void record_stats(const ImageMetadata &meta,
+                      const uint32_t n_lost_pulses,
+                      const uint64_t missing_modules=0,
+                      const uint32_t n_resyncs=0);
 };
 
 
@@ -0,0 +1,42 @@
+#ifndef SF_DAQ_BUFFER_DETECTORASSEMBLER_HPP
+#define SF_DAQ_BUFFER_DETECTORASSEMBLER_HPP
+
+#include <atomic>
+#include <BufferUtils.hpp>
+#include <EventStream.hpp>
+#include <RamBuffer.hpp>
+#include <PulseTracer.hpp>
+
+#include "AssemblerStats.hpp"
+#include "ZmqPulseSyncReceiver.hpp"
+
+/** Image assembly of one detector
+
+    Its module receivers, "assembler" output stream, RamBuffer and stats.
+    Driven by the worker threads of jf-assembler, one at a time: a worker
+    claims the detector before it uses it. **/
+class DetectorAssembler {
+    const BufferUtils::DetectorConfig config_;
+
+    EventSender sender_;
+    ZmqPulseSyncReceiver receiver_;
+    RamBuffer ram_buffer_;
+    AssemblerStats stats_;
+    PulseTracer tracer_;
+
+    std::atomic<bool> is_claimed_;
+
+public:
+    DetectorAssembler(void* ctx, const BufferUtils::DetectorConfig& config);
+
+    bool claim();
+    void release();
+
+    // Assemble and send the next image if its pulse is ready, no waiting.
+    bool assemble_next();
+    // Wait at most timeout_ms for the modules of the next pulse.
+    void wait(const int timeout_ms);
+};
+
+
+#endif //SF_DAQ_BUFFER_DETECTORASSEMBLER_HPP
@@ -3,31 +3,83 @@
 
 
 #include <cstddef>
+#include <limits>
+#include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
 #include "formats.hpp"
+#include "BufferUtils.hpp"
+#include "EventStream.hpp"
+
+static_assert(JUNGFRAU_N_MODULES <= 64,
+              "PulseAndSync.missing_modules has one bit per module.");
 
 struct PulseAndSync {
     const uint64_t pulse_id;
     const uint32_t n_lost_pulses;
+    // Bit i set if module i did not report the pulse before the deadline.
+    const uint64_t missing_modules;
+    // Times the modules were resynchronized since the last pulse.
+    const uint32_t n_resyncs;
 };
 
+/** Next pulse of the detector from the pulse_ids of the modules
+
+    Keeps the next pulse_id reported by each module. The oldest of them
+    is returned as soon as every module reported it or a newer pulse, or
+    when deadline_ms passed since the first module reported it. Modules
+    that did not report it are returned as missing, and are absent
+    until they report again: the next pulses do not wait for them, so a
+    dead module neither stops the detector nor lowers its image rate.
+    Reports of pulses already returned are dropped. When the modules
+    drift apart more than PULSE_OFFSET_LIMIT pulses, all modules skip to
+    the newest pulse: the older reports are dropped without waiting for
+    the lagging modules. **/
 class ZmqPulseSyncReceiver {
 
     void* ctx_;
     const int n_modules_;
+    const int64_t deadline_timeout_ns_;
+
+    std::vector<std::unique_ptr<EventReceiver>> receivers_;
 
-    std::vector<void*> sockets_;
+    // Next pulse_id of each module, 0 if none received yet.
+    std::vector<uint64_t> pending_pulse_ids_;
+    // Steady clock time the pending pulse_id was received.
+    std::vector<int64_t> pending_times_ns_;
+    uint64_t last_pulse_id_ = 0;
+    uint32_t n_late_pulses_ = 0;
+    uint32_t n_resyncs_ = 0;
+    // Missed the last pulse without reporting a newer one.
+    std::vector<bool> is_absent_;
+    // Deadline of the oldest pending pulse, max if there is none.
+    int64_t deadline_ns_ = std::numeric_limits<int64_t>::max();
+    // Module to wait on next, round robin over the missing ones.
+    int i_wait_module_ = 0;
+
+    bool poll_module(const int i_module, int timeout_ms);
+    void resync(const uint64_t max_pulse_id);
 
 public:
     ZmqPulseSyncReceiver(
             void* ctx,
             const std::string& detector_name,
-            const int n_modules);
-    ~ZmqPulseSyncReceiver();
+            const int n_modules,
+            const BufferUtils::EventTransport transport=
+                    BufferUtils::EventTransport::ZMQ,
+            const int deadline_ms=buffer_config::ASSEMBLER_DEADLINE_MS);
+
+    // The next pulse if it is ready, does not wait.
+    std::optional<PulseAndSync> try_get_next_pulse_id();
+    // Wait at most timeout_ms (or until the deadline of the pending pulse)
+    // for a module the next pulse waits for.
+    void wait(const int timeout_ms);
+    PulseAndSync get_next_pulse_id();
 
-    PulseAndSync get_next_pulse_id() const;
+    // Pulse_ids lost by the slow module receivers, 0 with ZMQ.
+    uint64_t get_n_dropped_events() const;
 };
 
 
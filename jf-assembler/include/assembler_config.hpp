@@ -1,14 +1,34 @@
+#ifndef SF_DAQ_BUFFER_ASSEMBLER_CONFIG_HPP
+#define SF_DAQ_BUFFER_ASSEMBLER_CONFIG_HPP
+
+#include <cstddef>
+#include <cstdint>
+
 namespace assembler_config
 {
     // N of IO threads to send image metadata.
     const int ASSEMBLER_ZMQ_IO_THREADS = 1;
 
-    // If the modules are offset more than 1000 pulses, crush.
+    // If the modules are offset more than this, skip to the newest pulse.
     const uint64_t PULSE_OFFSET_LIMIT = 100;
 
-    // Number of times we try to re-sync in case of failure.
-    const int SYNC_RETRY_LIMIT = 3;
+    // Timeout of each module poll while no pulse is pending.
+    const int IDLE_POLL_MS = 5;
+
+    // Threads assembling the images of all detectors of the process.
+    const int ASSEMBLER_N_WORKERS = 2;
+
+    // Images a worker assembles for a detector before it moves on.
+    const int WORKER_BATCH_IMAGES = 8;
+
+    // How long an idle worker waits on the modules of one detector.
+    const int WORKER_WAIT_MS = 1;
+
+    // Power of 2 bins of the lost pulses histogram, the last is open.
+    const int LOST_PULSES_N_BINS = 8;
 
     // Number of pulses between each statistics print out.
     const size_t ASSEMBLER_STATS_MODULO = 1000;
 }
+
+#endif //SF_DAQ_BUFFER_ASSEMBLER_CONFIG_HPP
@@ -1,15 +1,21 @@
 #include "AssemblerStats.hpp"
 
 #include <iostream>
+#include <sstream>
 
 using namespace std;
 using namespace chrono;
+using namespace assembler_config;
 
 AssemblerStats::AssemblerStats(
         const std::string &detector_name,
-        const size_t stats_modulo) :
+        const size_t stats_modulo,
+        const ZmqPulseSyncReceiver& receiver,
+        const EventSender& sender) :
             detector_name_(detector_name),
-            stats_modulo_(stats_modulo)
+            stats_modulo_(stats_modulo),
+            receiver_(receiver),
+            sender_(sender)
 {
     reset_counters();
 }
@@ -19,19 +25,38 @@ void AssemblerStats::reset_counters()
     image_counter_ = 0;
     n_sync_lost_images_ = 0;
     n_corrupted_images_ = 0;
+    n_partial_images_ = 0;
+    n_resyncs_ = 0;
+    for (auto& n_images : lost_pulses_hist_) {
+        n_images = 0;
+    }
     stats_interval_start_ = steady_clock::now();
 }
 
 void AssemblerStats::record_stats(
-        const ImageMetadata &meta, const uint32_t n_lost_pulses)
+        const ImageMetadata &meta,
+        const uint32_t n_lost_pulses,
+        const uint64_t missing_modules,
+        const uint32_t n_resyncs)
 {
     image_counter_++;
     n_sync_lost_images_ += n_lost_pulses;
+    n_resyncs_ += n_resyncs;
+
+    if (n_lost_pulses > 0) {
+        // Index of the highest bit set.
+        const int i_bin = 31 - __builtin_clz(n_lost_pulses);
+        lost_pulses_hist_[min(i_bin, LOST_PULSES_N_BINS - 1)]++;
+    }
 
     if (!meta.is_good_image) {
         n_corrupted_images_++;
     }
 
+    if (missing_modules != 0) {
+        n_partial_images_++;
+    }
+
     if (image_counter_ == stats_modulo_) {
         print_stats();
         reset_counters();
@@ -44,19 +69,35 @@ void AssemblerStats::print_stats()
             steady_clock::now()-stats_interval_start_).count();
     // * 1000 because milliseconds, + 250 because of truncation.
     int rep_rate = ((image_counter_ * 1000) + 250) / interval_ms_duration;
+    const auto n_dropped_events = receiver_.get_n_dropped_events();
     uint64_t timestamp = time_point_cast<nanoseconds>(
             system_clock::now()).time_since_epoch().count();
 
     // Output in InfluxDB line protocol
-    cout << "jf_assembler";
-    cout << ",detector_name=" << detector_name_;
-    cout << " ";
-    cout << "n_processed_images=" << image_counter_ << "i";
-    cout << ",n_corrupted_images=" << n_corrupted_images_ << "i";
-    cout << ",n_sync_lost_images=" << n_sync_lost_images_ << "i";
-    cout << ",repetition_rate=" << rep_rate << "i";
-    cout << " ";
-    cout << timestamp;
-    cout << endl;
+    stringstream out;
+    out << "jf_assembler";
+    out << ",detector_name=" << detector_name_;
+    out << " ";
+    out << "n_processed_images=" << image_counter_ << "i";
+    out << ",n_corrupted_images=" << n_corrupted_images_ << "i";
+    out << ",n_sync_lost_images=" << n_sync_lost_images_ << "i";
+    out << ",n_partial_images=" << n_partial_images_ << "i";
+    out << ",n_resyncs=" << n_resyncs_ << "i";
+    for (int i_bin = 0; i_bin < LOST_PULSES_N_BINS; i_bin++) {
+        out << ",lost_pulses_" << (1 << i_bin) << "=";
+        out << lost_pulses_hist_[i_bin] << "i";
+    }
+    out << ",n_dropped_events=";
+    out << n_dropped_events - n_dropped_events_reported_ << "i";
+    out << ",max_event_lag=" << sender_.get_max_lag() << "i";
+    out << ",repetition_rate=" << rep_rate << "i";
+    out << " ";
+    out << timestamp;
+    out << endl;
+
+    // One write, the workers print the stats of several detectors.
+    cout << out.str() << flush;
+
+    n_dropped_events_reported_ = n_dropped_events;
 }
 
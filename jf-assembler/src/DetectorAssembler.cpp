@@ -0,0 +1,61 @@
+#include "DetectorAssembler.hpp"
+
+#include "assembler_config.hpp"
+
+using namespace std;
+using namespace buffer_config;
+using namespace assembler_config;
+
+DetectorAssembler::DetectorAssembler(
+        void* ctx, const BufferUtils::DetectorConfig& config) :
+            config_(config),
+            sender_(ctx, config_.detector_name, "assembler",
+                    sizeof(ImageMetadata), config_.event_transport),
+            receiver_(ctx, config_.detector_name, config_.n_modules,
+                      config_.event_transport,
+                      config_.assembler_deadline_ms),
+            ram_buffer_(config_.detector_name, config_.n_modules,
+                        config_.ram_buffer.n_slots, config_.ram_buffer),
+            stats_(config_.detector_name, ASSEMBLER_STATS_MODULO,
+                   receiver_, sender_),
+            tracer_(config_.detector_name, config_.latency_trace,
+                    config_.ram_buffer.n_slots),
+            is_claimed_(false)
+{
+}
+
+bool DetectorAssembler::claim()
+{
+    return !is_claimed_.exchange(true, memory_order_acquire);
+}
+
+void DetectorAssembler::release()
+{
+    is_claimed_.store(false, memory_order_release);
+}
+
+bool DetectorAssembler::assemble_next()
+{
+    const auto pulse_and_sync = receiver_.try_get_next_pulse_id();
+    if (!pulse_and_sync) {
+        return false;
+    }
+
+    ImageMetadata meta;
+    ram_buffer_.assemble_image(pulse_and_sync->pulse_id, meta,
+                               pulse_and_sync->missing_modules);
+
+    sender_.send(&meta);
+    tracer_.record_now(TraceStage::ASSEMBLER_EMIT, meta.pulse_id);
+
+    stats_.record_stats(meta, pulse_and_sync->n_lost_pulses,
+                        pulse_and_sync->missing_modules,
+                        pulse_and_sync->n_resyncs);
+
+    return true;
+}
+
+void DetectorAssembler::wait(const int timeout_ms)
+{
+    receiver_.wait(timeout_ms);
+}
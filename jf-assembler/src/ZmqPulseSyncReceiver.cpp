@@ -1,11 +1,11 @@
 #include "ZmqPulseSyncReceiver.hpp"
 #include "BufferUtils.hpp"
 
-#include <zmq.h>
 #include <stdexcept>
 #include <sstream>
 #include <chrono>
 #include <algorithm>
+#include <limits>
 #include <iostream>
 
 #include "assembler_config.hpp"
@@ -15,101 +15,198 @@ using namespace chrono;
 using namespace buffer_config;
 using namespace assembler_config;
 
+namespace {
+    int64_t now_ns()
+    {
+        return duration_cast<nanoseconds>(
+                steady_clock::now().time_since_epoch()).count();
+    }
+}
 
 ZmqPulseSyncReceiver::ZmqPulseSyncReceiver(
         void * ctx,
         const string& detector_name,
-        const int n_modules) :
+        const int n_modules,
+        const BufferUtils::EventTransport transport,
+        const int deadline_ms) :
             ctx_(ctx),
-            n_modules_(n_modules)
+            n_modules_(n_modules),
+            deadline_timeout_ns_(deadline_ms * 1000000L),
+            pending_pulse_ids_(n_modules, 0),
+            pending_times_ns_(n_modules, 0),
+            is_absent_(n_modules, false)
 {
-    sockets_.reserve(n_modules_);
+    receivers_.reserve(n_modules_);
 
     for (int i=0; i<n_modules_; i++) {
-        sockets_.push_back(
-                BufferUtils::connect_socket(ctx_, detector_name, to_string(i)));
+        receivers_.push_back(make_unique<EventReceiver>(
+                ctx_, detector_name, to_string(i),
+                sizeof(uint64_t), transport));
     }
 }
 
-ZmqPulseSyncReceiver::~ZmqPulseSyncReceiver()
+bool ZmqPulseSyncReceiver::poll_module(const int i_module, int timeout_ms)
 {
-    for (auto& socket:sockets_) {
-        zmq_close(socket);
+    uint64_t pulse_id;
+    while (receivers_[i_module]->recv(&pulse_id, timeout_ms)) {
+        is_absent_[i_module] = false;
+
+        if (pulse_id > last_pulse_id_) {
+            pending_pulse_ids_[i_module] = pulse_id;
+            pending_times_ns_[i_module] = now_ns();
+            return true;
+        }
+
+        // Too late for its image, drain the older reports.
+        n_late_pulses_++;
+        timeout_ms = 0;
     }
+
+    return false;
 }
 
-PulseAndSync ZmqPulseSyncReceiver::get_next_pulse_id() const
+void ZmqPulseSyncReceiver::resync(const uint64_t max_pulse_id)
 {
-    uint64_t pulses[n_modules_];
+    n_resyncs_++;
+    last_pulse_id_ = max_pulse_id - 1;
 
-    bool modules_in_sync = true;
     for (int i = 0; i < n_modules_; i++) {
-        zmq_recv(sockets_[i], &pulses[i], sizeof(uint64_t), 0);
-
-        if (pulses[0] != pulses[i]) {
-            modules_in_sync = false;
+        if (pending_pulse_ids_[i] == 0 ||
+            pending_pulse_ids_[i] == max_pulse_id) {
+            continue;
         }
-    }
 
-    if (modules_in_sync) {
-        return {pulses[0], 0};
+        // Drain what the module has queued, without waiting for it.
+        pending_pulse_ids_[i] = 0;
+        n_late_pulses_++;
+        poll_module(i, 0);
     }
+}
+
+optional<PulseAndSync> ZmqPulseSyncReceiver::try_get_next_pulse_id()
+{
+    uint64_t min_pulse_id;
+    uint64_t max_pulse_id;
+    int n_waiting_modules;
 
-    // How many pulses we lost in total to get the next pulse_id.
-    uint32_t n_lost_pulses = 0;
-    for (int i_sync=0; i_sync < SYNC_RETRY_LIMIT; i_sync++) {
-        uint64_t min_pulse_id = numeric_limits<uint64_t>::max();;
-        uint64_t max_pulse_id = 0;
+    while (true) {
+        min_pulse_id = numeric_limits<uint64_t>::max();
+        max_pulse_id = 0;
+        n_waiting_modules = 0;
 
         for (int i = 0; i < n_modules_; i++) {
-            min_pulse_id = min(min_pulse_id, pulses[i]);
-            max_pulse_id = max(max_pulse_id, pulses[i]);
+            if (pending_pulse_ids_[i] == 0 && !poll_module(i, 0)) {
+                // Absent modules do not hold back the pulses.
+                n_waiting_modules += is_absent_[i] ? 0 : 1;
+                continue;
+            }
+
+            min_pulse_id = min(min_pulse_id, pending_pulse_ids_[i]);
+            max_pulse_id = max(max_pulse_id, pending_pulse_ids_[i]);
         }
 
-        auto max_diff = max_pulse_id - min_pulse_id;
-        if (max_diff > PULSE_OFFSET_LIMIT) {
-            stringstream err_msg;
-            err_msg << "[ZmqPulseSyncReceiver::get_next_pulse_id]";
-            err_msg << " PULSE_OFFSET_LIMIT exceeded.";
-            err_msg << " max_diff=" << max_diff << " pulses.";
+        if (max_pulse_id > 0 &&
+            max_pulse_id - min_pulse_id > PULSE_OFFSET_LIMIT) {
+            resync(max_pulse_id);
+            continue;
+        }
 
-            for (int i = 0; i < n_modules_; i++) {
-                err_msg << " (module " << i << ", ";
-                err_msg << pulses[i] << "),";
-            }
-            err_msg << endl;
+        break;
+    }
 
-            throw runtime_error(err_msg.str());
+    deadline_ns_ = numeric_limits<int64_t>::max();
+    if (max_pulse_id == 0) {
+        return nullopt;
+    }
+
+    // The deadline runs from the first report of the pulse.
+    for (int i = 0; i < n_modules_; i++) {
+        if (pending_pulse_ids_[i] == min_pulse_id) {
+            deadline_ns_ = min(deadline_ns_,
+                               pending_times_ns_[i] + deadline_timeout_ns_);
         }
+    }
 
-        modules_in_sync = true;
-        // Max pulses we lost in this sync attempt.
-        uint32_t i_sync_lost_pulses = 0;
-        for (int i = 0; i < n_modules_; i++) {
-            // How many pulses we lost for this specific module.
-            uint32_t i_module_lost_pulses = 0;
-            while (pulses[i] < max_pulse_id) {
-                zmq_recv(sockets_[i], &pulses[i], sizeof(uint64_t), 0);
-                i_module_lost_pulses++;
-            }
+    if (n_waiting_modules > 0 && deadline_ns_ > now_ns()) {
+        return nullopt;
+    }
 
-            i_sync_lost_pulses = max(i_sync_lost_pulses, i_module_lost_pulses);
+    // Modules with a newer pulse lost this one, modules without a report
+    // are absent until they report again.
+    uint64_t missing_modules = 0;
+    for (int i = 0; i < n_modules_; i++) {
+        if (pending_pulse_ids_[i] == min_pulse_id) {
+            pending_pulse_ids_[i] = 0;
+        } else {
+            missing_modules |= uint64_t(1) << i;
+            is_absent_[i] = pending_pulse_ids_[i] == 0;
+        }
+    }
 
-            if (pulses[i] != max_pulse_id) {
-                modules_in_sync = false;
-            }
+    const auto n_lost_pulses = n_late_pulses_;
+    const auto n_resyncs = n_resyncs_;
+    n_late_pulses_ = 0;
+    n_resyncs_ = 0;
+    last_pulse_id_ = min_pulse_id;
+    deadline_ns_ = numeric_limits<int64_t>::max();
+
+    return PulseAndSync{min_pulse_id, n_lost_pulses, missing_modules, n_resyncs};
+}
+
+void ZmqPulseSyncReceiver::wait(const int timeout_ms)
+{
+    const bool has_pulse = deadline_ns_ != numeric_limits<int64_t>::max();
+
+    // A pulse waits only for the present modules. Without a pulse any
+    // module can report first, the absent ones last.
+    int i_wait_module = -1;
+    for (int i = 0; i < n_modules_ && i_wait_module == -1; i++) {
+        const int i_module = (i_wait_module_ + i) % n_modules_;
+        if (pending_pulse_ids_[i_module] == 0 && !is_absent_[i_module]) {
+            i_wait_module = i_module;
         }
-        n_lost_pulses += i_sync_lost_pulses;
+    }
 
-        if (modules_in_sync) {
-            return {pulses[0], n_lost_pulses};
+    for (int i = 0; i < n_modules_ && i_wait_module == -1 && !has_pulse; i++) {
+        const int i_module = (i_wait_module_ + i) % n_modules_;
+        if (pending_pulse_ids_[i_module] == 0) {
+            i_wait_module = i_module;
         }
     }
 
-    stringstream err_msg;
-    err_msg << "[ZmqLiveReceiver::get_next_pulse_id]";
-    err_msg << " SYNC_RETRY_LIMIT exceeded.";
-    err_msg << endl;
+    if (i_wait_module == -1) {
+        return;
+    }
+
+    int wait_ms = timeout_ms;
+    if (has_pulse) {
+        const auto remaining_ns = max(deadline_ns_ - now_ns(), int64_t(0));
+        wait_ms = min(wait_ms, (int) ((remaining_ns + 999999) / 1000000));
+    }
+
+    poll_module(i_wait_module, wait_ms);
+    i_wait_module_ = (i_wait_module + 1) % n_modules_;
+}
+
+uint64_t ZmqPulseSyncReceiver::get_n_dropped_events() const
+{
+    uint64_t n_dropped_events = 0;
+    for (const auto& receiver : receivers_) {
+        n_dropped_events += receiver->get_n_dropped();
+    }
 
-    throw runtime_error(err_msg.str());
+    return n_dropped_events;
+}
+
+PulseAndSync ZmqPulseSyncReceiver::get_next_pulse_id()
+{
+    while (true) {
+        auto pulse = try_get_next_pulse_id();
+        if (pulse) {
+            return *pulse;
+        }
+
+        // Without a pulse the module we wait on might be dead.
+        wait(IDLE_POLL_MS);
+    }
 }
@@ -1,47 +1,91 @@
+#include <algorithm>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <thread>
+#include <vector>
 #include <zmq.h>
-#include <RamBuffer.hpp>
 #include <BufferUtils.hpp>
-#include <AssemblerStats.hpp>
 
 #include "assembler_config.hpp"
-#include "ZmqPulseSyncReceiver.hpp"
+#include "DetectorAssembler.hpp"
 
 using namespace std;
 using namespace buffer_config;
 using namespace assembler_config;
 
+void assemble_detectors(
+        vector<unique_ptr<DetectorAssembler>>& detectors, const int i_worker)
+{
+    const int n_detectors = detectors.size();
+    // Workers start their sweeps at different detectors.
+    int i_next = i_worker % n_detectors;
+
+    while (true) {
+        bool is_idle = true;
+
+        for (int i = 0; i < n_detectors; i++) {
+            auto& detector = *detectors[(i_next + i) % n_detectors];
+            if (!detector.claim()) {
+                continue;
+            }
+
+            // Bounded, so one busy detector does not starve the others.
+            for (int i_image = 0; i_image < WORKER_BATCH_IMAGES &&
+                                  detector.assemble_next(); i_image++) {
+                is_idle = false;
+            }
+
+            detector.release();
+        }
+
+        if (!is_idle) {
+            continue;
+        }
+
+        // Nothing ready, sleep on the modules of the next free detector.
+        for (int i = 0; i < n_detectors; i++) {
+            auto& detector = *detectors[i_next];
+            i_next = (i_next + 1) % n_detectors;
+
+            if (detector.claim()) {
+                detector.wait(WORKER_WAIT_MS);
+                detector.release();
+                break;
+            }
+        }
+    }
+}
+
 int main (int argc, char *argv[])
 {
-    if (argc != 2) {
+    if (argc < 2) {
         cout << endl;
-        cout << "Usage: jf_assembler [detector_json_filename]" << endl;
-        cout << "\tdetector_json_filename: detector config file path." << endl;
+        cout << "Usage: jf_assembler [detector_json_filename] ..." << endl;
+        cout << "\tdetector_json_filename: detector config file path,";
+        cout << " one per detector." << endl;
         cout << endl;
 
         exit(-1);
     }
 
-    auto config = BufferUtils::read_json_config(string(argv[1]));
-    auto const stream_name = "assembler";
-
     auto ctx = zmq_ctx_new();
     zmq_ctx_set(ctx, ZMQ_IO_THREADS, ASSEMBLER_ZMQ_IO_THREADS);
-    auto sender = BufferUtils::bind_socket(
-            ctx, config.detector_name, stream_name);
 
-    ZmqPulseSyncReceiver receiver(ctx, config.detector_name, config.n_modules);
-    RamBuffer ram_buffer(config.detector_name, config.n_modules);
-    AssemblerStats stats(config.detector_name, ASSEMBLER_STATS_MODULO);
+    vector<unique_ptr<DetectorAssembler>> detectors;
+    for (int i_arg = 1; i_arg < argc; i_arg++) {
+        const auto config = BufferUtils::read_json_config(string(argv[i_arg]));
+        detectors.push_back(make_unique<DetectorAssembler>(ctx, config));
+    }
 
-    ImageMetadata meta;
-    while (true) {
-        auto pulse_and_sync = receiver.get_next_pulse_id();
-        ram_buffer.assemble_image(pulse_and_sync.pulse_id, meta);
+    const int n_workers = min((int) detectors.size(), ASSEMBLER_N_WORKERS);
 
-        zmq_send(sender, &meta, sizeof(meta), 0);
+    vector<thread> workers;
+    for (int i_worker = 0; i_worker < n_workers; i_worker++) {
+        workers.emplace_back(assemble_detectors, ref(detectors), i_worker);
+    }
 
-        stats.record_stats(meta, pulse_and_sync.n_lost_pulses);
+    for (auto& worker : workers) {
+        worker.join();
     }
 }
@@ -1,4 +1,6 @@
 #include "gtest/gtest.h"
+#include "test_ZmqPulseSyncReceiver.cpp"
+#include "test_DetectorAssembler.cpp"
 
 using namespace std;
 
@@ -0,0 +1,100 @@
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <vector>
+#include "gtest/gtest.h"
+#include "EventRing.hpp"
+#include "DetectorAssembler.hpp"
+
+using namespace std;
+using namespace buffer_config;
+
+namespace {
+    BufferUtils::DetectorConfig write_config(const string& detector_name)
+    {
+        const auto filename = detector_name + ".json";
+        ofstream config_file(filename);
+        config_file << "{\"streamvis_stream\": \"\", \"streamvis_rate\": 1,"
+                       " \"live_stream\": \"\", \"live_rate\": 1,"
+                       " \"pedestal_file\": \"\", \"gain_file\": \"\","
+                       " \"detector_name\": \"" << detector_name << "\","
+                       " \"n_modules\": 2, \"start_udp_port\": 50020,"
+                       " \"buffer_folder\": \"\", \"ram_buffer_n_slots\": 10,"
+                       " \"event_transport\": \"shm\"}";
+        config_file.close();
+
+        const auto config = BufferUtils::read_json_config(filename);
+        remove(filename.c_str());
+
+        return config;
+    }
+}
+
+TEST(DetectorAssembler, two_detectors)
+{
+    vector<string> detector_names = {"test_detector_a", "test_detector_b"};
+    vector<unique_ptr<DetectorAssembler>> detectors;
+    vector<unique_ptr<RamBuffer>> ram_buffers;
+    vector<unique_ptr<EventRing>> module_rings;
+    vector<unique_ptr<EventRing>> image_rings;
+
+    for (const auto& detector_name : detector_names) {
+        RamBuffer::remove(detector_name);
+        EventRing::remove(detector_name, "assembler");
+        for (int i_module = 0; i_module < 2; i_module++) {
+            EventRing::remove(detector_name, to_string(i_module));
+        }
+
+        ram_buffers.push_back(make_unique<RamBuffer>(detector_name, 2, 10));
+        detectors.push_back(make_unique<DetectorAssembler>(
+                nullptr, write_config(detector_name)));
+        image_rings.push_back(make_unique<EventRing>(
+                detector_name, "assembler", sizeof(ImageMetadata), false));
+
+        for (int i_module = 0; i_module < 2; i_module++) {
+            module_rings.push_back(make_unique<EventRing>(
+                    detector_name, to_string(i_module),
+                    sizeof(uint64_t), true));
+        }
+    }
+
+    ASSERT_FALSE(detectors[0]->assemble_next());
+
+    // Only detector b has a complete image.
+    ModuleFrame frame_meta = {};
+    frame_meta.frame_index = 5;
+    frame_meta.n_recv_packets = JF_N_PACKETS_PER_FRAME;
+    for (uint64_t pulse_id : {21, 22}) {
+        frame_meta.pulse_id = pulse_id;
+        for (int i_module = 0; i_module < 2; i_module++) {
+            frame_meta.module_id = i_module;
+            ram_buffers[1]->commit_frame(frame_meta);
+            module_rings[2 + i_module]->send(&pulse_id);
+        }
+    }
+
+    ASSERT_TRUE(detectors[0]->claim());
+    ASSERT_FALSE(detectors[0]->claim());
+    ASSERT_FALSE(detectors[0]->assemble_next());
+    detectors[0]->release();
+
+    ASSERT_TRUE(detectors[1]->assemble_next());
+    ASSERT_TRUE(detectors[1]->assemble_next());
+    ASSERT_FALSE(detectors[1]->assemble_next());
+
+    ImageMetadata meta;
+    ASSERT_FALSE(image_rings[0]->recv(&meta, 0));
+    for (uint64_t pulse_id : {21, 22}) {
+        ASSERT_TRUE(image_rings[1]->recv(&meta, 0));
+        ASSERT_EQ(meta.pulse_id, pulse_id);
+        ASSERT_EQ(meta.is_good_image, 1);
+    }
+
+    for (const auto& detector_name : detector_names) {
+        RamBuffer::remove(detector_name);
+        EventRing::remove(detector_name, "assembler");
+        for (int i_module = 0; i_module < 2; i_module++) {
+            EventRing::remove(detector_name, to_string(i_module));
+        }
+    }
+}
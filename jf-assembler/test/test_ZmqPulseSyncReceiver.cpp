@@ -0,0 +1,176 @@
+#include <chrono>
+#include <thread>
+#include <memory>
+#include <vector>
+#include "gtest/gtest.h"
+#include "EventRing.hpp"
+#include "ZmqPulseSyncReceiver.hpp"
+
+using namespace std;
+using namespace chrono;
+
+TEST(ZmqPulseSyncReceiver, missing_module_deadline)
+{
+    const int n_modules = 3;
+    const int deadline_ms = 20;
+
+    for (int i = 0; i < n_modules; i++) {
+        EventRing::remove("test_detector", to_string(i));
+    }
+
+    // Consumers only get the events sent after they attached.
+    ZmqPulseSyncReceiver receiver(nullptr, "test_detector", n_modules,
+                                  BufferUtils::EventTransport::SHM,
+                                  deadline_ms);
+
+    vector<unique_ptr<EventRing>> modules;
+    for (int i = 0; i < n_modules; i++) {
+        modules.push_back(make_unique<EventRing>(
+                "test_detector", to_string(i), sizeof(uint64_t), true));
+    }
+
+    // All modules report.
+    for (uint64_t pulse_id : {10, 11}) {
+        for (auto& module : modules) {
+            module->send(&pulse_id);
+        }
+    }
+
+    const auto pulse_10 = receiver.get_next_pulse_id();
+    ASSERT_EQ(pulse_10.pulse_id, 10);
+    ASSERT_EQ(pulse_10.missing_modules, 0);
+    ASSERT_EQ(receiver.get_next_pulse_id().pulse_id, 11);
+
+    // Module 2 lost pulse 12, known as soon as it reports pulse 13.
+    uint64_t pulse_id = 12;
+    modules[0]->send(&pulse_id);
+    modules[1]->send(&pulse_id);
+    pulse_id = 13;
+    modules[2]->send(&pulse_id);
+
+    const auto start = steady_clock::now();
+    const auto pulse_12 = receiver.get_next_pulse_id();
+    ASSERT_EQ(pulse_12.pulse_id, 12);
+    ASSERT_EQ(pulse_12.missing_modules, 1 << 2);
+    ASSERT_LT(steady_clock::now() - start, milliseconds(deadline_ms));
+
+    // Module 1 is silent, the image comes after the deadline from the
+    // first report of pulse 13.
+    modules[0]->send(&pulse_id);
+    const auto pulse_13 = receiver.get_next_pulse_id();
+    ASSERT_EQ(pulse_13.pulse_id, 13);
+    ASSERT_EQ(pulse_13.missing_modules, 1 << 1);
+    ASSERT_GE(steady_clock::now() - start, milliseconds(deadline_ms));
+
+    // Late reports are dropped and counted.
+    pulse_id = 13;
+    modules[1]->send(&pulse_id);
+    pulse_id = 14;
+    for (auto& module : modules) {
+        module->send(&pulse_id);
+    }
+    const auto pulse_14 = receiver.get_next_pulse_id();
+    ASSERT_EQ(pulse_14.pulse_id, 14);
+    ASSERT_EQ(pulse_14.missing_modules, 0);
+    ASSERT_EQ(pulse_14.n_lost_pulses, 1);
+
+    for (int i = 0; i < n_modules; i++) {
+        EventRing::remove("test_detector", to_string(i));
+    }
+}
+
+TEST(ZmqPulseSyncReceiver, resync)
+{
+    const int n_modules = 3;
+
+    for (int i = 0; i < n_modules; i++) {
+        EventRing::remove("test_detector", to_string(i));
+    }
+
+    ZmqPulseSyncReceiver receiver(nullptr, "test_detector", n_modules,
+                                  BufferUtils::EventTransport::SHM, 10);
+
+    vector<unique_ptr<EventRing>> modules;
+    for (int i = 0; i < n_modules; i++) {
+        modules.push_back(make_unique<EventRing>(
+                "test_detector", to_string(i), sizeof(uint64_t), true));
+    }
+
+    // Module 2 is far behind, its queued pulses are dropped.
+    for (uint64_t pulse_id : {10, 11}) {
+        modules[2]->send(&pulse_id);
+    }
+    uint64_t pulse_id = 200;
+    modules[0]->send(&pulse_id);
+    modules[1]->send(&pulse_id);
+
+    const auto pulse_200 = receiver.get_next_pulse_id();
+    ASSERT_EQ(pulse_200.pulse_id, 200);
+    ASSERT_EQ(pulse_200.missing_modules, 1 << 2);
+    ASSERT_EQ(pulse_200.n_resyncs, 1);
+    ASSERT_EQ(pulse_200.n_lost_pulses, 2);
+
+    // And it is back in sync.
+    pulse_id = 201;
+    for (auto& module : modules) {
+        module->send(&pulse_id);
+    }
+
+    const auto pulse_201 = receiver.get_next_pulse_id();
+    ASSERT_EQ(pulse_201.pulse_id, 201);
+    ASSERT_EQ(pulse_201.missing_modules, 0);
+    ASSERT_EQ(pulse_201.n_resyncs, 0);
+    ASSERT_EQ(pulse_201.n_lost_pulses, 0);
+
+    for (int i = 0; i < n_modules; i++) {
+        EventRing::remove("test_detector", to_string(i));
+    }
+}
+
+TEST(ZmqPulseSyncReceiver, silent_module_rate)
+{
+    const int n_modules = 3;
+    const uint64_t n_pulses = 100;
+
+    for (int i = 0; i < n_modules; i++) {
+        EventRing::remove("test_detector", to_string(i));
+    }
+
+    ZmqPulseSyncReceiver receiver(nullptr, "test_detector", n_modules,
+                                  BufferUtils::EventTransport::SHM, 50);
+
+    vector<unique_ptr<EventRing>> modules;
+    for (int i = 0; i < n_modules; i++) {
+        modules.push_back(make_unique<EventRing>(
+                "test_detector", to_string(i), sizeof(uint64_t), true));
+    }
+
+    // 100 Hz, module 2 never reports.
+    thread sender([&] {
+        for (uint64_t pulse_id = 1; pulse_id <= n_pulses; pulse_id++) {
+            modules[0]->send(&pulse_id);
+            modules[1]->send(&pulse_id);
+            this_thread::sleep_for(milliseconds(10));
+        }
+    });
+
+    const auto start = steady_clock::now();
+    uint64_t n_images = 0;
+    uint64_t pulse_id = 0;
+    while (pulse_id < n_pulses) {
+        const auto pulse = receiver.get_next_pulse_id();
+        ASSERT_EQ(pulse.missing_modules, 1 << 2);
+        ASSERT_GT(pulse.pulse_id, pulse_id);
+        pulse_id = pulse.pulse_id;
+        n_images++;
+    }
+    sender.join();
+
+    // Only the first pulse waits the deadline.
+    ASSERT_EQ(n_images, n_pulses);
+    ASSERT_LT(steady_clock::now() - start, milliseconds(1500));
+
+    for (int i = 0; i < n_modules; i++) {
+        EventRing::remove("test_detector", to_string(i));
+    }
+}
@@ -1,6 +1,7 @@
 #include <cstddef>
 #include <formats.hpp>
 #include <chrono>
+#include <EventStream.hpp>
 
 #ifndef SF_DAQ_BUFFER_FRAMESTATS_HPP
 #define SF_DAQ_BUFFER_FRAMESTATS_HPP
@@ -10,6 +11,8 @@ class BufferStats {
     const std::string detector_name_;
     const int module_id_;
     size_t stats_modulo_;
+    const EventReceiver& receiver_;
+    uint64_t n_dropped_events_reported_ = 0;
 
     int frames_counter_;
     uint32_t total_buffer_write_us_;
@@ -23,7 +26,8 @@ public:
     BufferStats(
             const std::string &detector_name,
             const int module_id,
-            const size_t stats_modulo);
+            const size_t stats_modulo,
+            const EventReceiver& receiver);
     void start_frame_write();
     void end_frame_write();
 };
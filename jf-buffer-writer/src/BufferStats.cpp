@@ -7,10 +7,12 @@ using namespace chrono;
 BufferStats::BufferStats(
         const string& detector_name,
         const int module_id,
-        const size_t stats_modulo) :
+        const size_t stats_modulo,
+        const EventReceiver& receiver) :
             detector_name_(detector_name),
             module_id_(module_id),
-            stats_modulo_(stats_modulo)
+            stats_modulo_(stats_modulo),
+            receiver_(receiver)
 {
    reset_counters();
 }
@@ -47,6 +49,7 @@ void BufferStats::print_stats()
 {
     float avg_buffer_write_us = total_buffer_write_us_ / frames_counter_;
 
+    const auto n_dropped_events = receiver_.get_n_dropped();
     uint64_t timestamp = time_point_cast<nanoseconds>(
             system_clock::now()).time_since_epoch().count();
 
@@ -57,7 +60,11 @@ void BufferStats::print_stats()
     cout << " ";
     cout << "avg_buffer_write_us=" << avg_buffer_write_us;
     cout << ",max_buffer_write_us=" << max_buffer_write_us_ << "i";
+    cout << ",n_dropped_events=";
+    cout << n_dropped_events - n_dropped_events_reported_ << "i";
     cout << " ";
     cout << timestamp;
     cout << endl;
+
+    n_dropped_events_reported_ = n_dropped_events;
 }
@@ -3,6 +3,7 @@
 #include <zmq.h>
 #include <RamBuffer.hpp>
 #include <BufferStats.hpp>
+#include <EventStream.hpp>
 
 #include "formats.hpp"
 #include "BufferUtils.hpp"
@@ -35,26 +36,32 @@ int main (int argc, char *argv[]) {
     const auto module_name = "M" + module_prefix + to_string(module_id);
 
     BufferBinaryWriter writer(config.buffer_folder, module_name);
-    RamBuffer ram_buff(config.detector_name, config.n_modules);
-    BufferStats stats(config.detector_name, module_id, STATS_MODULO);
+    RamBuffer ram_buff(config.detector_name, config.n_modules,
+                       config.ram_buffer.n_slots, config.ram_buffer);
+
+    // Copy the frames on the NUMA node they are received on.
+    const auto numa_node = ram_buff.get_module_numa_node(module_id);
+    if (numa_node >= 0) {
+        pin_thread_to_numa_node(numa_node);
+    }
 
     auto ctx = zmq_ctx_new();
-    auto socket = connect_socket(
-            ctx, config.detector_name, to_string(module_id));
+    EventReceiver receiver(ctx, config.detector_name, to_string(module_id),
+                           sizeof(uint64_t), config.event_transport);
+    BufferStats stats(config.detector_name, module_id, STATS_MODULO, receiver);
 
     auto file_buff = new BufferBinaryFormat();
     uint64_t pulse_id;
 
     while (true) {
-        zmq_recv(socket, &pulse_id, sizeof(pulse_id), 0);
+        receiver.recv(&pulse_id);
 
         stats.start_frame_write();
 
         // TODO: Memory copy here. Optimize this one out.
-        ram_buff.read_frame(
-                pulse_id, module_id, file_buff->meta, file_buff->data);
-        
-        if (pulse_id != file_buff->meta.pulse_id) {
+        // Frames overwritten before or during the copy are not written.
+        if (!ram_buff.read_frame(
+                pulse_id, module_id, file_buff->meta, file_buff->data)) {
             continue;
         }
 
@@ -69,15 +69,15 @@ TEST(BinaryWriter, test_format_marker)
     // One frame before should be empty.
     lseek(read_fd, (file_frame_index-1) * sizeof(BufferBinaryFormat), SEEK_SET);
     read(read_fd, &read_data, sizeof(BufferBinaryFormat));
-    ASSERT_NE(read_data.FORMAT_MARKER, '\xBE');
+    ASSERT_NE(read_data.FORMAT_MARKER, buffer_config::BUFFER_FORMAT_MARKER);
 
     // One frame after should be empty as well.
     lseek(read_fd, (file_frame_index+1) * sizeof(BufferBinaryFormat), SEEK_SET);
     read(read_fd, &read_data, sizeof(BufferBinaryFormat));
-    ASSERT_NE(read_data.FORMAT_MARKER, '\xBE');
+    ASSERT_NE(read_data.FORMAT_MARKER, buffer_config::BUFFER_FORMAT_MARKER);
 
     // But this frame should be here.
     lseek(read_fd, (file_frame_index) * sizeof(BufferBinaryFormat), SEEK_SET);
     read(read_fd, &read_data, sizeof(BufferBinaryFormat));
-    ASSERT_EQ(read_data.FORMAT_MARKER, '\xBE');
+    ASSERT_EQ(read_data.FORMAT_MARKER, buffer_config::BUFFER_FORMAT_MARKER);
 }
\ No newline at end of file
@@ -0,0 +1,78 @@
+#ifndef SF_DAQ_BUFFER_FLIGHTRECORDER_HPP
+#define SF_DAQ_BUFFER_FLIGHTRECORDER_HPP
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include "RamBuffer.hpp"
+#include "SpscRing.hpp"
+#include "formats.hpp"
+#include "flight_recorder_config.hpp"
+
+struct FlightRecorderStats {
+    uint64_t n_written_frames = 0;
+    // Frames not in the RamBuffer: never received or already overwritten.
+    uint64_t n_lost_frames = 0;
+    uint64_t n_written_bytes = 0;
+    uint64_t duration_ms = 0;
+};
+
+/** Dump of a pulse_id range from the RamBuffer to disk
+
+    The calling thread copies the frames of all modules, oldest pulse_id
+    first, into staging batches; a writer thread writes them to the buffer
+    binary files of output_folder, in the same layout as jf-buffer-writer.
+    The range can span at most the RamBuffer slots. Frames not in the
+    RamBuffer, or overwritten before the copy reaches them, are skipped. **/
+class FlightRecorder {
+    struct DumpBatch {
+        uint64_t start_pulse_id;
+        // 0 ends the dump.
+        size_t n_pulses;
+        // batch_pulses_ frames per module, module after module.
+        BufferBinaryFormat* frames;
+    };
+
+    const RamBuffer& ram_buffer_;
+    const int n_modules_;
+    const size_t batch_pulses_;
+    const size_t batch_n_frames_;
+    char* staging_;
+    SpscRing<DumpBatch, flight_recorder_config::DUMP_N_BATCHES> batches_;
+    // Batches passed to the writer, gives the staging slot of the next one.
+    uint64_t n_batches_ = 0;
+
+    // Current output file of each module.
+    std::vector<std::string> filenames_;
+    std::vector<int> file_fds_;
+
+    void copy_batch(DumpBatch& batch, FlightRecorderStats& stats) const;
+    void write_batches(const std::string& output_folder,
+                       FlightRecorderStats& stats,
+                       std::string& error);
+    void write_frames(const std::string& output_folder,
+                      const int module_id,
+                      const BufferBinaryFormat* frames,
+                      const size_t n_frames,
+                      FlightRecorderStats& stats);
+    int get_file(const std::string& output_folder,
+                 const int module_id,
+                 const uint64_t pulse_id);
+    void close_files();
+
+public:
+    FlightRecorder(const RamBuffer& ram_buffer, const int n_modules);
+    virtual ~FlightRecorder();
+
+    // Throws if [start_pulse_id, stop_pulse_id] is empty or wider than the
+    // RamBuffer.
+    void check_range(const uint64_t start_pulse_id,
+                     const uint64_t stop_pulse_id) const;
+    // Dump the frames of [start_pulse_id, stop_pulse_id] of all modules.
+    FlightRecorderStats dump(const uint64_t start_pulse_id,
+                             const uint64_t stop_pulse_id,
+                             const std::string& output_folder);
+};
+
+
+#endif //SF_DAQ_BUFFER_FLIGHTRECORDER_HPP
@@ -0,0 +1,20 @@
+#ifndef SF_DAQ_BUFFER_FLIGHT_RECORDER_CONFIG_HPP
+#define SF_DAQ_BUFFER_FLIGHT_RECORDER_CONFIG_HPP
+
+#include <cstddef>
+#include <string>
+
+namespace flight_recorder_config
+{
+    // Most consecutive pulses of all modules copied from the RamBuffer at
+    // once, fewer for big detectors to stay within DUMP_STAGING_BYTES.
+    const size_t DUMP_BATCH_PULSES = 8;
+    // Staging memory of the batches, at least one pulse per batch.
+    const size_t DUMP_STAGING_BYTES = 256 * 1024 * 1024;
+    // Batches between the copy and write threads (power of 2).
+    const size_t DUMP_N_BATCHES = 4;
+    // Stream name of the trigger socket, after the detector name.
+    const std::string FLIGHT_RECORDER_STREAM = "flight-recorder";
+}
+
+#endif //SF_DAQ_BUFFER_FLIGHT_RECORDER_CONFIG_HPP
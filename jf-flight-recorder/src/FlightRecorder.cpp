@@ -0,0 +1,317 @@
+#include "FlightRecorder.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include "BufferUtils.hpp"
+
+using namespace std;
+using namespace buffer_config;
+using namespace flight_recorder_config;
+
+FlightRecorder::FlightRecorder(
+        const RamBuffer& ram_buffer, const int n_modules) :
+        ram_buffer_(ram_buffer),
+        n_modules_(n_modules),
+        batch_pulses_(max((size_t) 1, min(DUMP_BATCH_PULSES,
+                DUMP_STAGING_BYTES / (DUMP_N_BATCHES * n_modules *
+                                      sizeof(BufferBinaryFormat))))),
+        batch_n_frames_(batch_pulses_ * n_modules),
+        filenames_(n_modules),
+        file_fds_(n_modules, -1)
+{
+    const size_t page_bytes = sysconf(_SC_PAGESIZE);
+    size_t staging_bytes =
+            DUMP_N_BATCHES * batch_n_frames_ * sizeof(BufferBinaryFormat);
+    staging_bytes = ((staging_bytes + page_bytes - 1) / page_bytes) *
+                    page_bytes;
+
+    // Page aligned, so the kernel copies whole pages into the page cache.
+    staging_ = (char*) aligned_alloc(page_bytes, staging_bytes);
+    if (staging_ == nullptr) {
+        stringstream err_msg;
+        err_msg << "[FlightRecorder::FlightRecorder]";
+        err_msg << " Cannot allocate " << staging_bytes << " staging bytes.";
+        throw runtime_error(err_msg.str());
+    }
+
+    // Sets the FORMAT_MARKER of every frame.
+    auto* frames = (BufferBinaryFormat*) staging_;
+    for (size_t i = 0; i < DUMP_N_BATCHES * batch_n_frames_; i++) {
+        new (frames + i) BufferBinaryFormat();
+    }
+}
+
+FlightRecorder::~FlightRecorder()
+{
+    free(staging_);
+
+    for (auto fd : file_fds_) {
+        if (fd != -1) {
+            close(fd);
+        }
+    }
+}
+
+void FlightRecorder::check_range(
+        const uint64_t start_pulse_id,
+        const uint64_t stop_pulse_id) const
+{
+    if (stop_pulse_id < start_pulse_id) {
+        stringstream err_msg;
+        err_msg << "[FlightRecorder::check_range]";
+        err_msg << " stop_pulse_id " << stop_pulse_id;
+        err_msg << " before start_pulse_id " << start_pulse_id << ".";
+        throw runtime_error(err_msg.str());
+    }
+
+    // Older pulses of a wider range are overwritten by the newer ones.
+    const uint64_t n_slots = ram_buffer_.get_n_slots();
+    if (stop_pulse_id - start_pulse_id >= n_slots) {
+        stringstream err_msg;
+        err_msg << "[FlightRecorder::check_range]";
+        err_msg << " Range of " << (stop_pulse_id - start_pulse_id + 1);
+        err_msg << " pulses wider than the " << n_slots;
+        err_msg << " RamBuffer slots.";
+        throw runtime_error(err_msg.str());
+    }
+}
+
+FlightRecorderStats FlightRecorder::dump(
+        const uint64_t start_pulse_id,
+        const uint64_t stop_pulse_id,
+        const string& output_folder)
+{
+    check_range(start_pulse_id, stop_pulse_id);
+
+    using namespace chrono;
+    const auto start_time = steady_clock::now();
+
+    FlightRecorderStats copy_stats;
+    FlightRecorderStats write_stats;
+    string write_error;
+
+    thread writer(&FlightRecorder::write_batches, this,
+                  cref(output_folder), ref(write_stats), ref(write_error));
+
+    // Oldest pulses first, they are the next ones to be overwritten.
+    auto pulse_id = start_pulse_id;
+    while (true) {
+        auto& batch = batches_.wait_write();
+        batch.frames = (BufferBinaryFormat*) staging_ +
+                       ((n_batches_ % DUMP_N_BATCHES) * batch_n_frames_);
+        batch.start_pulse_id = pulse_id;
+        batch.n_pulses = 0;
+
+        if (pulse_id <= stop_pulse_id) {
+            batch.n_pulses = min(batch_pulses_,
+                                 (size_t) (stop_pulse_id - pulse_id + 1));
+            copy_batch(batch, copy_stats);
+        }
+
+        const bool is_last = batch.n_pulses == 0;
+        pulse_id += batch.n_pulses;
+
+        batches_.commit_write();
+        n_batches_++;
+
+        if (is_last) {
+            break;
+        }
+    }
+
+    writer.join();
+
+    if (!write_error.empty()) {
+        throw runtime_error(write_error);
+    }
+
+    write_stats.n_lost_frames = copy_stats.n_lost_frames;
+    write_stats.duration_ms = duration_cast<milliseconds>(
+            steady_clock::now() - start_time).count();
+
+    return write_stats;
+}
+
+void FlightRecorder::copy_batch(
+        DumpBatch& batch, FlightRecorderStats& stats) const
+{
+    for (size_t i_pulse = 0; i_pulse < batch.n_pulses; i_pulse++) {
+        const auto pulse_id = batch.start_pulse_id + i_pulse;
+
+        for (int i_module = 0; i_module < n_modules_; i_module++) {
+            auto& frame = batch.frames[
+                    (i_module * batch_pulses_) + i_pulse];
+
+            if (!ram_buffer_.read_frame(
+                    pulse_id, i_module, frame.meta, frame.data)) {
+                // Not written to disk.
+                frame.meta.pulse_id = 0;
+                stats.n_lost_frames++;
+            }
+        }
+    }
+}
+
+void FlightRecorder::write_batches(
+        const string& output_folder,
+        FlightRecorderStats& stats,
+        string& error)
+{
+    while (true) {
+        auto& batch = batches_.wait_read();
+
+        if (batch.n_pulses == 0) {
+            batches_.release_read();
+            break;
+        }
+
+        // After an error keep releasing batches until the end of the dump.
+        if (error.empty()) {
+            try {
+                for (int i_module = 0; i_module < n_modules_; i_module++) {
+                    write_frames(output_folder, i_module,
+                                 batch.frames + (i_module * batch_pulses_),
+                                 batch.n_pulses, stats);
+                }
+            } catch (const exception& e) {
+                error = e.what();
+            }
+        }
+
+        batches_.release_read();
+    }
+
+    close_files();
+}
+
+void FlightRecorder::write_frames(
+        const string& output_folder,
+        const int module_id,
+        const BufferBinaryFormat* frames,
+        const size_t n_frames,
+        FlightRecorderStats& stats)
+{
+    // Runs of present frames in the same file are written at once.
+    size_t i_start = 0;
+    while (i_start < n_frames) {
+        if (frames[i_start].meta.pulse_id == 0) {
+            i_start++;
+            continue;
+        }
+
+        const auto start_pulse_id = frames[i_start].meta.pulse_id;
+        const auto file_index = start_pulse_id / FILE_MOD;
+
+        size_t i_end = i_start + 1;
+        while (i_end < n_frames &&
+               frames[i_end].meta.pulse_id == start_pulse_id + i_end - i_start
+               && frames[i_end].meta.pulse_id / FILE_MOD == file_index) {
+            i_end++;
+        }
+
+        const auto fd = get_file(output_folder, module_id, start_pulse_id);
+        const size_t n_bytes = (i_end - i_start) * sizeof(BufferBinaryFormat);
+        const off_t offset =
+                BufferUtils::get_file_frame_index(start_pulse_id) *
+                sizeof(BufferBinaryFormat);
+
+        size_t n_written = 0;
+        while (n_written < n_bytes) {
+            const auto result = pwrite(fd,
+                                       (char*) (frames + i_start) + n_written,
+                                       n_bytes - n_written,
+                                       offset + n_written);
+            if (result < 0) {
+                stringstream err_msg;
+                err_msg << "[FlightRecorder::write_frames]";
+                err_msg << " Error while writing to file ";
+                err_msg << filenames_[module_id] << ": ";
+                err_msg << strerror(errno);
+                throw runtime_error(err_msg.str());
+            }
+
+            n_written += result;
+        }
+
+        // Start the write back now, the dump does not need the page cache.
+        sync_file_range(fd, offset, n_bytes, SYNC_FILE_RANGE_WRITE);
+
+        stats.n_written_frames += i_end - i_start;
+        stats.n_written_bytes += n_bytes;
+        i_start = i_end;
+    }
+}
+
+int FlightRecorder::get_file(
+        const string& output_folder,
+        const int module_id,
+        const uint64_t pulse_id)
+{
+    const string module_prefix = (module_id < 10) ? "0" : "";
+    const auto module_name = "M" + module_prefix + to_string(module_id);
+    const auto filename =
+            BufferUtils::get_filename(output_folder, module_name, pulse_id);
+
+    if (filename == filenames_[module_id]) {
+        return file_fds_[module_id];
+    }
+
+    if (file_fds_[module_id] != -1) {
+        close(file_fds_[module_id]);
+        file_fds_[module_id] = -1;
+    }
+
+    BufferUtils::create_destination_folder(filename);
+
+    // Frames already in the file (an overlapping dump) are kept.
+    const auto fd = open(filename.c_str(), O_WRONLY | O_CREAT,
+                         S_IRWXU | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH);
+    if (fd < 0) {
+        stringstream err_msg;
+        err_msg << "[FlightRecorder::get_file]";
+        err_msg << " Cannot create file " << filename << ": ";
+        err_msg << strerror(errno);
+        throw runtime_error(err_msg.str());
+    }
+
+    // Full size file as jf-buffer-writer makes, missing frames read as 0.
+    const off_t file_bytes = FILE_MOD * sizeof(BufferBinaryFormat);
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == 0 && file_stat.st_size < file_bytes) {
+        if (ftruncate(fd, file_bytes) != 0) {
+            stringstream err_msg;
+            err_msg << "[FlightRecorder::get_file]";
+            err_msg << " Cannot resize file " << filename << ": ";
+            err_msg << strerror(errno);
+            close(fd);
+            throw runtime_error(err_msg.str());
+        }
+    }
+
+    filenames_[module_id] = filename;
+    file_fds_[module_id] = fd;
+
+    return fd;
+}
+
+void FlightRecorder::close_files()
+{
+    for (int i_module = 0; i_module < n_modules_; i_module++) {
+        if (file_fds_[i_module] != -1) {
+            close(file_fds_[i_module]);
+            file_fds_[i_module] = -1;
+        }
+
+        filenames_[i_module] = "";
+    }
+}
@@ -0,0 +1,177 @@
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <zmq.h>
+#include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+#include <RamBuffer.hpp>
+
+#include "BufferUtils.hpp"
+#include "FlightRecorder.hpp"
+#include "flight_recorder_config.hpp"
+
+using namespace std;
+using namespace buffer_config;
+using namespace flight_recorder_config;
+
+void print_stats(const string& detector_name,
+                 const uint64_t start_pulse_id,
+                 const uint64_t stop_pulse_id,
+                 const FlightRecorderStats& stats)
+{
+    using namespace chrono;
+    uint64_t timestamp = time_point_cast<nanoseconds>(
+            system_clock::now()).time_since_epoch().count();
+
+    cout << "jf_flight_recorder";
+    cout << ",detector_name=" << detector_name;
+    cout << " ";
+    cout << "start_pulse_id=" << start_pulse_id << "i";
+    cout << ",stop_pulse_id=" << stop_pulse_id << "i";
+    cout << ",n_written_frames=" << stats.n_written_frames << "i";
+    cout << ",n_lost_frames=" << stats.n_lost_frames << "i";
+    cout << ",n_written_bytes=" << stats.n_written_bytes << "i";
+    cout << ",duration_ms=" << stats.duration_ms << "i";
+    cout << " ";
+    cout << timestamp;
+    cout << endl;
+}
+
+string get_reply(const string& status, const string& message="")
+{
+    rapidjson::Document reply(rapidjson::kObjectType);
+    auto& alloc = reply.GetAllocator();
+
+    rapidjson::Value status_value;
+    status_value.SetString(status.c_str(), alloc);
+    reply.AddMember("status", status_value, alloc);
+
+    if (!message.empty()) {
+        rapidjson::Value message_value;
+        message_value.SetString(message.c_str(), alloc);
+        reply.AddMember("message", message_value, alloc);
+    }
+
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    reply.Accept(writer);
+
+    return buffer.GetString();
+}
+
+int main (int argc, char *argv[])
+{
+    if (argc != 2 && argc != 5) {
+        cout << endl;
+        cout << "Usage: jf_flight_recorder [detector_json_filename]";
+        cout << " [start_pulse_id] [stop_pulse_id] [output_folder]" << endl;
+        cout << "\tdetector_json_filename: detector config file path." << endl;
+        cout << "\tstart_pulse_id: first pulse_id to dump." << endl;
+        cout << "\tstop_pulse_id: last pulse_id to dump." << endl;
+        cout << "\toutput_folder: folder of the dumped buffer files." << endl;
+        cout << "Without the pulse_ids, wait for dump requests on the ";
+        cout << FLIGHT_RECORDER_STREAM << " stream." << endl;
+        cout << endl;
+
+        exit(-1);
+    }
+
+    const auto config = BufferUtils::read_json_config(string(argv[1]));
+
+    RamBuffer ram_buffer(config.detector_name, config.n_modules,
+                         config.ram_buffer.n_slots, config.ram_buffer);
+    FlightRecorder recorder(ram_buffer, config.n_modules);
+
+    if (argc == 5) {
+        const uint64_t start_pulse_id = stoull(argv[2]);
+        const uint64_t stop_pulse_id = stoull(argv[3]);
+
+        const auto stats = recorder.dump(
+                start_pulse_id, stop_pulse_id, string(argv[4]));
+        print_stats(config.detector_name,
+                    start_pulse_id, stop_pulse_id, stats);
+
+        return 0;
+    }
+
+    auto ctx = zmq_ctx_new();
+    auto socket = zmq_socket(ctx, ZMQ_REP);
+    const auto ipc_address = BUFFER_LIVE_IPC_URL + config.detector_name +
+                             "-" + FLIGHT_RECORDER_STREAM;
+    if (zmq_bind(socket, ipc_address.c_str()) != 0) {
+        throw runtime_error(zmq_strerror(errno));
+    }
+
+    // One dump at the time, the request is answered when it starts.
+    thread dump_thread;
+    atomic<bool> is_dumping(false);
+
+    char request_buffer[4096];
+    while (true) {
+        const auto n_bytes = zmq_recv(
+                socket, request_buffer, sizeof(request_buffer), 0);
+        if (n_bytes < 0) {
+            continue;
+        }
+
+        rapidjson::Document request;
+        request.Parse(request_buffer,
+                      min((size_t) n_bytes, sizeof(request_buffer)));
+
+        if (request.HasParseError() || !request.IsObject() ||
+            !request.HasMember("start_pulse_id") ||
+            !request["start_pulse_id"].IsUint64() ||
+            !request.HasMember("stop_pulse_id") ||
+            !request["stop_pulse_id"].IsUint64() ||
+            !request.HasMember("output_folder") ||
+            !request["output_folder"].IsString()) {
+            const auto reply = get_reply("error", "Invalid dump request.");
+            zmq_send(socket, reply.c_str(), reply.size(), 0);
+            continue;
+        }
+
+        if (is_dumping) {
+            const auto reply = get_reply("busy");
+            zmq_send(socket, reply.c_str(), reply.size(), 0);
+            continue;
+        }
+
+        if (dump_thread.joinable()) {
+            dump_thread.join();
+        }
+
+        const uint64_t start_pulse_id = request["start_pulse_id"].GetUint64();
+        const uint64_t stop_pulse_id = request["stop_pulse_id"].GetUint64();
+        const string output_folder = request["output_folder"].GetString();
+
+        try {
+            recorder.check_range(start_pulse_id, stop_pulse_id);
+        } catch (const exception& e) {
+            const auto reply = get_reply("error", e.what());
+            zmq_send(socket, reply.c_str(), reply.size(), 0);
+            continue;
+        }
+
+        is_dumping = true;
+        dump_thread = thread([&, start_pulse_id, stop_pulse_id,
+                              output_folder] {
+            try {
+                const auto stats = recorder.dump(
+                        start_pulse_id, stop_pulse_id, output_folder);
+                print_stats(config.detector_name,
+                            start_pulse_id, stop_pulse_id, stats);
+            } catch (const exception& e) {
+                cout << e.what() << endl;
+            }
+
+            is_dumping = false;
+        });
+
+        const auto reply = get_reply("started");
+        zmq_send(socket, reply.c_str(), reply.size(), 0);
+    }
+}
@@ -0,0 +1,110 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <memory>
+#include "FlightRecorder.hpp"
+#include "BufferUtils.hpp"
+#include "gtest/gtest.h"
+
+using namespace std;
+using namespace buffer_config;
+
+BufferBinaryFormat read_dumped_frame(const string& folder,
+                                     const string& module_name,
+                                     const uint64_t pulse_id)
+{
+    const auto filename =
+            BufferUtils::get_filename(folder, module_name, pulse_id);
+
+    auto fd = open(filename.c_str(), O_RDONLY);
+    EXPECT_NE(fd, -1);
+
+    BufferBinaryFormat frame;
+    const off_t offset = BufferUtils::get_file_frame_index(pulse_id) *
+                         sizeof(BufferBinaryFormat);
+    pread(fd, &frame, sizeof(frame), offset);
+    close(fd);
+
+    return frame;
+}
+
+TEST(FlightRecorder, dump_range)
+{
+    const int n_modules = 2;
+    const int n_slots = 20;
+    const string folder = "flight_recorder_test";
+
+    system(("rm -rf " + folder).c_str());
+    RamBuffer::remove("test_detector");
+    RamBuffer buffer("test_detector", n_modules, n_slots);
+
+    ModuleFrame frame_meta = {};
+    frame_meta.daq_rec = 1234;
+    frame_meta.n_recv_packets = JF_N_PACKETS_PER_FRAME;
+    auto frame_buffer = make_unique<uint16_t[]>(MODULE_N_PIXELS);
+
+    // Pulses 995 to 1004 span 2 files, module 1 misses pulse 1000.
+    for (uint64_t pulse_id = 995; pulse_id < 1005; pulse_id++) {
+        for (int i_module = 0; i_module < n_modules; i_module++) {
+            if (i_module == 1 && pulse_id == 1000) {
+                continue;
+            }
+
+            frame_meta.pulse_id = pulse_id;
+            frame_meta.frame_index = pulse_id + 10;
+            frame_meta.module_id = i_module;
+            for (size_t i = 0; i < MODULE_N_PIXELS; i++) {
+                frame_buffer[i] = pulse_id + i_module + i;
+            }
+
+            buffer.write_frame(frame_meta, (char*) frame_buffer.get());
+        }
+    }
+
+    FlightRecorder recorder(buffer, n_modules);
+    // Pulses before 995 were never in the RamBuffer.
+    const auto stats = recorder.dump(990, 1004, folder);
+
+    ASSERT_EQ(stats.n_written_frames, 19);
+    ASSERT_EQ(stats.n_lost_frames, 11);
+    ASSERT_EQ(stats.n_written_bytes, 19 * sizeof(BufferBinaryFormat));
+
+    for (uint64_t pulse_id = 995; pulse_id < 1005; pulse_id++) {
+        for (int i_module = 0; i_module < n_modules; i_module++) {
+            const auto frame = read_dumped_frame(
+                    folder, "M0" + to_string(i_module), pulse_id);
+
+            if (i_module == 1 && pulse_id == 1000) {
+                ASSERT_EQ(frame.meta.pulse_id, 0);
+                continue;
+            }
+
+            ASSERT_EQ(frame.FORMAT_MARKER, BUFFER_FORMAT_MARKER);
+            ASSERT_EQ(frame.meta.pulse_id, pulse_id);
+            ASSERT_EQ(frame.meta.frame_index, pulse_id + 10);
+            ASSERT_EQ(frame.meta.module_id, i_module);
+
+            auto data = (uint16_t*) frame.data;
+            ASSERT_EQ(data[0], (uint16_t) (pulse_id + i_module));
+            ASSERT_EQ(data[MODULE_N_PIXELS - 1],
+                      (uint16_t) (pulse_id + i_module + MODULE_N_PIXELS - 1));
+        }
+    }
+
+    // Whole files, as jf-buffer-writer makes them.
+    const auto frame = read_dumped_frame(folder, "M00", 1999);
+    ASSERT_EQ(frame.meta.pulse_id, 0);
+
+    // The recorder can dump again.
+    const auto stats_again = recorder.dump(1003, 1004, folder);
+    ASSERT_EQ(stats_again.n_written_frames, 4);
+    ASSERT_EQ(stats_again.n_lost_frames, 0);
+
+    ASSERT_THROW(recorder.dump(1004, 1003, folder), runtime_error);
+    // Wider than the RamBuffer.
+    ASSERT_THROW(recorder.dump(1000, 1000 + n_slots, folder), runtime_error);
+    recorder.check_range(1000, 1000 + n_slots - 1);
+
+    system(("rm -rf " + folder).c_str());
+    RamBuffer::remove("test_detector");
+}
@@ -31,6 +31,7 @@ class JFH5Writer {
     hid_t frame_dataset_id_ = -1;
     hid_t daq_rec_dataset_id_ = -1;
     hid_t is_good_dataset_id_ = -1;
+    hid_t missing_modules_dataset_id_ = -1;
 
     static hid_t get_datatype(int bits_per_pixel);
     void open_file(const std::string& output_file, uint32_t n_images);
@@ -53,7 +54,8 @@ public:
 
     void write_meta(int64_t run_id,
                     uint32_t index,
-                    const ImageMetadata& meta);
+                    const ImageMetadata& meta,
+                    uint64_t missing_modules);
 };
 
 #endif //JF_LIVE_WRITER_HPP
@@ -13,6 +13,7 @@ class WriterStats {
     uint32_t image_n_bytes_{};
 
     int image_counter_{};
+    int n_overwritten_images_{};
     uint64_t total_bytes_{};
 
     uint32_t total_buffer_write_us_{};
@@ -27,7 +28,8 @@ public:
     void start_run(const StoreStream& meta);
     void end_run();
     void start_image_write();
-    void end_image_write();
+    // is_overwritten: the image slot was overwritten while it was written.
+    void end_image_write(const bool is_overwritten);
 };
 
 
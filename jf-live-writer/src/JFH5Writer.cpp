@@ -178,6 +178,8 @@ void JFH5Writer::open_file(const string& output_file, const uint32_t n_images)
     frame_dataset_id_ = create_meta_dataset("frame_index", H5T_NATIVE_UINT64);
     daq_rec_dataset_id_ = create_meta_dataset("daq_rec", H5T_NATIVE_UINT32);
     is_good_dataset_id_ = create_meta_dataset("is_good_frame", H5T_NATIVE_UINT8);
+    missing_modules_dataset_id_ =
+            create_meta_dataset("missing_modules", H5T_NATIVE_UINT64);
 
     H5Sclose(meta_space_id);
     H5Sclose(image_space_id);
@@ -206,6 +208,9 @@ void JFH5Writer::close_file()
     H5Dclose(is_good_dataset_id_);
     is_good_dataset_id_ = -1;
 
+    H5Dclose(missing_modules_dataset_id_);
+    missing_modules_dataset_id_ = -1;
+
     H5Fclose(file_id_);
     file_id_ = -1;
 }
@@ -247,7 +252,10 @@ void JFH5Writer::write_data(
 }
 
 void JFH5Writer::write_meta(
-        const int64_t run_id, const uint32_t index, const ImageMetadata& meta)
+        const int64_t run_id,
+        const uint32_t index,
+        const ImageMetadata& meta,
+        const uint64_t missing_modules)
 {
     if (run_id != current_run_id_) {
         throw runtime_error("Invalid run_id.");
@@ -293,6 +301,11 @@ void JFH5Writer::write_meta(
         throw runtime_error("Cannot write data to is_good_image dataset.");
     }
 
+    if (H5Dwrite(missing_modules_dataset_id_, H5T_NATIVE_UINT64,
+                 ram_ds, file_ds, H5P_DEFAULT, &missing_modules) < 0) {
+        throw runtime_error("Cannot write data to missing_modules dataset.");
+    }
+
     H5Sclose(file_ds);
     H5Sclose(ram_ds);
 }
@@ -14,6 +14,7 @@ WriterStats::WriterStats(string detector_name) :
 void WriterStats::reset_counters()
 {
     image_counter_ = 0;
+    n_overwritten_images_ = 0;
     total_buffer_write_us_ = 0;
     max_buffer_write_us_ = 0;
     total_bytes_ = 0;
@@ -24,9 +25,14 @@ void WriterStats::start_image_write()
     stats_interval_start_ = steady_clock::now();
 }
 
-void WriterStats::end_image_write()
+void WriterStats::end_image_write(const bool is_overwritten)
 {
     image_counter_++;
+
+    if (is_overwritten) {
+        n_overwritten_images_++;
+    }
+
     total_bytes_ += image_n_bytes_;
 
     uint32_t write_us_duration = duration_cast<microseconds>(
@@ -67,6 +73,7 @@ void WriterStats::print_stats()
     cout << ",detector_name=" << detector_name_;
     cout << " ";
     cout << "n_written_images=" << image_counter_ << "i";
+    cout << " ,n_overwritten_images=" << n_overwritten_images_ << "i";
     cout << " ,avg_buffer_write_us=" << avg_buffer_write_us;
     cout << " ,max_buffer_write_us=" << max_buffer_write_us_ << "i";
     cout << " ,avg_throughput=" << avg_throughput;
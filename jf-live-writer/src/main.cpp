@@ -1,9 +1,12 @@
 #include <iostream>
+#include <memory>
 #include <string>
 #include <zmq.h>
 #include <mpi.h>
 
 #include "RamBuffer.hpp"
+#include "SpillBuffer.hpp"
+#include "PulseTracer.hpp"
 #include "BufferUtils.hpp"
 #include "live_writer_config.hpp"
 #include "WriterStats.hpp"
@@ -40,10 +43,24 @@ int main (int argc, char *argv[])
     auto receiver = BufferUtils::connect_socket(
             ctx, config.detector_name, "writer-agent");
 
-    RamBuffer ram_buffer(config.detector_name, config.n_modules);
+    RamBuffer ram_buffer(config.detector_name, config.n_modules,
+                         config.ram_buffer.n_slots, config.ram_buffer);
+
+    // Images overwritten during the write are written again from disk.
+    unique_ptr<SpillBuffer> spill_buffer;
+    unique_ptr<char[]> spill_image;
+    if (!config.spill_buffer.filename.empty()) {
+        spill_buffer = make_unique<SpillBuffer>(
+                config.spill_buffer.filename, config.n_modules,
+                config.spill_buffer.n_slots);
+        spill_image = make_unique<char[]>(
+                config.n_modules * MODULE_N_BYTES);
+    }
 
     JFH5Writer writer(config);
     WriterStats stats(config.detector_name);
+    PulseTracer tracer(config.detector_name, config.latency_trace,
+                       config.ram_buffer.n_slots);
 
     StoreStream meta = {};
     while (true) {
@@ -62,16 +79,35 @@ int main (int argc, char *argv[])
 
         // Fair distribution of images among writers.
         if (meta.i_image % n_writers == i_writer) {
-            char* data = ram_buffer.read_image(meta.image_metadata.pulse_id);
+            const auto pulse_id = meta.image_metadata.pulse_id;
+            const auto generation = ram_buffer.begin_read_image(pulse_id);
+            char* data = ram_buffer.read_image(pulse_id);
 
             stats.start_image_write();
             writer.write_data(meta.run_id, meta.i_image, data);
-            stats.end_image_write();
+
+            auto is_overwritten =
+                    !ram_buffer.end_read_image(pulse_id, generation);
+            if (is_overwritten && spill_buffer &&
+                spill_buffer->read_spilled_image(
+                        pulse_id, spill_image.get())) {
+                writer.write_data(meta.run_id, meta.i_image,
+                                  spill_image.get());
+                is_overwritten = false;
+            }
+            stats.end_image_write(is_overwritten);
+            tracer.record_now(TraceStage::WRITER_WRITE,
+                              meta.image_metadata.pulse_id);
         }
 
         // Only the first instance writes metadata.
         if (i_writer == 0) {
-            writer.write_meta(meta.run_id, meta.i_image, meta.image_metadata);
+            // Stored in the image slot by jf-assembler.
+            const auto missing_modules = ram_buffer.get_missing_modules(
+                    meta.image_metadata.pulse_id);
+
+            writer.write_meta(meta.run_id, meta.i_image, meta.image_metadata,
+                              missing_modules);
         }
 
         // i_image + 1 == meta.n_images -> we received the last image.
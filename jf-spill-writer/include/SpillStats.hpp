@@ -0,0 +1,40 @@
+#ifndef SF_DAQ_BUFFER_SPILLSTATS_HPP
+#define SF_DAQ_BUFFER_SPILLSTATS_HPP
+
+#include <chrono>
+#include <string>
+#include <EventStream.hpp>
+
+
+class SpillStats {
+    const std::string detector_name_;
+    const int n_modules_;
+    const size_t stats_modulo_;
+    const EventReceiver& receiver_;
+    uint64_t n_dropped_events_reported_ = 0;
+
+    size_t image_counter_;
+    // Images with modules already overwritten in the RamBuffer.
+    size_t n_partial_images_;
+    // Images not spilled because the disk did not keep up.
+    size_t n_dropped_images_;
+    uint32_t total_copy_us_;
+    uint32_t max_copy_us_;
+    std::chrono::time_point<std::chrono::steady_clock> copy_start_;
+
+    void reset_counters();
+    void print_stats();
+
+public:
+    SpillStats(const std::string& detector_name,
+               const int n_modules,
+               const size_t stats_modulo,
+               const EventReceiver& receiver);
+
+    void start_image_copy();
+    void end_image_copy(const int n_copied_modules);
+    void record_dropped_image();
+};
+
+
+#endif //SF_DAQ_BUFFER_SPILLSTATS_HPP
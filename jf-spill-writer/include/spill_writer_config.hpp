@@ -0,0 +1,9 @@
+namespace spill_writer_config
+{
+    // N of IO threads to receive image metadata.
+    const int SPILL_ZMQ_IO_THREADS = 1;
+    // Images copied from the RamBuffer waiting for the disk (power of 2).
+    const size_t SPILL_N_STAGED_IMAGES = 16;
+    // Number of pulses between each statistics print out.
+    const size_t SPILL_STATS_MODULO = 1000;
+}
@@ -0,0 +1,82 @@
+#include <iostream>
+#include "SpillStats.hpp"
+
+using namespace std;
+using namespace chrono;
+
+SpillStats::SpillStats(
+        const string& detector_name,
+        const int n_modules,
+        const size_t stats_modulo,
+        const EventReceiver& receiver) :
+            detector_name_(detector_name),
+            n_modules_(n_modules),
+            stats_modulo_(stats_modulo),
+            receiver_(receiver)
+{
+    reset_counters();
+}
+
+void SpillStats::reset_counters()
+{
+    image_counter_ = 0;
+    n_partial_images_ = 0;
+    n_dropped_images_ = 0;
+    total_copy_us_ = 0;
+    max_copy_us_ = 0;
+}
+
+void SpillStats::start_image_copy()
+{
+    copy_start_ = steady_clock::now();
+}
+
+void SpillStats::end_image_copy(const int n_copied_modules)
+{
+    image_counter_++;
+
+    uint32_t copy_us_duration = duration_cast<microseconds>(
+            steady_clock::now()-copy_start_).count();
+
+    total_copy_us_ += copy_us_duration;
+    max_copy_us_ = max(max_copy_us_, copy_us_duration);
+
+    if (n_copied_modules < n_modules_) {
+        n_partial_images_++;
+    }
+
+    if (image_counter_ == stats_modulo_) {
+        print_stats();
+        reset_counters();
+    }
+}
+
+void SpillStats::record_dropped_image()
+{
+    n_dropped_images_++;
+}
+
+void SpillStats::print_stats()
+{
+    float avg_copy_us = total_copy_us_ / image_counter_;
+    const auto n_dropped_events = receiver_.get_n_dropped();
+
+    uint64_t timestamp = time_point_cast<nanoseconds>(
+            system_clock::now()).time_since_epoch().count();
+
+    // Output in InfluxDB line protocol
+    cout << "jf_spill_writer";
+    cout << ",detector_name=" << detector_name_;
+    cout << " ";
+    cout << "n_partial_images=" << n_partial_images_ << "i";
+    cout << ",n_dropped_images=" << n_dropped_images_ << "i";
+    cout << ",avg_copy_us=" << avg_copy_us;
+    cout << ",max_copy_us=" << max_copy_us_ << "i";
+    cout << ",n_dropped_events=";
+    cout << n_dropped_events - n_dropped_events_reported_ << "i";
+    cout << " ";
+    cout << timestamp;
+    cout << endl;
+
+    n_dropped_events_reported_ = n_dropped_events;
+}
@@ -0,0 +1,89 @@
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <zmq.h>
+#include <RamBuffer.hpp>
+#include <SpillBuffer.hpp>
+#include <SpscRing.hpp>
+#include <EventStream.hpp>
+#include <BufferUtils.hpp>
+
+#include "spill_writer_config.hpp"
+#include "SpillStats.hpp"
+
+using namespace std;
+using namespace buffer_config;
+using namespace spill_writer_config;
+
+int main (int argc, char *argv[])
+{
+    if (argc != 2) {
+        cout << endl;
+        cout << "Usage: jf_spill_writer [detector_json_filename]" << endl;
+        cout << "\tdetector_json_filename: detector config file path." << endl;
+        cout << endl;
+
+        exit(-1);
+    }
+
+    const auto config = BufferUtils::read_json_config(string(argv[1]));
+    if (config.spill_buffer.filename.empty()) {
+        cout << "No spill_buffer_file in the detector config." << endl;
+        exit(-1);
+    }
+
+    auto ctx = zmq_ctx_new();
+    zmq_ctx_set(ctx, ZMQ_IO_THREADS, SPILL_ZMQ_IO_THREADS);
+    EventReceiver receiver(ctx, config.detector_name, "assembler",
+                           sizeof(ImageMetadata), config.event_transport);
+
+    RamBuffer ram_buffer(config.detector_name, config.n_modules,
+                         config.ram_buffer.n_slots, config.ram_buffer);
+    SpillBuffer spill_buffer(config.spill_buffer.filename, config.n_modules,
+                             config.spill_buffer.n_slots, true);
+    SpillStats stats(config.detector_name, config.n_modules,
+                     SPILL_STATS_MODULO, receiver);
+
+    // Images are copied out of the RamBuffer as soon as they are assembled,
+    // the writer thread waits for the disk.
+    const auto record_bytes = spill_buffer.get_record_bytes();
+    auto staging = (char*) aligned_alloc(
+            SPILL_BUFFER_ALIGNMENT, SPILL_N_STAGED_IMAGES * record_bytes);
+    auto staged_images = new SpscRing<char*, SPILL_N_STAGED_IMAGES>();
+
+    thread writer([&] {
+        while (true) {
+            auto record = staged_images->wait_read();
+            spill_buffer.write_record(record);
+            staged_images->release_read();
+        }
+    });
+
+    uint64_t n_staged_images = 0;
+    ImageMetadata meta;
+    while (true) {
+        receiver.recv(&meta);
+
+        auto slot = staged_images->acquire_write();
+        if (slot == nullptr) {
+            stats.record_dropped_image();
+            continue;
+        }
+
+        *slot = staging +
+                ((n_staged_images % SPILL_N_STAGED_IMAGES) * record_bytes);
+
+        stats.start_image_copy();
+        const auto n_copied = spill_buffer.copy_image(
+                ram_buffer, meta.pulse_id, *slot);
+        stats.end_image_copy(n_copied);
+
+        if (n_copied == 0) {
+            continue;
+        }
+
+        staged_images->commit_write();
+        n_staged_images++;
+    }
+}
@@ -1,8 +1,11 @@
 #ifndef SF_DAQ_BUFFER_FRAMEUDPRECEIVER_HPP
 #define SF_DAQ_BUFFER_FRAMEUDPRECEIVER_HPP
 
+#include <memory>
 #include <netinet/in.h>
 #include "PacketUdpReceiver.hpp"
+#include "PacketFrameEngine.hpp"
+#include "RamBuffer.hpp"
 #include "formats.hpp"
 #include "buffer_config.hpp"
 
@@ -10,26 +13,83 @@ class FrameUdpReceiver {
     const int module_id_;
 
     PacketUdpReceiver udp_receiver_;
+    // Assembles the frames in their RamBuffer slots.
+    JungfrauFrameEngine engine_;
 
-    jungfrau_packet packet_buffer_[buffer_config::BUFFER_UDP_N_RECV_MSG];
-    iovec recv_buff_ptr_[buffer_config::BUFFER_UDP_N_RECV_MSG];
-    mmsghdr msgs_[buffer_config::BUFFER_UDP_N_RECV_MSG];
     sockaddr_in sock_from_[buffer_config::BUFFER_UDP_N_RECV_MSG];
 
-    bool packet_buffer_loaded_ = false;
-    int packet_buffer_n_packets_ = 0;
-    int packet_buffer_offset_ = 0;
+    int n_packets_ = 0;
+    int i_packet_ = 0;
 
-    inline void init_frame(ModuleFrame& frame_metadata, const int i_packet);
-    inline void copy_packet_to_buffers(
-            ModuleFrame& metadata, char* frame_buffer, const int i_packet);
-    inline uint64_t process_packets(
-            const int n_packets, ModuleFrame& metadata, char* frame_buffer);
+    // Zero-copy receive: headers are scattered into header_buffer_, data
+    // lands directly in the RamBuffer slot where we expect the packet to go.
+    jungfrau_header header_buffer_[buffer_config::BUFFER_UDP_N_RECV_MSG];
+    char* data_ptr_[buffer_config::BUFFER_UDP_N_RECV_MSG];
+    // Packets that did not land in place wait here until they are placed.
+    char park_buffer_[buffer_config::BUFFER_UDP_N_RECV_MSG]
+                     [JUNGFRAU_DATA_BYTES_PER_PACKET];
+    iovec zc_recv_buff_ptr_[2 * buffer_config::BUFFER_UDP_N_RECV_MSG];
+    mmsghdr zc_msgs_[buffer_config::BUFFER_UDP_N_RECV_MSG];
+
+    // Kernel receive timestamps, only with enable_recv_timestamps.
+    bool recv_timestamps_ = false;
+    char cmsg_buffer_[buffer_config::BUFFER_UDP_N_RECV_MSG]
+                     [CMSG_SPACE(sizeof(timespec))];
+    uint64_t recv_ns_[buffer_config::BUFFER_UDP_N_RECV_MSG];
+    uint64_t last_frame_recv_ns_ = 0;
+
+    // Frames with a pulse_id or frame_index that cannot follow the last
+    // frame are assembled here, not over a committed RamBuffer slot.
+    std::unique_ptr<char[]> scratch_slot_;
+    bool last_frame_in_buffer_ = false;
+
+    uint64_t last_pulse_id_ = 0;
+    uint64_t pulse_id_step_ = 1;
+
+    inline int prepare_zc_recv(const RamBuffer& buffer);
+    inline uint64_t get_packet_recv_ns(const int i_packet);
+    inline void fixup_zc_packets(const RamBuffer& buffer);
+    inline bool is_valid_frame(const ModuleFrame& meta) const;
+    inline uint64_t next_zc_frame(ModuleFrame& metadata,
+                                  const RamBuffer& buffer,
+                                  const int recv_flags);
 
 public:
-    FrameUdpReceiver(const uint16_t port, const int module_id);
+    FrameUdpReceiver(const uint16_t port,
+                     const int module_id,
+                     const BufferUtils::UdpRecvBackend backend=
+                             BufferUtils::UdpRecvBackend::RECVMMSG,
+                     const std::string& interface_name="",
+                     const int busy_poll_us=0,
+                     const int reorder_window=1);
     virtual ~FrameUdpReceiver();
-    uint64_t get_frame_from_udp(ModuleFrame& metadata, char* frame_buffer);
+
+    // Receive the next frame directly into its RamBuffer slot. The frame
+    // data is in place when this returns; only the metadata is left for the
+    // caller to commit.
+    // Frames are returned in frame_index order. A frame is returned when it
+    // is complete, or when a packet for a frame reorder_window frames newer
+    // arrives; until then its late packets are still accepted.
+    uint64_t get_frame_into_buffer(ModuleFrame& metadata,
+                                   const RamBuffer& buffer);
+
+    // Non blocking get_frame_into_buffer, for many receivers on one thread.
+    // Returns 0 once the socket is drained and no frame is finished.
+    uint64_t poll_frame_into_buffer(ModuleFrame& metadata,
+                                    const RamBuffer& buffer);
+
+    // Kernel receive time (CLOCK_REALTIME ns) of the first packet of the last
+    // frame returned by get/poll_frame_into_buffer. 0 if not enabled.
+    void enable_recv_timestamps();
+    uint64_t get_last_frame_recv_ns() const;
+
+    // False if the last frame returned by get/poll_frame_into_buffer did not
+    // follow the previous one: its data is not in the RamBuffer. Otherwise
+    // its slot is being written until the caller commits or aborts it.
+    bool is_last_frame_in_buffer() const;
+
+    // Readable when packets are waiting - for poll/epoll.
+    int get_fd() const;
 };
 
 
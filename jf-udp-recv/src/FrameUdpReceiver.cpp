@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <cstring>
+#include <sstream>
 #include <jungfrau.hpp>
 #include "FrameUdpReceiver.hpp"
 
@@ -7,19 +9,41 @@ using namespace buffer_config;
 
 FrameUdpReceiver::FrameUdpReceiver(
         const uint16_t port,
-        const int module_id) :
-            module_id_(module_id)
+        const int module_id,
+        const BufferUtils::UdpRecvBackend backend,
+        const string& interface_name,
+        const int busy_poll_us,
+        const int reorder_window) :
+            module_id_(module_id),
+            engine_(module_id, 0, JF_N_PACKETS_PER_FRAME, reorder_window),
+            scratch_slot_(make_unique<char[]>(MODULE_N_BYTES))
 {
-    udp_receiver_.bind(port);
+    if (reorder_window < 1 || reorder_window > BUFFER_UDP_MAX_REORDER_WINDOW) {
+        stringstream err_msg;
 
-    for (int i = 0; i < BUFFER_UDP_N_RECV_MSG; i++) {
-        recv_buff_ptr_[i].iov_base = (void*) &(packet_buffer_[i]);
-        recv_buff_ptr_[i].iov_len = sizeof(jungfrau_packet);
+        err_msg << "[FrameUdpReceiver::FrameUdpReceiver]";
+        err_msg << " Invalid reorder_window " << reorder_window;
+        err_msg << ", must be between 1 and ";
+        err_msg << BUFFER_UDP_MAX_REORDER_WINDOW << endl;
 
-        msgs_[i].msg_hdr.msg_iov = &recv_buff_ptr_[i];
-        msgs_[i].msg_hdr.msg_iovlen = 1;
-        msgs_[i].msg_hdr.msg_name = &sock_from_[i];
-        msgs_[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        throw runtime_error(err_msg.str());
+    }
+
+    udp_receiver_.bind(port, backend, interface_name, busy_poll_us);
+
+    for (size_t i = 0; i < BUFFER_UDP_N_RECV_MSG; i++) {
+        zc_recv_buff_ptr_[2*i].iov_base = (void*) &(header_buffer_[i]);
+        zc_recv_buff_ptr_[2*i].iov_len = sizeof(jungfrau_header);
+        // Data iov_base is set before each receive.
+        zc_recv_buff_ptr_[2*i + 1].iov_base = nullptr;
+        zc_recv_buff_ptr_[2*i + 1].iov_len = JUNGFRAU_DATA_BYTES_PER_PACKET;
+
+        zc_msgs_[i].msg_hdr.msg_iov = &zc_recv_buff_ptr_[2*i];
+        zc_msgs_[i].msg_hdr.msg_iovlen = 2;
+        zc_msgs_[i].msg_hdr.msg_name = &sock_from_[i];
+        zc_msgs_[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        zc_msgs_[i].msg_hdr.msg_control = nullptr;
+        zc_msgs_[i].msg_hdr.msg_controllen = 0;
     }
 }
 
@@ -27,111 +51,211 @@ FrameUdpReceiver::~FrameUdpReceiver() {
     udp_receiver_.disconnect();
 }
 
-inline void FrameUdpReceiver::init_frame(
-        ModuleFrame& frame_metadata, const int i_packet)
+inline int FrameUdpReceiver::prepare_zc_recv(const RamBuffer& buffer)
 {
-    frame_metadata.pulse_id = packet_buffer_[i_packet].bunchid;
-    frame_metadata.frame_index = packet_buffer_[i_packet].framenum;
-    frame_metadata.daq_rec = (uint64_t) packet_buffer_[i_packet].debug;
-    frame_metadata.module_id = (int64_t) module_id_;
+    char* landing_slot;
+    int first_packetnum;
+
+    const auto newest_frame = engine_.get_newest_frame();
+
+    // Newest frame in progress - land right after its last received packet.
+    if (newest_frame != nullptr &&
+        newest_frame->next_packetnum < JF_N_PACKETS_PER_FRAME) {
+        landing_slot = newest_frame->buffer;
+        first_packetnum = newest_frame->next_packetnum;
+
+    // Otherwise land on the slot of the predicted next pulse_id.
+    } else {
+        const bool in_buffer = (newest_frame != nullptr) ?
+                newest_frame->buffer != scratch_slot_.get() :
+                last_frame_in_buffer_;
+        const auto pulse_id = (newest_frame != nullptr) ?
+                newest_frame->meta.pulse_id : last_pulse_id_;
+
+        // Never predict from a bad frame, its slot might be a recent one.
+        landing_slot = scratch_slot_.get();
+        if (in_buffer) {
+            // The packets land before the frame is known, the slot is
+            // being written from now on.
+            const auto next_pulse_id = pulse_id + pulse_id_step_;
+            buffer.begin_frame_write(next_pulse_id, module_id_);
+            landing_slot = buffer.get_frame_slot(next_pulse_id, module_id_);
+        }
+        first_packetnum = 0;
+    }
+
+    // Never land past the end of the frame slot.
+    const int n_msgs = min(JF_N_PACKETS_PER_FRAME - first_packetnum,
+                           (int) BUFFER_UDP_N_RECV_MSG);
+
+    for (int i = 0; i < n_msgs; i++) {
+        data_ptr_[i] = landing_slot +
+                (JUNGFRAU_DATA_BYTES_PER_PACKET * (first_packetnum + i));
+        zc_recv_buff_ptr_[2*i + 1].iov_base = data_ptr_[i];
+    }
+
+    // The kernel sets msg_controllen to the received control length.
+    if (recv_timestamps_) {
+        for (int i = 0; i < n_msgs; i++) {
+            zc_msgs_[i].msg_hdr.msg_controllen = sizeof(cmsg_buffer_[i]);
+        }
+    }
+
+    return n_msgs;
 }
 
-inline void FrameUdpReceiver::copy_packet_to_buffers(
-        ModuleFrame& metadata, char* frame_buffer, const int i_packet)
+inline uint64_t FrameUdpReceiver::get_packet_recv_ns(const int i_packet)
 {
-    size_t frame_buffer_offset =
-            JUNGFRAU_DATA_BYTES_PER_PACKET * packet_buffer_[i_packet].packetnum;
-    memcpy(
-            (void*) (frame_buffer + frame_buffer_offset),
-            packet_buffer_[i_packet].data,
-            JUNGFRAU_DATA_BYTES_PER_PACKET);
-
-    metadata.n_recv_packets++;
+    if (!recv_timestamps_) {
+        return 0;
+    }
+
+    auto& msg = zc_msgs_[i_packet].msg_hdr;
+
+    for (auto cmsg = CMSG_FIRSTHDR(&msg);
+         cmsg != nullptr;
+         cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+
+        if (cmsg->cmsg_level == SOL_SOCKET &&
+            cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+
+            timespec recv_time;
+            memcpy(&recv_time, CMSG_DATA(cmsg), sizeof(timespec));
+
+            return (recv_time.tv_sec * 1000000000ULL) + recv_time.tv_nsec;
+        }
+    }
+
+    return 0;
 }
 
-inline uint64_t FrameUdpReceiver::process_packets(
-        const int start_offset,
-        ModuleFrame& metadata,
-        char* frame_buffer)
+inline void FrameUdpReceiver::fixup_zc_packets(const RamBuffer& buffer)
 {
-    for (int i_packet=start_offset;
-         i_packet < packet_buffer_n_packets_;
-         i_packet++) {
-
-        // First packet for this frame.
-        if (metadata.pulse_id == 0) {
-            init_frame(metadata, i_packet);
-
-        // Happens if the last packet from the previous frame gets lost.
-        // In the jungfrau_packet, framenum is the trigger number (how many triggers from detector power-on) happened
-        } else if (metadata.frame_index != packet_buffer_[i_packet].framenum) {
-            packet_buffer_loaded_ = true;
-            // Continue on this packet.
-            packet_buffer_offset_ = i_packet;
-
-            return metadata.pulse_id;
+    // Packets that did not land in their final place are parked in the
+    // park buffer before anything is written, so that placing one packet
+    // cannot overwrite the data of another one still waiting in the slot.
+    for (int i_packet=0; i_packet < n_packets_; i_packet++) {
+        const auto& header = header_buffer_[i_packet];
+
+        if (header.packetnum >= JF_N_PACKETS_PER_FRAME) {
+            continue;
         }
 
-        copy_packet_to_buffers(metadata, frame_buffer, i_packet);
-
-        // Last frame packet received. Frame finished.
-        if (packet_buffer_[i_packet].packetnum ==
-            JF_N_PACKETS_PER_FRAME - 1)
-        {
-            // Buffer is loaded only if this is not the last message.
-            if (i_packet+1 != packet_buffer_n_packets_) {
-                packet_buffer_loaded_ = true;
-                // Continue on next packet.
-                packet_buffer_offset_ = i_packet + 1;
-
-            // If i_packet is the last packet the buffer is empty.
-            } else {
-                packet_buffer_loaded_ = false;
-                packet_buffer_offset_ = 0;
-            }
+        char* frame_data = buffer.get_frame_slot(header.bunchid, module_id_) +
+                (JUNGFRAU_DATA_BYTES_PER_PACKET * header.packetnum);
 
-            return metadata.pulse_id;
+        if (data_ptr_[i_packet] != frame_data) {
+            memcpy(park_buffer_[i_packet],
+                   data_ptr_[i_packet],
+                   JUNGFRAU_DATA_BYTES_PER_PACKET);
+            data_ptr_[i_packet] = park_buffer_[i_packet];
         }
     }
-    // We emptied the buffer.
-    packet_buffer_loaded_ = false;
-    packet_buffer_offset_ = 0;
+}
 
-    return 0;
+inline bool FrameUdpReceiver::is_valid_frame(const ModuleFrame& meta) const
+{
+    return meta.frame_index > engine_.get_last_frame_index() &&
+           meta.pulse_id > last_pulse_id_ &&
+           meta.pulse_id - last_pulse_id_ <= BUFFER_UDP_MAX_PULSE_ID_STEP;
 }
 
-uint64_t FrameUdpReceiver::get_frame_from_udp(
-        ModuleFrame& metadata, char* frame_buffer)
+inline uint64_t FrameUdpReceiver::next_zc_frame(
+        ModuleFrame& metadata, const RamBuffer& buffer, const int recv_flags)
 {
-    // Reset the metadata and frame buffer for the next frame.
-    metadata.pulse_id = 0;
-    metadata.n_recv_packets = 0;
-    memset(frame_buffer, 0, JUNGFRAU_DATA_BYTES_PER_FRAME);
+    // A bogus pulse_id must not overwrite a recent frame in its slot.
+    auto get_frame_buffer = [this, &buffer](const ModuleFrame& meta) {
+        if (!is_valid_frame(meta)) {
+            return scratch_slot_.get();
+        }
 
-    // Happens when last packet from previous frame was missed.
-    if (packet_buffer_loaded_) {
+        buffer.begin_frame_write(meta.pulse_id, module_id_);
+        return buffer.get_frame_slot(meta.pulse_id, module_id_);
+    };
 
-        auto pulse_id = process_packets(
-                packet_buffer_offset_, metadata, frame_buffer);
+    while (true) {
+        // Leftover packets of the last batch are processed first.
+        auto pulse_id = engine_.add_packets(
+                header_buffer_, data_ptr_,
+                recv_timestamps_ ? recv_ns_ : nullptr,
+                n_packets_, i_packet_, metadata, get_frame_buffer);
 
         if (pulse_id != 0) {
+            const auto& frame = engine_.get_last_frame();
+
+            last_frame_recv_ns_ = frame.recv_ns;
+            last_frame_in_buffer_ = frame.buffer != scratch_slot_.get();
+
+            if (last_frame_in_buffer_ && last_pulse_id_ != 0 &&
+                pulse_id > last_pulse_id_) {
+                pulse_id_step_ = pulse_id - last_pulse_id_;
+            }
+            last_pulse_id_ = pulse_id;
+
             return pulse_id;
         }
-    }
 
-    while (true) {
+        const auto n_msgs = prepare_zc_recv(buffer);
 
-        packet_buffer_n_packets_ = udp_receiver_.receive_many(
-                msgs_, BUFFER_UDP_N_RECV_MSG);
+        n_packets_ = udp_receiver_.receive_many(zc_msgs_, n_msgs, recv_flags);
+        i_packet_ = 0;
+
+        if (n_packets_ <= 0) {
+            n_packets_ = 0;
+
+            // Socket drained, the frames continue on the next call.
+            if (recv_flags & MSG_DONTWAIT) {
+                return 0;
+            }
 
-        if (packet_buffer_n_packets_ == 0) {
             continue;
         }
 
-        auto pulse_id = process_packets(0, metadata, frame_buffer);
+        fixup_zc_packets(buffer);
 
-        if (pulse_id != 0) {
-            return pulse_id;
+        if (recv_timestamps_) {
+            for (int i = 0; i < n_packets_; i++) {
+                recv_ns_[i] = get_packet_recv_ns(i);
+            }
         }
     }
 }
+
+uint64_t FrameUdpReceiver::get_frame_into_buffer(
+        ModuleFrame& metadata, const RamBuffer& buffer)
+{
+    return next_zc_frame(metadata, buffer, 0);
+}
+
+uint64_t FrameUdpReceiver::poll_frame_into_buffer(
+        ModuleFrame& metadata, const RamBuffer& buffer)
+{
+    return next_zc_frame(metadata, buffer, MSG_DONTWAIT);
+}
+
+void FrameUdpReceiver::enable_recv_timestamps()
+{
+    udp_receiver_.enable_timestamps();
+
+    for (size_t i = 0; i < BUFFER_UDP_N_RECV_MSG; i++) {
+        zc_msgs_[i].msg_hdr.msg_control = cmsg_buffer_[i];
+        zc_msgs_[i].msg_hdr.msg_controllen = sizeof(cmsg_buffer_[i]);
+    }
+
+    recv_timestamps_ = true;
+}
+
+uint64_t FrameUdpReceiver::get_last_frame_recv_ns() const
+{
+    return last_frame_recv_ns_;
+}
+
+bool FrameUdpReceiver::is_last_frame_in_buffer() const
+{
+    return last_frame_in_buffer_;
+}
+
+int FrameUdpReceiver::get_fd() const
+{
+    return udp_receiver_.get_fd();
+}
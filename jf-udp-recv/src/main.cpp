@@ -1,7 +1,14 @@
 #include <iostream>
 #include <stdexcept>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstring>
+#include <sys/epoll.h>
 #include <zmq.h>
 #include <RamBuffer.hpp>
+#include <PulseTracer.hpp>
+#include <EventStream.hpp>
 
 #include "formats.hpp"
 #include "buffer_config.hpp"
@@ -14,62 +21,231 @@ using namespace chrono;
 using namespace buffer_config;
 using namespace BufferUtils;
 
+struct ModuleReceiver {
+    const int module_id;
+    FrameUdpReceiver receiver;
+    EventSender sender;
+    FrameStats stats;
+
+    ModuleFrame meta;
+    uint64_t pulse_id_previous = 0;
+    uint64_t frame_index_previous = 0;
+
+    ModuleReceiver(const DetectorConfig& config,
+                   const int module_id,
+                   void* ctx) :
+            module_id(module_id),
+            receiver(config.start_udp_port + module_id, module_id,
+                     config.udp_recv_backend, config.udp_recv_interface,
+                     config.udp_recv_busy_poll_us,
+                     config.udp_recv_reorder_window),
+            sender(ctx, config.detector_name, to_string(module_id),
+                   sizeof(uint64_t), config.event_transport),
+            stats(config.detector_name, module_id, JF_N_PACKETS_PER_FRAME,
+                  STATS_TIME, sender)
+    {
+        if (config.latency_trace) {
+            receiver.enable_recv_timestamps();
+        }
+    }
+};
+
+void commit_frame(ModuleReceiver& module,
+                  const uint64_t pulse_id,
+                  const RamBuffer& buffer,
+                  const PulseTracer& tracer)
+{
+    bool bad_pulse_id = false;
+
+    // The receiver did not land the data of a bad frame in the buffer.
+    if ( !module.receiver.is_last_frame_in_buffer() ||
+         ( module.meta.frame_index != (module.frame_index_previous+1) ) ||
+         ( pulse_id <= module.pulse_id_previous ) ||
+         ( (pulse_id-module.pulse_id_previous) >
+           BUFFER_UDP_MAX_PULSE_ID_STEP ) ) {
+
+        bad_pulse_id = true;
+
+        if (module.receiver.is_last_frame_in_buffer()) {
+            buffer.abort_frame_write(pulse_id, module.module_id);
+        }
+
+    } else {
+
+        buffer.commit_frame(module.meta);
+
+        tracer.record(TraceStage::MODULE_RECV, pulse_id,
+                      module.receiver.get_last_frame_recv_ns(),
+                      module.module_id);
+        tracer.record_now(TraceStage::MODULE_COMMIT, pulse_id,
+                          module.module_id);
+
+        module.sender.send(&pulse_id);
+
+    }
+
+    module.stats.record_stats(module.meta, bad_pulse_id);
+
+    module.pulse_id_previous = pulse_id;
+    module.frame_index_previous = module.meta.frame_index;
+}
+
+void receive_module(ModuleReceiver& module,
+                    const RamBuffer& buffer,
+                    const PulseTracer& tracer)
+{
+    while (true) {
+        // Frame data is received directly into the RamBuffer slot.
+        auto pulse_id = module.receiver.get_frame_into_buffer(
+                module.meta, buffer);
+
+        commit_frame(module, pulse_id, buffer, tracer);
+    }
+}
+
+void setup_receiver_thread(const DetectorConfig& config, const int core_id)
+{
+    if (core_id >= 0) {
+        pin_thread_to_core(core_id);
+    }
+
+    if (config.udp_recv_rt_priority > 0) {
+        set_thread_rt_priority(config.udp_recv_rt_priority);
+    }
+}
+
+void receive_modules(vector<unique_ptr<ModuleReceiver>>& modules,
+                     const RamBuffer& buffer,
+                     const PulseTracer& tracer,
+                     const DetectorConfig& config,
+                     const int core_id)
+{
+    setup_receiver_thread(config, core_id);
+
+    auto epoll_fd = epoll_create1(0);
+    if (epoll_fd < 0) {
+        throw runtime_error(
+                "Cannot create epoll. " + string(strerror(errno)));
+    }
+
+    for (auto& module : modules) {
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.ptr = module.get();
+
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD,
+                      module->receiver.get_fd(), &event) == -1) {
+            throw runtime_error(
+                    "Cannot add socket to epoll. " + string(strerror(errno)));
+        }
+    }
+
+    vector<epoll_event> events(modules.size());
+    // Busy poll spins on epoll as well.
+    const int epoll_timeout = (config.udp_recv_busy_poll_us > 0) ? 0 : -1;
+
+    while (true) {
+        auto n_events = epoll_wait(
+                epoll_fd, events.data(), events.size(), epoll_timeout);
+
+        for (int i_event = 0; i_event < n_events; i_event++) {
+            auto module = (ModuleReceiver*) events[i_event].data.ptr;
+
+            // Drain the socket, it can hold more than one frame.
+            while (auto pulse_id = module->receiver.poll_frame_into_buffer(
+                    module->meta, buffer)) {
+
+                commit_frame(*module, pulse_id, buffer, tracer);
+            }
+        }
+    }
+}
+
 int main (int argc, char *argv[]) {
 
-    if (argc != 3) {
+    if (argc != 3 && argc != 4) {
         cout << endl;
         cout << "Usage: jf_udp_recv [detector_json_filename] [module_id]";
         cout << endl;
+        cout << "       jf_udp_recv [detector_json_filename]";
+        cout << " [start_module_id] [stop_module_id]" << endl;
         cout << "\tdetector_json_filename: detector config file path." << endl;
         cout << "\tmodule_id: id of the module for this process." << endl;
+        cout << "\tstart_module_id: first module of this process." << endl;
+        cout << "\tstop_module_id: last module of this process." << endl;
         cout << endl;
 
         exit(-1);
     }
 
     const auto config = read_json_config(string(argv[1]));
-    const int module_id = atoi(argv[2]);
+    const int start_module_id = atoi(argv[2]);
+    const int stop_module_id = (argc == 4) ? atoi(argv[3]) : start_module_id;
 
-    const auto udp_port = config.start_udp_port + module_id;
-    FrameUdpReceiver receiver(udp_port, module_id);
-    RamBuffer buffer(config.detector_name, config.n_modules);
-    FrameStats stats(config.detector_name, module_id, STATS_TIME);
+    if (start_module_id > stop_module_id ||
+        stop_module_id >= config.n_modules) {
+        throw runtime_error("Invalid module range.");
+    }
 
+    RamBuffer buffer(config.detector_name, config.n_modules,
+                     config.ram_buffer.n_slots, config.ram_buffer);
+    PulseTracer tracer(config.detector_name, config.latency_trace,
+                       config.ram_buffer.n_slots);
     auto ctx = zmq_ctx_new();
-    auto socket = bind_socket(ctx, config.detector_name, to_string(module_id));
-
-    ModuleFrame meta;
-    char* data = new char[MODULE_N_BYTES];
 
-    uint64_t pulse_id_previous = 0;
-    uint64_t frame_index_previous = 0; 
-
-    while (true) {
+    if (argc == 3) {
+        ModuleReceiver module(config, start_module_id, ctx);
 
-        auto pulse_id = receiver.get_frame_from_udp(meta, data);
+        // Process per module: the cores are indexed by module_id.
+        const auto& module_cores = config.udp_recv_module_cores;
+        const int core_id =
+                (start_module_id < (int) module_cores.size()) ?
+                module_cores[start_module_id] : -1;
 
-        bool bad_pulse_id = false;
-
-        if ( ( meta.frame_index != (frame_index_previous+1) ) ||
-             ( (pulse_id-pulse_id_previous) <= 0 ) ||
-             ( (pulse_id-pulse_id_previous) > 1000 ) ) {
+        // After the ZMQ IO threads are started, so they do not inherit it.
+        setup_receiver_thread(config, core_id);
+        if (config.udp_recv_mlockall) {
+            lock_process_memory();
+        }
 
-            bad_pulse_id = true;
+        receive_module(module, buffer, tracer);
+    }
 
-        } else { 
+    // One thread per configured core, each with a contiguous module block.
+    const int n_threads = config.udp_recv_cores.empty() ?
+            1 : config.udp_recv_cores.size();
+    const int n_modules = stop_module_id - start_module_id + 1;
 
-            buffer.write_frame(meta, data);
+    vector<vector<unique_ptr<ModuleReceiver>>> thread_modules(n_threads);
+    for (int i_module = 0; i_module < n_modules; i_module++) {
+        auto i_thread = (i_module * n_threads) / n_modules;
 
-            zmq_send(socket, &pulse_id, sizeof(pulse_id), 0);
+        thread_modules[i_thread].push_back(make_unique<ModuleReceiver>(
+                config, start_module_id + i_module, ctx));
+    }
 
+    vector<thread> receivers;
+    for (int i_thread = 0; i_thread < n_threads; i_thread++) {
+        if (thread_modules[i_thread].empty()) {
+            continue;
         }
 
-        stats.record_stats(meta, bad_pulse_id);
+        const int core_id = config.udp_recv_cores.empty() ?
+                -1 : config.udp_recv_cores[i_thread];
 
-        pulse_id_previous = pulse_id;
-        frame_index_previous = meta.frame_index;
+        receivers.emplace_back(receive_modules,
+                               ref(thread_modules[i_thread]),
+                               cref(buffer),
+                               cref(tracer),
+                               cref(config),
+                               core_id);
+    }
 
+    if (config.udp_recv_mlockall) {
+        lock_process_memory();
     }
 
-    delete[] data;
+    for (auto& receiver : receivers) {
+        receiver.join();
+    }
 }
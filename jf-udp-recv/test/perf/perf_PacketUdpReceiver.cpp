@@ -0,0 +1,145 @@
+#include <iostream>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <cstring>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include "jungfrau.hpp"
+#include "buffer_config.hpp"
+#include "BufferUtils.hpp"
+#include "PacketUdpReceiver.hpp"
+
+using namespace std;
+using namespace buffer_config;
+
+const uint16_t PERF_UDP_PORT = 13100;
+const int PERF_SEND_BATCH = 64;
+
+void send_packets(const uint16_t port, const size_t n_packets)
+{
+    auto send_socket_fd = socket(AF_INET, SOCK_DGRAM, 0);
+
+    sockaddr_in server_address = {0};
+    server_address.sin_family = AF_INET;
+    server_address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    server_address.sin_port = htons(port);
+
+    jungfrau_packet send_buffer[PERF_SEND_BATCH];
+    iovec send_buff_ptr[PERF_SEND_BATCH];
+    mmsghdr msgs[PERF_SEND_BATCH];
+
+    for (int i = 0; i < PERF_SEND_BATCH; i++) {
+        memset(&send_buffer[i], 0, sizeof(jungfrau_packet));
+
+        send_buff_ptr[i].iov_base = &send_buffer[i];
+        send_buff_ptr[i].iov_len = JUNGFRAU_BYTES_PER_PACKET;
+
+        memset(&msgs[i], 0, sizeof(mmsghdr));
+        msgs[i].msg_hdr.msg_iov = &send_buff_ptr[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_name = &server_address;
+        msgs[i].msg_hdr.msg_namelen = sizeof(server_address);
+    }
+
+    size_t n_sent = 0;
+    while (n_sent < n_packets) {
+        for (int i = 0; i < PERF_SEND_BATCH; i++) {
+            send_buffer[i].packetnum = (n_sent + i) % JF_N_PACKETS_PER_FRAME;
+            send_buffer[i].bunchid = (n_sent + i) / JF_N_PACKETS_PER_FRAME;
+        }
+
+        auto n_batch = min((size_t) PERF_SEND_BATCH, n_packets - n_sent);
+        auto n_batch_sent = sendmmsg(send_socket_fd, msgs, n_batch, 0);
+        if (n_batch_sent > 0) {
+            n_sent += n_batch_sent;
+        }
+    }
+
+    close(send_socket_fd);
+}
+
+void run_backend(const string& name,
+                 const BufferUtils::UdpRecvBackend backend,
+                 const size_t n_packets)
+{
+    jungfrau_packet recv_buffer[BUFFER_UDP_N_RECV_MSG];
+    iovec recv_buff_ptr[BUFFER_UDP_N_RECV_MSG];
+    mmsghdr msgs[BUFFER_UDP_N_RECV_MSG];
+
+    for (int i = 0; i < BUFFER_UDP_N_RECV_MSG; i++) {
+        recv_buff_ptr[i].iov_base = &recv_buffer[i];
+        recv_buff_ptr[i].iov_len = sizeof(jungfrau_packet);
+
+        memset(&msgs[i], 0, sizeof(mmsghdr));
+        msgs[i].msg_hdr.msg_iov = &recv_buff_ptr[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    PacketUdpReceiver udp_receiver;
+    udp_receiver.bind(PERF_UDP_PORT, backend, "lo");
+
+    auto start_time = chrono::steady_clock::now();
+    thread sender(send_packets, PERF_UDP_PORT, n_packets);
+
+    size_t n_received = 0;
+    size_t n_bytes = 0;
+    auto last_packet_time = start_time;
+
+    // Stop after a few timeouts without packets - the rest is lost.
+    int n_timeouts = 0;
+    while (n_received < n_packets && n_timeouts < 100) {
+        auto n_msgs = udp_receiver.receive_many(msgs, BUFFER_UDP_N_RECV_MSG);
+
+        if (n_msgs <= 0) {
+            n_timeouts++;
+            continue;
+        }
+
+        n_timeouts = 0;
+        n_received += n_msgs;
+        for (int i = 0; i < n_msgs; i++) {
+            n_bytes += msgs[i].msg_len;
+        }
+        last_packet_time = chrono::steady_clock::now();
+    }
+
+    sender.join();
+    udp_receiver.disconnect();
+
+    auto elapsed_us = chrono::duration_cast<chrono::microseconds>(
+            last_packet_time - start_time).count();
+    if (elapsed_us == 0) {
+        elapsed_us = 1;
+    }
+
+    cout << name;
+    cout << " n_received=" << n_received << "/" << n_packets;
+    cout << " elapsed_ms=" << elapsed_us / 1000;
+    cout << " packets_per_s=" << (n_received * 1000000) / elapsed_us;
+    cout << " gbit_per_s=" << (n_bytes * 8.0) / (elapsed_us * 1000.0);
+    cout << endl;
+}
+
+int main (int argc, char *argv[])
+{
+    if (argc != 2) {
+        cout << endl;
+        cout << "Usage: jf_udp_recv_perf [n_packets]" << endl;
+        cout << "\tn_packets: Number of packets to send over loopback.";
+        cout << endl;
+        cout << endl;
+
+        exit(-1);
+    }
+
+    const size_t n_packets = (size_t) atoll(argv[1]);
+
+    run_backend("recvmmsg", BufferUtils::UdpRecvBackend::RECVMMSG, n_packets);
+    run_backend("packet_mmap",
+                BufferUtils::UdpRecvBackend::PACKET_MMAP, n_packets);
+
+    return 0;
+}
@@ -2,6 +2,8 @@
 #include <jungfrau.hpp>
 #include "gtest/gtest.h"
 #include "FrameUdpReceiver.hpp"
+#include "RamBuffer.hpp"
+#include "PacketBitmap.hpp"
 #include "mock/udp.hpp"
 
 #include <thread>
@@ -13,7 +15,8 @@ using namespace std;
 TEST(BufferUdpReceiver, simple_recv)
 {
     auto n_packets = JF_N_PACKETS_PER_FRAME;
-    int source_id = 1234;
+    int n_modules = 2;
+    int source_id = 1;
     int n_frames = 5;
 
     uint16_t udp_port = MOCK_UDP_PORT;
@@ -22,6 +25,8 @@ TEST(BufferUdpReceiver, simple_recv)
     ASSERT_TRUE(send_socket_fd >= 0);
 
     FrameUdpReceiver udp_receiver(udp_port, source_id);
+    RamBuffer::remove("test_detector_simple");
+    RamBuffer buffer("test_detector_simple", n_modules, 10);
 
     auto handle = async(launch::async, [&](){
         for (int i_frame=0; i_frame < n_frames; i_frame++){
@@ -46,11 +51,15 @@ TEST(BufferUdpReceiver, simple_recv)
     handle.wait();
 
     ModuleFrame metadata;
-    auto frame_buffer = make_unique<char[]>(JUNGFRAU_DATA_BYTES_PER_FRAME);
 
+    // Only the missing packets of a frame may be zeroed in its slot.
     for (int i_frame=0; i_frame < n_frames; i_frame++) {
-        auto pulse_id = udp_receiver.get_frame_from_udp(
-                metadata, frame_buffer.get());
+        memset(buffer.get_frame_slot(i_frame + 1, source_id), 0xFF,
+               JUNGFRAU_DATA_BYTES_PER_FRAME);
+    }
+
+    for (int i_frame=0; i_frame < n_frames; i_frame++) {
+        auto pulse_id = udp_receiver.get_frame_into_buffer(metadata, buffer);
 
         ASSERT_EQ(i_frame + 1, pulse_id);
         ASSERT_EQ(metadata.frame_index, i_frame + 1000);
@@ -61,12 +70,14 @@ TEST(BufferUdpReceiver, simple_recv)
     }
 
     ::close(send_socket_fd);
+    RamBuffer::remove("test_detector_simple");
 }
 
 TEST(BufferUdpReceiver, missing_middle_packet)
 {
     auto n_packets = JF_N_PACKETS_PER_FRAME;
-    int source_id = 1234;
+    int n_modules = 2;
+    int source_id = 1;
     int n_frames = 3;
 
     uint16_t udp_port = MOCK_UDP_PORT;
@@ -75,6 +86,8 @@ TEST(BufferUdpReceiver, missing_middle_packet)
     ASSERT_TRUE(send_socket_fd >= 0);
 
     FrameUdpReceiver udp_receiver(udp_port, source_id);
+    RamBuffer::remove("test_detector_missing_middle");
+    RamBuffer buffer("test_detector_missing_middle", n_modules, 10);
 
     auto handle = async(launch::async, [&](){
         for (int i_frame=0; i_frame < n_frames; i_frame++){
@@ -104,11 +117,15 @@ TEST(BufferUdpReceiver, missing_middle_packet)
     handle.wait();
 
     ModuleFrame metadata;
-    auto frame_buffer = make_unique<char[]>(JUNGFRAU_DATA_BYTES_PER_FRAME);
+
+    // Only the missing packets of a frame may be zeroed in its slot.
+    for (int i_frame=0; i_frame < n_frames; i_frame++) {
+        memset(buffer.get_frame_slot(i_frame + 1, source_id), 0xFF,
+               JUNGFRAU_DATA_BYTES_PER_FRAME);
+    }
 
     for (int i_frame=0; i_frame < n_frames; i_frame++) {
-        auto pulse_id = udp_receiver.get_frame_from_udp(
-                metadata, frame_buffer.get());
+        auto pulse_id = udp_receiver.get_frame_into_buffer(metadata, buffer);
 
         ASSERT_EQ(i_frame + 1, pulse_id);
         ASSERT_EQ(metadata.frame_index, i_frame + 1000);
@@ -116,15 +133,101 @@ TEST(BufferUdpReceiver, missing_middle_packet)
         // -1 because we skipped a packet.
         ASSERT_EQ(metadata.n_recv_packets, n_packets - 1);
         ASSERT_EQ(metadata.module_id, source_id);
+
+        ASSERT_FALSE(PacketBitmap::is_set(metadata.packets_bitmap, 10));
+        ASSERT_TRUE(PacketBitmap::is_set(metadata.packets_bitmap, 9));
+        ASSERT_TRUE(PacketBitmap::is_set(metadata.packets_bitmap, 11));
+
+        // Only the missing packet is zeroed.
+        auto missing_data = buffer.get_frame_slot(pulse_id, source_id) +
+                (10 * JUNGFRAU_DATA_BYTES_PER_PACKET);
+        for (size_t i = 0; i < JUNGFRAU_DATA_BYTES_PER_PACKET; i++) {
+            ASSERT_EQ(missing_data[i], 0);
+        }
+    }
+
+    ::close(send_socket_fd);
+    RamBuffer::remove("test_detector_missing_middle");
+}
+
+TEST(BufferUdpReceiver, duplicate_packet)
+{
+    auto n_packets = JF_N_PACKETS_PER_FRAME;
+    int n_modules = 2;
+    int source_id = 1;
+    int n_frames = 3;
+
+    uint16_t udp_port = MOCK_UDP_PORT;
+    auto server_address = get_server_address(udp_port);
+    auto send_socket_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_TRUE(send_socket_fd >= 0);
+
+    FrameUdpReceiver udp_receiver(udp_port, source_id);
+    RamBuffer::remove("test_detector_duplicate");
+    RamBuffer buffer("test_detector_duplicate", n_modules, 10);
+
+    auto handle = async(launch::async, [&](){
+        for (int i_frame=0; i_frame < n_frames; i_frame++){
+            for (size_t i_packet=0; i_packet<n_packets; i_packet++) {
+                // Packet 10 is lost, packet 20 arrives twice.
+                if (i_packet == 10) {
+                    continue;
+                }
+
+                jungfrau_packet send_udp_buffer;
+                send_udp_buffer.packetnum = i_packet;
+                send_udp_buffer.bunchid = i_frame + 1;
+                send_udp_buffer.framenum = i_frame + 1000;
+                send_udp_buffer.debug = i_frame + 10000;
+
+                int n_sends = (i_packet == 20) ? 2 : 1;
+                for (int i_send=0; i_send < n_sends; i_send++) {
+                    ::sendto(
+                            send_socket_fd,
+                            &send_udp_buffer,
+                            JUNGFRAU_BYTES_PER_PACKET,
+                            0,
+                            (sockaddr*) &server_address,
+                            sizeof(server_address));
+                }
+            }
+        }
+    });
+
+    handle.wait();
+
+    ModuleFrame metadata;
+
+    // Only the missing packets of a frame may be zeroed in its slot.
+    for (int i_frame=0; i_frame < n_frames; i_frame++) {
+        memset(buffer.get_frame_slot(i_frame + 1, source_id), 0xFF,
+               JUNGFRAU_DATA_BYTES_PER_FRAME);
+    }
+
+    for (int i_frame=0; i_frame < n_frames; i_frame++) {
+        auto pulse_id = udp_receiver.get_frame_into_buffer(metadata, buffer);
+
+        ASSERT_EQ(i_frame + 1, pulse_id);
+        // The duplicate must not make up for the lost packet.
+        ASSERT_EQ(metadata.n_recv_packets, n_packets - 1);
+        ASSERT_FALSE(PacketBitmap::is_set(metadata.packets_bitmap, 10));
+
+        auto missing_data = buffer.get_frame_slot(pulse_id, source_id) +
+                (10 * JUNGFRAU_DATA_BYTES_PER_PACKET);
+        for (size_t i = 0; i < JUNGFRAU_DATA_BYTES_PER_PACKET; i++) {
+            ASSERT_EQ(missing_data[i], 0);
+        }
     }
 
     ::close(send_socket_fd);
+    RamBuffer::remove("test_detector_duplicate");
 }
 
 TEST(BufferUdpReceiver, missing_first_packet)
 {
     auto n_packets = JF_N_PACKETS_PER_FRAME;
-    int source_id = 1234;
+    int n_modules = 2;
+    int source_id = 1;
     int n_frames = 3;
 
     uint16_t udp_port = MOCK_UDP_PORT;
@@ -133,6 +236,8 @@ TEST(BufferUdpReceiver, missing_first_packet)
     ASSERT_TRUE(send_socket_fd >= 0);
 
     FrameUdpReceiver udp_receiver(udp_port, source_id);
+    RamBuffer::remove("test_detector_missing_first");
+    RamBuffer buffer("test_detector_missing_first", n_modules, 10);
 
     auto handle = async(launch::async, [&](){
         for (int i_frame=0; i_frame < n_frames; i_frame++){
@@ -162,11 +267,15 @@ TEST(BufferUdpReceiver, missing_first_packet)
     handle.wait();
 
     ModuleFrame metadata;
-    auto frame_buffer = make_unique<char[]>(JUNGFRAU_DATA_BYTES_PER_FRAME);
 
+    // Only the missing packets of a frame may be zeroed in its slot.
     for (int i_frame=0; i_frame < n_frames; i_frame++) {
-        auto pulse_id = udp_receiver.get_frame_from_udp(
-                metadata, frame_buffer.get());
+        memset(buffer.get_frame_slot(i_frame + 1, source_id), 0xFF,
+               JUNGFRAU_DATA_BYTES_PER_FRAME);
+    }
+
+    for (int i_frame=0; i_frame < n_frames; i_frame++) {
+        auto pulse_id = udp_receiver.get_frame_into_buffer(metadata, buffer);
 
         ASSERT_EQ(i_frame + 1, pulse_id);
         ASSERT_EQ(metadata.frame_index, i_frame + 1000);
@@ -177,12 +286,14 @@ TEST(BufferUdpReceiver, missing_first_packet)
     }
 
     ::close(send_socket_fd);
+    RamBuffer::remove("test_detector_missing_first");
 }
 
 TEST(BufferUdpReceiver, missing_last_packet)
 {
     auto n_packets = JF_N_PACKETS_PER_FRAME;
-    int source_id = 1234;
+    int n_modules = 2;
+    int source_id = 1;
     int n_frames = 3;
 
     uint16_t udp_port = MOCK_UDP_PORT;
@@ -191,6 +302,8 @@ TEST(BufferUdpReceiver, missing_last_packet)
     ASSERT_TRUE(send_socket_fd >= 0);
 
     FrameUdpReceiver udp_receiver(udp_port, source_id);
+    RamBuffer::remove("test_detector_missing_last");
+    RamBuffer buffer("test_detector_missing_last", n_modules, 10);
 
     auto handle = async(launch::async, [&](){
         for (int i_frame=0; i_frame < n_frames; i_frame++){
@@ -220,12 +333,16 @@ TEST(BufferUdpReceiver, missing_last_packet)
     handle.wait();
 
     ModuleFrame metadata;
-    auto frame_buffer = make_unique<char[]>(JUNGFRAU_DATA_BYTES_PER_FRAME);
+
+    // Only the missing packets of a frame may be zeroed in its slot.
+    for (int i_frame=0; i_frame < n_frames; i_frame++) {
+        memset(buffer.get_frame_slot(i_frame + 1, source_id), 0xFF,
+               JUNGFRAU_DATA_BYTES_PER_FRAME);
+    }
 
     // n_frames -1 because the last frame is not complete.
     for (int i_frame=0; i_frame < n_frames - 1; i_frame++) {
-        auto pulse_id = udp_receiver.get_frame_from_udp(
-                metadata, frame_buffer.get());
+        auto pulse_id = udp_receiver.get_frame_into_buffer(metadata, buffer);
 
         ASSERT_EQ(i_frame + 1, pulse_id);
         ASSERT_EQ(metadata.frame_index, i_frame + 1000);
@@ -236,4 +353,479 @@ TEST(BufferUdpReceiver, missing_last_packet)
     }
 
     ::close(send_socket_fd);
-}
\ No newline at end of file
+    RamBuffer::remove("test_detector_missing_last");
+}
+
+TEST(BufferUdpReceiver, zero_copy_recv)
+{
+    auto n_packets = JF_N_PACKETS_PER_FRAME;
+    int n_modules = 2;
+    int source_id = 1;
+    int n_frames = 5;
+
+    uint16_t udp_port = MOCK_UDP_PORT;
+    auto server_address = get_server_address(udp_port);
+    auto send_socket_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_TRUE(send_socket_fd >= 0);
+
+    FrameUdpReceiver udp_receiver(udp_port, source_id);
+    RamBuffer::remove("test_detector_zc");
+    RamBuffer buffer("test_detector_zc", n_modules, 10);
+
+    auto handle = async(launch::async, [&](){
+        for (int i_frame=0; i_frame < n_frames; i_frame++){
+            for (size_t i_packet=0; i_packet<n_packets; i_packet++) {
+                // Skip some random middle packet in the third frame.
+                if (i_frame == 2 && i_packet == 10) {
+                    continue;
+                }
+
+                jungfrau_packet send_udp_buffer;
+                send_udp_buffer.packetnum = i_packet;
+                send_udp_buffer.bunchid = i_frame + 1;
+                send_udp_buffer.framenum = i_frame + 1000;
+                send_udp_buffer.debug = i_frame + 10000;
+                memset(send_udp_buffer.data, i_packet + i_frame,
+                       JUNGFRAU_DATA_BYTES_PER_PACKET);
+
+                ::sendto(
+                        send_socket_fd,
+                        &send_udp_buffer,
+                        JUNGFRAU_BYTES_PER_PACKET,
+                        0,
+                        (sockaddr*) &server_address,
+                        sizeof(server_address));
+            }
+        }
+    });
+
+    handle.wait();
+
+    ModuleFrame metadata;
+
+    for (int i_frame=0; i_frame < n_frames; i_frame++) {
+        auto pulse_id = udp_receiver.get_frame_into_buffer(metadata, buffer);
+
+        ASSERT_EQ(i_frame + 1, pulse_id);
+        ASSERT_EQ(metadata.frame_index, i_frame + 1000);
+        ASSERT_EQ(metadata.daq_rec, i_frame + 10000);
+        ASSERT_EQ(metadata.module_id, source_id);
+
+        auto frame_data = buffer.get_frame_slot(pulse_id, source_id);
+
+        for (size_t i_packet=0; i_packet<n_packets; i_packet++) {
+            auto packet_data = frame_data +
+                    (i_packet * JUNGFRAU_DATA_BYTES_PER_PACKET);
+
+            // Missing packets are zeroed.
+            char expected = (i_frame == 2 && i_packet == 10) ?
+                    0 : (char) (i_packet + i_frame);
+
+            ASSERT_EQ(packet_data[0], expected);
+            ASSERT_EQ(packet_data[JUNGFRAU_DATA_BYTES_PER_PACKET-1], expected);
+        }
+
+        if (i_frame == 2) {
+            ASSERT_EQ(metadata.n_recv_packets, n_packets - 1);
+            ASSERT_FALSE(PacketBitmap::is_set(metadata.packets_bitmap, 10));
+        } else {
+            ASSERT_EQ(metadata.n_recv_packets, n_packets);
+        }
+    }
+
+    ::close(send_socket_fd);
+}
+
+TEST(BufferUdpReceiver, poll_recv)
+{
+    auto n_packets = JF_N_PACKETS_PER_FRAME;
+    int n_modules = 2;
+    int source_id = 0;
+
+    uint16_t udp_port = MOCK_UDP_PORT;
+    auto server_address = get_server_address(udp_port);
+    auto send_socket_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_TRUE(send_socket_fd >= 0);
+
+    FrameUdpReceiver udp_receiver(udp_port, source_id);
+    RamBuffer::remove("test_detector_poll");
+    RamBuffer buffer("test_detector_poll", n_modules, 10);
+
+    auto send_packets = [&](int i_frame, size_t start, size_t stop) {
+        for (size_t i_packet=start; i_packet<stop; i_packet++) {
+            jungfrau_packet send_udp_buffer;
+            send_udp_buffer.packetnum = i_packet;
+            send_udp_buffer.bunchid = i_frame + 1;
+            send_udp_buffer.framenum = i_frame + 1000;
+            send_udp_buffer.debug = i_frame + 10000;
+            memset(send_udp_buffer.data, i_packet + i_frame,
+                   JUNGFRAU_DATA_BYTES_PER_PACKET);
+
+            ::sendto(
+                    send_socket_fd,
+                    &send_udp_buffer,
+                    JUNGFRAU_BYTES_PER_PACKET,
+                    0,
+                    (sockaddr*) &server_address,
+                    sizeof(server_address));
+        }
+    };
+
+    ModuleFrame metadata;
+
+    // Nothing received yet.
+    ASSERT_EQ(udp_receiver.poll_frame_into_buffer(metadata, buffer), 0);
+
+    // Half a frame - the frame stays open.
+    send_packets(0, 0, n_packets/2);
+    this_thread::sleep_for(chrono::milliseconds(10));
+    ASSERT_EQ(udp_receiver.poll_frame_into_buffer(metadata, buffer), 0);
+
+    // The rest of the frame and the next frame in one drain.
+    send_packets(0, n_packets/2, n_packets);
+    send_packets(1, 0, n_packets);
+    this_thread::sleep_for(chrono::milliseconds(10));
+
+    for (int i_frame=0; i_frame < 2; i_frame++) {
+        auto pulse_id = udp_receiver.poll_frame_into_buffer(metadata, buffer);
+
+        ASSERT_EQ(i_frame + 1, pulse_id);
+        ASSERT_EQ(metadata.frame_index, i_frame + 1000);
+        ASSERT_EQ(metadata.n_recv_packets, n_packets);
+
+        auto frame_data = buffer.get_frame_slot(pulse_id, source_id);
+        for (size_t i_packet=0; i_packet<n_packets; i_packet++) {
+            auto packet_data = frame_data +
+                    (i_packet * JUNGFRAU_DATA_BYTES_PER_PACKET);
+            ASSERT_EQ(packet_data[0], (char) (i_packet + i_frame));
+        }
+    }
+
+    ASSERT_EQ(udp_receiver.poll_frame_into_buffer(metadata, buffer), 0);
+
+    ::close(send_socket_fd);
+}
+
+TEST(BufferUdpReceiver, reorder_window)
+{
+    auto n_packets = JF_N_PACKETS_PER_FRAME;
+    int n_modules = 2;
+    int source_id = 1;
+    int n_frames = 5;
+
+    uint16_t udp_port = MOCK_UDP_PORT;
+    auto server_address = get_server_address(udp_port);
+    auto send_socket_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_TRUE(send_socket_fd >= 0);
+
+    FrameUdpReceiver udp_receiver(
+            udp_port, source_id, BufferUtils::UdpRecvBackend::RECVMMSG,
+            "", 0, 2);
+    RamBuffer::remove("test_detector_reorder");
+    RamBuffer buffer("test_detector_reorder", n_modules, 10);
+
+    auto send_packets = [&](int i_frame, size_t start, size_t stop) {
+        for (size_t i_packet=start; i_packet<stop; i_packet++) {
+            // Missing packet in the third frame.
+            if (i_frame == 2 && i_packet == 5) {
+                continue;
+            }
+
+            jungfrau_packet send_udp_buffer;
+            send_udp_buffer.packetnum = i_packet;
+            send_udp_buffer.bunchid = i_frame + 1;
+            send_udp_buffer.framenum = i_frame + 1000;
+            send_udp_buffer.debug = i_frame + 10000;
+            memset(send_udp_buffer.data, i_packet + i_frame,
+                   JUNGFRAU_DATA_BYTES_PER_PACKET);
+
+            ::sendto(
+                    send_socket_fd,
+                    &send_udp_buffer,
+                    JUNGFRAU_BYTES_PER_PACKET,
+                    0,
+                    (sockaddr*) &server_address,
+                    sizeof(server_address));
+        }
+    };
+
+    // The first 2 frames are interleaved.
+    send_packets(0, 0, 100);
+    send_packets(1, 0, 50);
+    send_packets(0, 100, n_packets);
+    send_packets(1, 50, n_packets);
+    for (int i_frame=2; i_frame < n_frames; i_frame++) {
+        send_packets(i_frame, 0, n_packets);
+    }
+
+    ModuleFrame metadata;
+
+    for (int i_frame=0; i_frame < n_frames; i_frame++) {
+        auto pulse_id = udp_receiver.get_frame_into_buffer(metadata, buffer);
+
+        ASSERT_EQ(i_frame + 1, pulse_id);
+        ASSERT_EQ(metadata.frame_index, i_frame + 1000);
+
+        auto frame_data = buffer.get_frame_slot(pulse_id, source_id);
+
+        for (size_t i_packet=0; i_packet<n_packets; i_packet++) {
+            auto packet_data = frame_data +
+                    (i_packet * JUNGFRAU_DATA_BYTES_PER_PACKET);
+
+            char expected = (i_frame == 2 && i_packet == 5) ?
+                    0 : (char) (i_packet + i_frame);
+
+            ASSERT_EQ(packet_data[0], expected);
+            ASSERT_EQ(packet_data[JUNGFRAU_DATA_BYTES_PER_PACKET-1], expected);
+        }
+
+        if (i_frame == 2) {
+            ASSERT_EQ(metadata.n_recv_packets, n_packets - 1);
+        } else {
+            ASSERT_EQ(metadata.n_recv_packets, n_packets);
+        }
+    }
+
+    ::close(send_socket_fd);
+}
+
+TEST(BufferUdpReceiver, recv_timestamps)
+{
+    auto n_packets = JF_N_PACKETS_PER_FRAME;
+    int n_modules = 1;
+    int source_id = 0;
+
+    uint16_t udp_port = MOCK_UDP_PORT;
+    auto server_address = get_server_address(udp_port);
+    auto send_socket_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_TRUE(send_socket_fd >= 0);
+
+    FrameUdpReceiver udp_receiver(udp_port, source_id);
+    udp_receiver.enable_recv_timestamps();
+    RamBuffer::remove("test_detector_timestamps");
+    RamBuffer buffer("test_detector_timestamps", n_modules, 10);
+
+    timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    const uint64_t send_ns = (now.tv_sec * 1000000000ULL) + now.tv_nsec;
+
+    for (size_t i_packet=0; i_packet<n_packets; i_packet++) {
+        jungfrau_packet send_udp_buffer;
+        send_udp_buffer.packetnum = i_packet;
+        send_udp_buffer.bunchid = 1;
+        send_udp_buffer.framenum = 1000;
+        send_udp_buffer.debug = 10000;
+
+        ::sendto(
+                send_socket_fd,
+                &send_udp_buffer,
+                JUNGFRAU_BYTES_PER_PACKET,
+                0,
+                (sockaddr*) &server_address,
+                sizeof(server_address));
+    }
+
+    ModuleFrame metadata;
+    auto pulse_id = udp_receiver.get_frame_into_buffer(metadata, buffer);
+    ASSERT_EQ(pulse_id, 1);
+    ASSERT_EQ(metadata.n_recv_packets, n_packets);
+
+    auto recv_ns = udp_receiver.get_last_frame_recv_ns();
+    ASSERT_GE(recv_ns, send_ns);
+    ASSERT_LT(recv_ns - send_ns, 1000000000ULL);
+
+    ::close(send_socket_fd);
+}
+
+TEST(BufferUdpReceiver, bad_pulse_id)
+{
+    auto n_packets = JF_N_PACKETS_PER_FRAME;
+    int n_modules = 1;
+    int source_id = 0;
+
+    uint16_t udp_port = MOCK_UDP_PORT;
+    auto server_address = get_server_address(udp_port);
+    auto send_socket_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_TRUE(send_socket_fd >= 0);
+
+    FrameUdpReceiver udp_receiver(udp_port, source_id);
+    RamBuffer::remove("test_detector_bad_pulse");
+    RamBuffer buffer("test_detector_bad_pulse", n_modules, 10);
+
+    auto send_frame = [&](uint64_t pulse_id, uint64_t frame_index, char value) {
+        for (size_t i_packet=0; i_packet<n_packets; i_packet++) {
+            jungfrau_packet send_udp_buffer;
+            send_udp_buffer.packetnum = i_packet;
+            send_udp_buffer.bunchid = pulse_id;
+            send_udp_buffer.framenum = frame_index;
+            send_udp_buffer.debug = 0;
+            memset(send_udp_buffer.data, value,
+                   JUNGFRAU_DATA_BYTES_PER_PACKET);
+
+            ::sendto(
+                    send_socket_fd,
+                    &send_udp_buffer,
+                    JUNGFRAU_BYTES_PER_PACKET,
+                    0,
+                    (sockaddr*) &server_address,
+                    sizeof(server_address));
+        }
+    };
+
+    send_frame(1, 1000, 1);
+    send_frame(2, 1001, 2);
+    // Pulse_id going backwards, and way ahead.
+    send_frame(1, 1002, 3);
+    send_frame(5000, 1003, 4);
+    send_frame(5003, 1004, 5);
+
+    ModuleFrame metadata;
+
+    ASSERT_EQ(udp_receiver.get_frame_into_buffer(metadata, buffer), 1);
+    ASSERT_TRUE(udp_receiver.is_last_frame_in_buffer());
+    ASSERT_EQ(udp_receiver.get_frame_into_buffer(metadata, buffer), 2);
+    ASSERT_TRUE(udp_receiver.is_last_frame_in_buffer());
+
+    ASSERT_EQ(udp_receiver.get_frame_into_buffer(metadata, buffer), 1);
+    ASSERT_FALSE(udp_receiver.is_last_frame_in_buffer());
+    ASSERT_EQ(udp_receiver.get_frame_into_buffer(metadata, buffer), 5000);
+    ASSERT_FALSE(udp_receiver.is_last_frame_in_buffer());
+
+    // The frame after the jump follows it again.
+    ASSERT_EQ(udp_receiver.get_frame_into_buffer(metadata, buffer), 5003);
+    ASSERT_TRUE(udp_receiver.is_last_frame_in_buffer());
+
+    // The received frames were not overwritten.
+    for (uint64_t pulse_id = 1; pulse_id <= 2; pulse_id++) {
+        auto frame_data = buffer.get_frame_slot(pulse_id, source_id);
+        ASSERT_EQ(frame_data[0], (char) pulse_id);
+        ASSERT_EQ(frame_data[buffer_config::MODULE_N_BYTES-1], (char) pulse_id);
+    }
+
+    ::close(send_socket_fd);
+    RamBuffer::remove("test_detector_bad_pulse");
+}
+
+TEST(BufferUdpReceiver, late_packet_and_frame_reset)
+{
+    auto n_packets = JF_N_PACKETS_PER_FRAME;
+    int n_modules = 1;
+    int source_id = 0;
+
+    uint16_t udp_port = MOCK_UDP_PORT;
+    auto server_address = get_server_address(udp_port);
+    auto send_socket_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_TRUE(send_socket_fd >= 0);
+
+    FrameUdpReceiver udp_receiver(udp_port, source_id);
+    RamBuffer::remove("test_detector_late");
+    RamBuffer buffer("test_detector_late", n_modules, 10);
+
+    auto send_packets = [&](uint64_t pulse_id, uint64_t frame_index,
+                            size_t start, size_t stop) {
+        for (size_t i_packet=start; i_packet<stop; i_packet++) {
+            jungfrau_packet send_udp_buffer;
+            send_udp_buffer.packetnum = i_packet;
+            send_udp_buffer.bunchid = pulse_id;
+            send_udp_buffer.framenum = frame_index;
+            send_udp_buffer.debug = 0;
+            memset(send_udp_buffer.data, (char) pulse_id,
+                   JUNGFRAU_DATA_BYTES_PER_PACKET);
+
+            ::sendto(
+                    send_socket_fd,
+                    &send_udp_buffer,
+                    JUNGFRAU_BYTES_PER_PACKET,
+                    0,
+                    (sockaddr*) &server_address,
+                    sizeof(server_address));
+        }
+    };
+
+    send_packets(1, 5000, 0, n_packets);
+    send_packets(2, 5001, 0, n_packets);
+    // Late packets of the closed frames do not open them again.
+    send_packets(1, 5000, 3, 4);
+    send_packets(2, 5001, 5, 6);
+    send_packets(3, 5002, 0, n_packets);
+    // The detector frame counter starts over.
+    send_packets(4, 1, 0, n_packets);
+    send_packets(5, 2, 0, n_packets);
+
+    ModuleFrame metadata;
+
+    for (uint64_t pulse_id = 1; pulse_id <= 5; pulse_id++) {
+        ASSERT_EQ(udp_receiver.get_frame_into_buffer(metadata, buffer),
+                  pulse_id);
+        ASSERT_EQ(metadata.n_recv_packets, n_packets);
+        ASSERT_TRUE(udp_receiver.is_last_frame_in_buffer());
+        ASSERT_EQ(metadata.frame_index,
+                  (pulse_id <= 3) ? 4999 + pulse_id : pulse_id - 3);
+    }
+
+    for (uint64_t pulse_id = 1; pulse_id <= 5; pulse_id++) {
+        auto frame_data = buffer.get_frame_slot(pulse_id, source_id);
+        ASSERT_EQ(frame_data[0], (char) pulse_id);
+        ASSERT_EQ(frame_data[buffer_config::MODULE_N_BYTES-1],
+                  (char) pulse_id);
+    }
+
+    ::close(send_socket_fd);
+    RamBuffer::remove("test_detector_late");
+}
+
+TEST(BufferUdpReceiver, late_packet_of_committed_frame)
+{
+    auto n_packets = JF_N_PACKETS_PER_FRAME;
+    int n_modules = 1;
+    int source_id = 0;
+
+    uint16_t udp_port = MOCK_UDP_PORT;
+    auto server_address = get_server_address(udp_port);
+    auto send_socket_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_TRUE(send_socket_fd >= 0);
+
+    FrameUdpReceiver udp_receiver(udp_port, source_id);
+    RamBuffer::remove("test_detector_committed");
+    RamBuffer buffer("test_detector_committed", n_modules, 10);
+
+    auto send_packets = [&](uint64_t pulse_id, uint64_t frame_index,
+                            size_t start, size_t stop) {
+        for (size_t i_packet=start; i_packet<stop; i_packet++) {
+            jungfrau_packet send_udp_buffer;
+            send_udp_buffer.packetnum = i_packet;
+            send_udp_buffer.bunchid = pulse_id;
+            send_udp_buffer.framenum = frame_index;
+            send_udp_buffer.debug = 0;
+
+            ::sendto(
+                    send_socket_fd,
+                    &send_udp_buffer,
+                    JUNGFRAU_BYTES_PER_PACKET,
+                    0,
+                    (sockaddr*) &server_address,
+                    sizeof(server_address));
+        }
+    };
+
+    ModuleFrame metadata;
+
+    send_packets(1, 1, 0, n_packets);
+    ASSERT_EQ(udp_receiver.get_frame_into_buffer(metadata, buffer), 1);
+    buffer.commit_frame(metadata);
+    ASSERT_NE(buffer.begin_read_image(1), RamBuffer::INVALID_GENERATION);
+
+    // Late and duplicate packets, and a garbage pulse_id in the slot of 1.
+    send_packets(1, 1, 3, 4);
+    send_packets(1, 1, 3, 4);
+    send_packets(11, 1, 5, 6);
+    send_packets(2, 2, 0, n_packets);
+    ASSERT_EQ(udp_receiver.get_frame_into_buffer(metadata, buffer), 2);
+    buffer.commit_frame(metadata);
+
+    ASSERT_NE(buffer.begin_read_image(1), RamBuffer::INVALID_GENERATION);
+    ASSERT_NE(buffer.begin_read_image(2), RamBuffer::INVALID_GENERATION);
+
+    ::close(send_socket_fd);
+    RamBuffer::remove("test_detector_committed");
+}
@@ -4,6 +4,8 @@
 #include "mock/udp.hpp"
 #include "PacketUdpReceiver.hpp"
 
+#include <cerrno>
+#include <cstring>
 #include <thread>
 #include <chrono>
 
@@ -120,6 +122,8 @@ TEST(PacketUdpReceiver, receive_many)
         msgs[i].msg_hdr.msg_iovlen = 1;
         msgs[i].msg_hdr.msg_name = &sockFrom[i];
         msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        msgs[i].msg_hdr.msg_control = nullptr;
+        msgs[i].msg_hdr.msg_controllen = 0;
     }
 
     uint16_t udp_port = MOCK_UDP_PORT;
@@ -167,4 +171,136 @@ TEST(PacketUdpReceiver, receive_many)
 
     udp_receiver.disconnect();
     ::close(send_socket_fd);
-}
\ No newline at end of file
+}
+
+TEST(PacketUdpReceiver, packet_mmap_receive_many)
+{
+    // The packet socket of the ring needs CAP_NET_RAW.
+    auto packet_socket_fd = socket(AF_PACKET, SOCK_RAW, 0);
+    if (packet_socket_fd < 0) {
+        GTEST_SKIP() << "Cannot open a packet socket: " << strerror(errno);
+    }
+    ::close(packet_socket_fd);
+
+    auto n_msg_buffer = JF_N_PACKETS_PER_FRAME;
+    jungfrau_header header_buffer[n_msg_buffer];
+    char data_buffer[n_msg_buffer][JUNGFRAU_DATA_BYTES_PER_PACKET];
+    iovec recv_buff_ptr[2 * n_msg_buffer];
+    struct mmsghdr msgs[n_msg_buffer];
+    struct sockaddr_in sockFrom[n_msg_buffer];
+
+    // Header and data scattered into separate buffers, as in zero-copy.
+    for (int i = 0; i < n_msg_buffer; i++) {
+        recv_buff_ptr[2*i].iov_base = (void*) &(header_buffer[i]);
+        recv_buff_ptr[2*i].iov_len = sizeof(jungfrau_header);
+        recv_buff_ptr[2*i + 1].iov_base = (void*) data_buffer[i];
+        recv_buff_ptr[2*i + 1].iov_len = JUNGFRAU_DATA_BYTES_PER_PACKET;
+
+        msgs[i].msg_hdr.msg_iov = &recv_buff_ptr[2*i];
+        msgs[i].msg_hdr.msg_iovlen = 2;
+        msgs[i].msg_hdr.msg_name = &sockFrom[i];
+        msgs[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+        msgs[i].msg_hdr.msg_control = nullptr;
+        msgs[i].msg_hdr.msg_controllen = 0;
+    }
+
+    uint16_t udp_port = MOCK_UDP_PORT;
+
+    auto send_socket_fd = socket(AF_INET,SOCK_DGRAM,0);
+    ASSERT_TRUE(send_socket_fd >= 0);
+
+    PacketUdpReceiver udp_receiver;
+    udp_receiver.bind(
+            udp_port, BufferUtils::UdpRecvBackend::PACKET_MMAP, "lo");
+
+    auto server_address = get_server_address(udp_port);
+
+    // Traffic for another port must not end up in the ring.
+    auto other_address = get_server_address(udp_port + 1);
+    jungfrau_packet send_udp_buffer;
+    ::sendto(
+            send_socket_fd,
+            &send_udp_buffer,
+            JUNGFRAU_BYTES_PER_PACKET,
+            0,
+            (sockaddr*) &other_address,
+            sizeof(other_address));
+
+    const int n_packets = 10;
+    for (int i = 0; i < n_packets; i++) {
+        send_udp_buffer.bunchid = i;
+        send_udp_buffer.packetnum = i;
+        memset(send_udp_buffer.data, i, JUNGFRAU_DATA_BYTES_PER_PACKET);
+
+        ::sendto(
+                send_socket_fd,
+                &send_udp_buffer,
+                JUNGFRAU_BYTES_PER_PACKET,
+                0,
+                (sockaddr*) &server_address,
+                sizeof(server_address));
+    }
+
+    int n_msgs = 0;
+    while (n_msgs < n_packets) {
+        auto n_new_msgs = udp_receiver.receive_many(
+                msgs + n_msgs, n_msg_buffer - n_msgs);
+        ASSERT_TRUE(n_new_msgs > 0);
+        n_msgs += n_new_msgs;
+    }
+    ASSERT_EQ(n_msgs, n_packets);
+
+    for (int i = 0; i < n_msgs; i++) {
+        ASSERT_EQ(msgs[i].msg_len, JUNGFRAU_BYTES_PER_PACKET);
+        ASSERT_EQ(header_buffer[i].bunchid, i);
+        ASSERT_EQ(header_buffer[i].packetnum, i);
+        ASSERT_EQ(data_buffer[i][0], i);
+        ASSERT_EQ(data_buffer[i][JUNGFRAU_DATA_BYTES_PER_PACKET-1], i);
+        ASSERT_EQ(sockFrom[i].sin_family, AF_INET);
+    }
+
+    ASSERT_EQ(udp_receiver.receive_many(msgs, n_msg_buffer), -1);
+
+    udp_receiver.disconnect();
+    ::close(send_socket_fd);
+}
+
+TEST(PacketUdpReceiver, busy_poll_receive_many)
+{
+    jungfrau_packet recv_buffer;
+    iovec recv_buff_ptr = {&recv_buffer, sizeof(jungfrau_packet)};
+    mmsghdr msg = {};
+    msg.msg_hdr.msg_iov = &recv_buff_ptr;
+    msg.msg_hdr.msg_iovlen = 1;
+
+    uint16_t udp_port = MOCK_UDP_PORT;
+
+    auto send_socket_fd = socket(AF_INET,SOCK_DGRAM,0);
+    ASSERT_TRUE(send_socket_fd >= 0);
+
+    PacketUdpReceiver udp_receiver;
+    udp_receiver.bind(
+            udp_port, BufferUtils::UdpRecvBackend::RECVMMSG, "", 50);
+
+    // Spinning still times out when nothing arrives.
+    ASSERT_EQ(udp_receiver.receive_many(&msg, 1), -1);
+
+    jungfrau_packet send_udp_buffer;
+    send_udp_buffer.bunchid = 42;
+
+    auto server_address = get_server_address(udp_port);
+    ::sendto(
+            send_socket_fd,
+            &send_udp_buffer,
+            JUNGFRAU_BYTES_PER_PACKET,
+            0,
+            (sockaddr*) &server_address,
+            sizeof(server_address));
+
+    ASSERT_EQ(udp_receiver.receive_many(&msg, 1), 1);
+    ASSERT_EQ(msg.msg_len, JUNGFRAU_BYTES_PER_PACKET);
+    ASSERT_EQ(recv_buffer.bunchid, 42);
+
+    udp_receiver.disconnect();
+    ::close(send_socket_fd);
+}
@@ -0,0 +1,58 @@
+#ifndef SF_DAQ_BUFFER_FRAMEUDPSENDER_HPP
+#define SF_DAQ_BUFFER_FRAMEUDPSENDER_HPP
+
+#include <random>
+#include <vector>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include "SendConfig.hpp"
+
+/** Synthetic detector UDP stream
+
+    Generates the packets of each module frame in send order (after packet
+    loss, duplication and reordering) into one contiguous buffer, and sends
+    them with sendmmsg, optionally grouping packets with UDP_SEGMENT. **/
+class FrameUdpSender {
+    const SendConfig::SendParameters config_;
+    const int n_modules_;
+    const size_t packet_n_bytes_;
+    const int n_module_packets_;
+    // Packets per message: 1, or as many as fit in a UDP_SEGMENT send.
+    const int n_msg_packets_;
+
+    int socket_fd_;
+    std::vector<sockaddr_in> module_address_;
+
+    std::mt19937 random_;
+    std::uniform_real_distribution<double> probability_;
+
+    // Packet numbers of one module frame in send order.
+    std::vector<uint32_t> send_order_;
+    std::vector<char> packet_buffer_;
+    std::vector<char> random_data_;
+
+    std::vector<iovec> send_buff_ptr_;
+    std::vector<mmsghdr> msgs_;
+    std::vector<char> gso_control_;
+
+    inline void build_send_order();
+    inline void fill_data(char* data,
+                          const uint64_t pulse_id,
+                          const uint32_t packetnum);
+    inline void build_packets(const int module_id,
+                              const uint64_t pulse_id,
+                              const uint64_t frame_index);
+    inline size_t send_packets(const int module_id);
+
+public:
+    FrameUdpSender(const SendConfig::SendParameters& config,
+                   const uint16_t start_udp_port,
+                   const int n_modules);
+    virtual ~FrameUdpSender();
+
+    // Send one frame for all modules, returns the number of sent packets.
+    size_t send_frame(const uint64_t pulse_id, const uint64_t frame_index);
+};
+
+
+#endif //SF_DAQ_BUFFER_FRAMEUDPSENDER_HPP
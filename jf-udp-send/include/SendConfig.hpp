@@ -0,0 +1,46 @@
+#ifndef SF_DAQ_BUFFER_SENDCONFIG_HPP
+#define SF_DAQ_BUFFER_SENDCONFIG_HPP
+
+#include <string>
+
+namespace SendConfig
+{
+    enum class PacketFormat {
+        // One jungfrau_packet stream per module, on start_udp_port+module_id.
+        JUNGFRAU,
+        // One jfjoch_packet_t stream for all modules, on start_udp_port.
+        JFJOCH
+    };
+
+    enum class PixelPattern {
+        ZERO,
+        // Every pixel is pulse_id & 0xFFFF.
+        PULSE_ID,
+        // Every pixel of a packet is its packetnum.
+        PACKETNUM,
+        RANDOM
+    };
+
+    struct SendParameters {
+        const PacketFormat packet_format;
+        const std::string address;
+        // Frames per second, 0 sends as fast as possible.
+        const int frame_rate;
+        // Number of frames to send, 0 sends forever.
+        const uint64_t n_frames;
+        const uint64_t start_pulse_id;
+        const uint64_t pulse_id_step;
+        // Probabilities [0, 1] applied to each packet.
+        const double packet_loss;
+        const double packet_reorder;
+        const double packet_duplication;
+        const PixelPattern pixel_pattern;
+        const unsigned int seed;
+        // Send groups of packets with UDP_SEGMENT (GSO).
+        const bool use_gso;
+    };
+
+    SendParameters read_json_config(const std::string& filename);
+}
+
+#endif //SF_DAQ_BUFFER_SENDCONFIG_HPP
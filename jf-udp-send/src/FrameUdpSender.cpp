@@ -0,0 +1,260 @@
+#include "FrameUdpSender.hpp"
+
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <arpa/inet.h>
+#include <netinet/udp.h>
+#include <unistd.h>
+#include "jungfrau.hpp"
+#include "jungfraujoch.hpp"
+
+// Available since Linux 4.18.
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+
+using namespace std;
+using namespace SendConfig;
+
+static_assert(JUNGFRAU_DATA_BYTES_PER_PACKET == JFJOCH_DATA_BYTES_PER_PACKET,
+              "Pixel patterns assume the same packet data size.");
+
+namespace {
+    // Max UDP payload of one UDP_SEGMENT send.
+    const size_t GSO_MAX_BYTES = 65507;
+
+    template <typename T>
+    void fill_header(T& packet,
+                     const int module_id,
+                     const uint32_t packetnum,
+                     const uint64_t pulse_id,
+                     const uint64_t frame_index)
+    {
+        memset(&packet, 0, sizeof(T) - sizeof(packet.data));
+
+        packet.framenum = frame_index;
+        packet.packetnum = packetnum;
+        packet.bunchid = pulse_id;
+        packet.moduleID = module_id;
+    }
+}
+
+FrameUdpSender::FrameUdpSender(
+        const SendParameters& config,
+        const uint16_t start_udp_port,
+        const int n_modules) :
+            config_(config),
+            n_modules_(n_modules),
+            packet_n_bytes_(config.packet_format == PacketFormat::JUNGFRAU ?
+                            JUNGFRAU_BYTES_PER_PACKET :
+                            JFJOCH_BYTES_PER_PACKET),
+            n_module_packets_(JF_N_PACKETS_PER_FRAME),
+            n_msg_packets_(config.use_gso ?
+                           GSO_MAX_BYTES / packet_n_bytes_ : 1),
+            random_(config.seed),
+            probability_(0.0, 1.0)
+{
+    socket_fd_ = socket(AF_INET, SOCK_DGRAM, 0);
+    if (socket_fd_ < 0) {
+        throw runtime_error("Cannot open socket.");
+    }
+
+    if (config_.use_gso) {
+        const int segment_n_bytes = packet_n_bytes_;
+
+        if (setsockopt(socket_fd_, SOL_UDP, UDP_SEGMENT,
+                       &segment_n_bytes, sizeof(int)) == -1) {
+            throw runtime_error(
+                    "Cannot set UDP_SEGMENT. " + string(strerror(errno)));
+        }
+    }
+
+    for (int module_id = 0; module_id < n_modules_; module_id++) {
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+
+        // JungfrauJoch sends all modules to one port.
+        const auto port_offset =
+                (config_.packet_format == PacketFormat::JUNGFRAU) ?
+                module_id : 0;
+        address.sin_port = htons(start_udp_port + port_offset);
+
+        if (inet_pton(AF_INET, config_.address.c_str(),
+                      &address.sin_addr) != 1) {
+            throw runtime_error("Invalid address " + config_.address);
+        }
+
+        module_address_.push_back(address);
+    }
+
+    // Duplication can at most double the packets of a frame.
+    const size_t max_packets = 2 * n_module_packets_;
+    send_order_.reserve(max_packets);
+    packet_buffer_.resize(max_packets * packet_n_bytes_);
+    send_buff_ptr_.resize(max_packets);
+    msgs_.resize(max_packets);
+
+    if (config_.pixel_pattern == PixelPattern::RANDOM) {
+        random_data_.resize(JUNGFRAU_DATA_BYTES_PER_FRAME);
+
+        uniform_int_distribution<int> random_byte(0, 255);
+        for (auto& value : random_data_) {
+            value = random_byte(random_);
+        }
+    }
+}
+
+FrameUdpSender::~FrameUdpSender()
+{
+    close(socket_fd_);
+}
+
+inline void FrameUdpSender::build_send_order()
+{
+    send_order_.clear();
+
+    for (int packetnum = 0; packetnum < n_module_packets_; packetnum++) {
+        if (config_.packet_loss > 0 &&
+            probability_(random_) < config_.packet_loss) {
+            continue;
+        }
+
+        send_order_.push_back(packetnum);
+
+        if (config_.packet_duplication > 0 &&
+            probability_(random_) < config_.packet_duplication) {
+            send_order_.push_back(packetnum);
+        }
+    }
+
+    // Swap neighbouring packets.
+    if (config_.packet_reorder > 0) {
+        for (size_t i = 0; i + 1 < send_order_.size(); i++) {
+            if (probability_(random_) < config_.packet_reorder) {
+                swap(send_order_[i], send_order_[i+1]);
+                i++;
+            }
+        }
+    }
+}
+
+inline void FrameUdpSender::fill_data(
+        char* data, const uint64_t pulse_id, const uint32_t packetnum)
+{
+    auto pixels = (uint16_t*) data;
+    const size_t n_pixels = JUNGFRAU_DATA_BYTES_PER_PACKET / sizeof(uint16_t);
+
+    switch (config_.pixel_pattern) {
+        case PixelPattern::ZERO:
+            memset(data, 0, JUNGFRAU_DATA_BYTES_PER_PACKET);
+            break;
+
+        case PixelPattern::PULSE_ID:
+            fill(pixels, pixels + n_pixels, (uint16_t) pulse_id);
+            break;
+
+        case PixelPattern::PACKETNUM:
+            fill(pixels, pixels + n_pixels, (uint16_t) packetnum);
+            break;
+
+        // Different packet of the random frame for each pulse_id.
+        case PixelPattern::RANDOM: {
+            const auto i_random_packet =
+                    (pulse_id + packetnum) % JF_N_PACKETS_PER_FRAME;
+            memcpy(data,
+                   random_data_.data() +
+                   (i_random_packet * JUNGFRAU_DATA_BYTES_PER_PACKET),
+                   JUNGFRAU_DATA_BYTES_PER_PACKET);
+            break;
+        }
+    }
+}
+
+inline void FrameUdpSender::build_packets(
+        const int module_id,
+        const uint64_t pulse_id,
+        const uint64_t frame_index)
+{
+    build_send_order();
+
+    for (size_t i_packet = 0; i_packet < send_order_.size(); i_packet++) {
+        char* packet = packet_buffer_.data() + (i_packet * packet_n_bytes_);
+        const auto packetnum = send_order_[i_packet];
+
+        if (config_.packet_format == PacketFormat::JUNGFRAU) {
+            auto& jf_packet = *(jungfrau_packet*) packet;
+            fill_header(jf_packet, module_id, packetnum, pulse_id, frame_index);
+            fill_data(jf_packet.data, pulse_id, packetnum);
+
+        } else {
+            // One packet stream for the whole image.
+            auto& jfj_packet = *(jfjoch_packet_t*) packet;
+            fill_header(jfj_packet, module_id,
+                        (module_id * n_module_packets_) + packetnum,
+                        pulse_id, frame_index);
+            fill_data(jfj_packet.data, pulse_id, packetnum);
+        }
+    }
+}
+
+inline size_t FrameUdpSender::send_packets(const int module_id)
+{
+    const int n_packets = send_order_.size();
+    const int n_msgs = (n_packets + n_msg_packets_ - 1) / n_msg_packets_;
+
+    for (int i_msg = 0; i_msg < n_msgs; i_msg++) {
+        const int first_packet = i_msg * n_msg_packets_;
+        const int n_msg_packets = min(n_msg_packets_, n_packets - first_packet);
+
+        send_buff_ptr_[i_msg].iov_base =
+                packet_buffer_.data() + (first_packet * packet_n_bytes_);
+        send_buff_ptr_[i_msg].iov_len = n_msg_packets * packet_n_bytes_;
+
+        memset(&msgs_[i_msg], 0, sizeof(mmsghdr));
+        msgs_[i_msg].msg_hdr.msg_iov = &send_buff_ptr_[i_msg];
+        msgs_[i_msg].msg_hdr.msg_iovlen = 1;
+        msgs_[i_msg].msg_hdr.msg_name = &module_address_[module_id];
+        msgs_[i_msg].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+    }
+
+    int n_sent_msgs = 0;
+    while (n_sent_msgs < n_msgs) {
+        auto n_batch = sendmmsg(socket_fd_,
+                                msgs_.data() + n_sent_msgs,
+                                n_msgs - n_sent_msgs,
+                                0);
+
+        if (n_batch < 0) {
+            // Socket buffer full - retry.
+            if (errno == ENOBUFS || errno == EAGAIN || errno == EINTR) {
+                continue;
+            }
+
+            stringstream err_msg;
+
+            err_msg << "[FrameUdpSender::send_packets]";
+            err_msg << " Error while sending module " << module_id << ": ";
+            err_msg << strerror(errno) << endl;
+
+            throw runtime_error(err_msg.str());
+        }
+
+        n_sent_msgs += n_batch;
+    }
+
+    return n_packets;
+}
+
+size_t FrameUdpSender::send_frame(
+        const uint64_t pulse_id, const uint64_t frame_index)
+{
+    size_t n_sent_packets = 0;
+
+    for (int module_id = 0; module_id < n_modules_; module_id++) {
+        build_packets(module_id, pulse_id, frame_index);
+        n_sent_packets += send_packets(module_id);
+    }
+
+    return n_sent_packets;
+}
@@ -0,0 +1,71 @@
+#include "SendConfig.hpp"
+
+#include <fstream>
+#include <stdexcept>
+#include <rapidjson/istreamwrapper.h>
+#include <rapidjson/document.h>
+
+using namespace std;
+
+namespace {
+    template <typename T>
+    T get_optional(const rapidjson::Document& config_parameters,
+                   const char* name,
+                   const T default_value)
+    {
+        if (!config_parameters.HasMember(name)) {
+            return default_value;
+        }
+
+        return config_parameters[name].Get<T>();
+    }
+}
+
+SendConfig::SendParameters SendConfig::read_json_config(
+        const string& filename)
+{
+    std::ifstream ifs(filename);
+    rapidjson::IStreamWrapper isw(ifs);
+    rapidjson::Document config_parameters;
+    config_parameters.ParseStream(isw);
+
+    auto packet_format = PacketFormat::JUNGFRAU;
+    const string format = get_optional<const char*>(
+            config_parameters, "packet_format", "jungfrau");
+
+    if (format == "jfjoch") {
+        packet_format = PacketFormat::JFJOCH;
+    } else if (format != "jungfrau") {
+        throw runtime_error("Unknown packet_format " + format);
+    }
+
+    auto pixel_pattern = PixelPattern::ZERO;
+    const string pattern = get_optional<const char*>(
+            config_parameters, "pixel_pattern", "zero");
+
+    if (pattern == "pulse_id") {
+        pixel_pattern = PixelPattern::PULSE_ID;
+    } else if (pattern == "packetnum") {
+        pixel_pattern = PixelPattern::PACKETNUM;
+    } else if (pattern == "random") {
+        pixel_pattern = PixelPattern::RANDOM;
+    } else if (pattern != "zero") {
+        throw runtime_error("Unknown pixel_pattern " + pattern);
+    }
+
+    return {
+            packet_format,
+            get_optional<const char*>(
+                    config_parameters, "address", "127.0.0.1"),
+            get_optional<int>(config_parameters, "frame_rate", 100),
+            get_optional<uint64_t>(config_parameters, "n_frames", 0),
+            get_optional<uint64_t>(config_parameters, "start_pulse_id", 1),
+            get_optional<uint64_t>(config_parameters, "pulse_id_step", 1),
+            get_optional<double>(config_parameters, "packet_loss", 0),
+            get_optional<double>(config_parameters, "packet_reorder", 0),
+            get_optional<double>(config_parameters, "packet_duplication", 0),
+            pixel_pattern,
+            get_optional<unsigned int>(config_parameters, "seed", 0),
+            get_optional<bool>(config_parameters, "use_gso", false)
+    };
+}
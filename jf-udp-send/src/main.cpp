@@ -0,0 +1,82 @@
+#include <iostream>
+#include <chrono>
+#include <thread>
+
+#include "buffer_config.hpp"
+#include "BufferUtils.hpp"
+#include "SendConfig.hpp"
+#include "FrameUdpSender.hpp"
+
+using namespace std;
+using namespace chrono;
+using namespace buffer_config;
+
+int main (int argc, char *argv[]) {
+
+    if (argc != 3) {
+        cout << endl;
+        cout << "Usage: jf_udp_send [detector_json_filename]";
+        cout << " [send_json_filename]" << endl;
+        cout << "\tdetector_json_filename: detector config file path." << endl;
+        cout << "\tsend_json_filename: traffic config file path." << endl;
+        cout << endl;
+
+        exit(-1);
+    }
+
+    const auto config = BufferUtils::read_json_config(string(argv[1]));
+    const auto send_config = SendConfig::read_json_config(string(argv[2]));
+
+    FrameUdpSender sender(
+            send_config, config.start_udp_port, config.n_modules);
+
+    const auto frame_period = (send_config.frame_rate > 0) ?
+            nanoseconds(1000000000 / send_config.frame_rate) : nanoseconds(0);
+    auto next_frame_time = steady_clock::now();
+
+    size_t n_sent_frames = 0;
+    size_t n_sent_packets = 0;
+    auto stats_interval_start = steady_clock::now();
+
+    for (uint64_t i_frame = 0;
+         send_config.n_frames == 0 || i_frame < send_config.n_frames;
+         i_frame++) {
+
+        if (send_config.frame_rate > 0) {
+            this_thread::sleep_until(next_frame_time);
+            next_frame_time += frame_period;
+        }
+
+        const auto pulse_id = send_config.start_pulse_id +
+                (i_frame * send_config.pulse_id_step);
+
+        // Receivers expect the frame_index to start from 1.
+        n_sent_packets += sender.send_frame(pulse_id, i_frame + 1);
+        n_sent_frames++;
+
+        auto interval_ms_duration = duration_cast<milliseconds>(
+                steady_clock::now()-stats_interval_start).count();
+
+        if (interval_ms_duration >= (int64_t) (STATS_TIME*1000)) {
+            // * 1000 because milliseconds, + 250 because of truncation.
+            int rep_rate = ((n_sent_frames * 1000) + 250) /
+                    interval_ms_duration;
+            uint64_t timestamp = time_point_cast<nanoseconds>(
+                    system_clock::now()).time_since_epoch().count();
+
+            // Output in InfluxDB line protocol
+            cout << "jf_udp_send";
+            cout << ",detector_name=" << config.detector_name;
+            cout << " ";
+            cout << "n_sent_packets=" << n_sent_packets << "i";
+            cout << ",repetition_rate=" << rep_rate << "i";
+            cout << " ";
+            cout << timestamp;
+            cout << endl;
+
+            n_sent_frames = 0;
+            n_sent_packets = 0;
+            stats_interval_start = steady_clock::now();
+        }
+    }
+}
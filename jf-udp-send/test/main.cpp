@@ -0,0 +1,9 @@
+#include "gtest/gtest.h"
+#include "test_FrameUdpSender.cpp"
+
+using namespace std;
+
+int main(int argc, char **argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,163 @@
+#include <netinet/in.h>
+#include <unistd.h>
+#include <jungfrau.hpp>
+#include <jungfraujoch.hpp>
+#include "gtest/gtest.h"
+#include "FrameUdpSender.hpp"
+
+using namespace std;
+using namespace SendConfig;
+
+const uint16_t TEST_UDP_PORT = 13300;
+
+int bind_test_socket(const uint16_t udp_port)
+{
+    auto socket_fd = socket(AF_INET, SOCK_DGRAM, 0);
+
+    sockaddr_in server_address = {0};
+    server_address.sin_family = AF_INET;
+    server_address.sin_addr.s_addr = INADDR_ANY;
+    server_address.sin_port = htons(udp_port);
+
+    timeval udp_socket_timeout = {0, 100000};
+    setsockopt(socket_fd, SOL_SOCKET, SO_RCVTIMEO,
+               &udp_socket_timeout, sizeof(timeval));
+
+    const int rcvbuf_bytes = 4 * 128 * 8246;
+    setsockopt(socket_fd, SOL_SOCKET, SO_RCVBUF,
+               &rcvbuf_bytes, sizeof(int));
+
+    ::bind(socket_fd, (sockaddr*) &server_address, sizeof(server_address));
+
+    return socket_fd;
+}
+
+SendParameters get_test_config(
+        const PacketFormat packet_format,
+        const double packet_loss=0,
+        const double packet_duplication=0,
+        const bool use_gso=false)
+{
+    return {packet_format, "127.0.0.1", 0, 0, 1, 1,
+            packet_loss, 0, packet_duplication,
+            PixelPattern::PACKETNUM, 0, use_gso};
+}
+
+TEST(FrameUdpSender, jungfrau_frame)
+{
+    int n_modules = 2;
+    auto module_0_fd = bind_test_socket(TEST_UDP_PORT);
+    auto module_1_fd = bind_test_socket(TEST_UDP_PORT + 1);
+
+    FrameUdpSender sender(
+            get_test_config(PacketFormat::JUNGFRAU), TEST_UDP_PORT, n_modules);
+
+    ASSERT_EQ(sender.send_frame(5, 1), n_modules * JF_N_PACKETS_PER_FRAME);
+
+    int module_id = 0;
+    for (auto socket_fd : {module_0_fd, module_1_fd}) {
+        jungfrau_packet packet;
+
+        for (uint32_t i_packet = 0;
+             i_packet < JF_N_PACKETS_PER_FRAME;
+             i_packet++) {
+
+            ASSERT_EQ(recv(socket_fd, &packet, sizeof(packet), 0),
+                      JUNGFRAU_BYTES_PER_PACKET);
+
+            ASSERT_EQ(packet.packetnum, i_packet);
+            ASSERT_EQ(packet.framenum, 1);
+            ASSERT_EQ(packet.bunchid, 5);
+            ASSERT_EQ(packet.moduleID, module_id);
+
+            auto pixels = (uint16_t*) packet.data;
+            ASSERT_EQ(pixels[0], i_packet);
+            ASSERT_EQ(pixels[JUNGFRAU_DATA_BYTES_PER_PACKET/2 - 1], i_packet);
+        }
+
+        // Nothing more for this module.
+        ASSERT_EQ(recv(socket_fd, &packet, sizeof(packet), 0), -1);
+        module_id++;
+    }
+
+    close(module_0_fd);
+    close(module_1_fd);
+}
+
+TEST(FrameUdpSender, jfjoch_frame)
+{
+    int n_modules = 2;
+    auto socket_fd = bind_test_socket(TEST_UDP_PORT);
+
+    FrameUdpSender sender(
+            get_test_config(PacketFormat::JFJOCH), TEST_UDP_PORT, n_modules);
+
+    ASSERT_EQ(sender.send_frame(7, 3), n_modules * JF_N_PACKETS_PER_FRAME);
+
+    jfjoch_packet_t packet;
+
+    // All modules on the same port, with image wide packet numbers.
+    for (uint32_t i_packet = 0;
+         i_packet < n_modules * JF_N_PACKETS_PER_FRAME;
+         i_packet++) {
+
+        ASSERT_EQ(recv(socket_fd, &packet, sizeof(packet), 0),
+                  JFJOCH_BYTES_PER_PACKET);
+
+        ASSERT_EQ(packet.packetnum, i_packet);
+        ASSERT_EQ(packet.framenum, 3);
+        ASSERT_EQ(packet.bunchid, 7);
+        ASSERT_EQ(packet.moduleID, i_packet / JF_N_PACKETS_PER_FRAME);
+    }
+
+    close(socket_fd);
+}
+
+TEST(FrameUdpSender, loss_and_duplication)
+{
+    auto socket_fd = bind_test_socket(TEST_UDP_PORT);
+
+    FrameUdpSender lossy_sender(
+            get_test_config(PacketFormat::JUNGFRAU, 1), TEST_UDP_PORT, 1);
+    ASSERT_EQ(lossy_sender.send_frame(1, 1), 0);
+
+    FrameUdpSender duplicating_sender(
+            get_test_config(PacketFormat::JUNGFRAU, 0, 1), TEST_UDP_PORT, 1);
+    ASSERT_EQ(duplicating_sender.send_frame(1, 1), 2 * JF_N_PACKETS_PER_FRAME);
+
+    jungfrau_packet packet;
+    for (uint32_t i_packet = 0;
+         i_packet < 2 * JF_N_PACKETS_PER_FRAME;
+         i_packet++) {
+
+        ASSERT_EQ(recv(socket_fd, &packet, sizeof(packet), 0),
+                  JUNGFRAU_BYTES_PER_PACKET);
+        ASSERT_EQ(packet.packetnum, i_packet / 2);
+    }
+
+    close(socket_fd);
+}
+
+TEST(FrameUdpSender, udp_segment)
+{
+    auto socket_fd = bind_test_socket(TEST_UDP_PORT);
+
+    FrameUdpSender sender(
+            get_test_config(PacketFormat::JUNGFRAU, 0, 0, true),
+            TEST_UDP_PORT, 1);
+
+    ASSERT_EQ(sender.send_frame(1, 1), JF_N_PACKETS_PER_FRAME);
+
+    // The kernel splits the send back into single packets.
+    jungfrau_packet packet;
+    for (uint32_t i_packet = 0;
+         i_packet < JF_N_PACKETS_PER_FRAME;
+         i_packet++) {
+
+        ASSERT_EQ(recv(socket_fd, &packet, sizeof(packet), 0),
+                  JUNGFRAU_BYTES_PER_PACKET);
+        ASSERT_EQ(packet.packetnum, i_packet);
+    }
+
+    close(socket_fd);
+}
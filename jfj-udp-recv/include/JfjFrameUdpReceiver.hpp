@@ -1,31 +1,39 @@
 #ifndef SF_DAQ_BUFFER_JOCHUDPRECEIVER_HPP
 #define SF_DAQ_BUFFER_JOCHUDPRECEIVER_HPP
 
-#include <netinet/in.h>
 #include "PacketUdpReceiver.hpp"
+#include "PacketFrameEngine.hpp"
 #include "formats.hpp"
 #include "buffer_config.hpp"
-#include "PacketBuffer.hpp"
 #include "jungfraujoch.hpp"
 
 /** JungfrauJoch UDP receiver
 
-    Wrapper class to capture frames from the UDP stream of the JungfrauJoch FPGA card.
-    NOTE: This design will not scale well for higher frame rates...
+    Receives the frames of a single JungfrauJoch UDP stream into a caller
+    buffer with the JfjochFrameEngine. jfj_udp_recv runs the engine over
+    several streams straight into the RamBuffer instead.
 **/
 class JfjFrameUdpReceiver {
     PacketUdpReceiver m_udp_receiver;
-    uint64_t m_frame_index;
-
-    PacketBuffer<jfjoch_packet_t, buffer_config::BUFFER_UDP_N_RECV_MSG> m_buffer;
-
-    inline void init_frame(ModuleFrame& frame_metadata, const jfjoch_packet_t& c_packet);
-    inline uint64_t process_packets(ModuleFrame& metadata, char* frame_buffer);
+    JfjochFrameEngine m_frame_engine;
 
 public:
-    JfjFrameUdpReceiver(const uint16_t port);
+    JfjFrameUdpReceiver(const uint16_t port,
+                        const BufferUtils::UdpRecvBackend backend=
+                                BufferUtils::UdpRecvBackend::RECVMMSG,
+                        const std::string& interface_name="",
+                        const int busy_poll_us=0);
     virtual ~JfjFrameUdpReceiver();
-    uint64_t get_frame_from_udp(ModuleFrame& metadata, char* frame_buffer);
+    // 0 if no packet arrived for timeout_ms (-1 waits forever).
+    uint64_t get_frame_from_udp(ModuleFrame& metadata,
+                                char* frame_buffer,
+                                const int timeout_ms=-1);
+    // Received packets bitmap of the last frame, JF_N_PACKETS_PER_FRAME
+    // bits per module.
+    const uint64_t* get_frame_bitmap() const
+    {
+        return m_frame_engine.get_frame_bitmap();
+    }
 };
 
 
@@ -0,0 +1,26 @@
+#ifndef SF_DAQ_BUFFER_JFJPACKETSTEERING_HPP
+#define SF_DAQ_BUFFER_JFJPACKETSTEERING_HPP
+
+#include <cstdint>
+
+/** JungfrauJoch module to stream mapping
+
+    The JFJ frame is received over n_streams sockets, each one assembling a
+    contiguous block of modules: module m goes to stream m*n_streams/32.
+    Streams on separate ports rely on the detector sending each module to
+    start_udp_port + stream. Streams sharing one port in a SO_REUSEPORT
+    group are steered by a classic BPF program on the packetnum. **/
+namespace JfjPacketSteering
+{
+    int get_stream(const int module_id, const int n_streams);
+
+    // Packets [packet_begin, packet_end) of the frame received by i_stream.
+    uint32_t get_packet_begin(const int i_stream, const int n_streams);
+    uint32_t get_packet_end(const int i_stream, const int n_streams);
+
+    // Attach the steering program to the SO_REUSEPORT group of socket_fd.
+    // The group sockets must be bound in stream order.
+    void attach_reuseport_steering(const int socket_fd, const int n_streams);
+}
+
+#endif //SF_DAQ_BUFFER_JFJPACKETSTEERING_HPP
@@ -0,0 +1,62 @@
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <linux/filter.h>
+#include "JfjPacketSteering.hpp"
+#include "jungfraujoch.hpp"
+
+using namespace std;
+
+int JfjPacketSteering::get_stream(const int module_id, const int n_streams)
+{
+    return (module_id * n_streams) / JFJOCH_N_MODULES;
+}
+
+uint32_t JfjPacketSteering::get_packet_begin(
+        const int i_stream, const int n_streams)
+{
+    // First module with get_stream(module_id) == i_stream.
+    const int module_id =
+            ((i_stream * JFJOCH_N_MODULES) + n_streams - 1) / n_streams;
+
+    return module_id * JFJOCH_N_PACKETS_PER_MODULE;
+}
+
+uint32_t JfjPacketSteering::get_packet_end(
+        const int i_stream, const int n_streams)
+{
+    return get_packet_begin(i_stream + 1, n_streams);
+}
+
+void JfjPacketSteering::attach_reuseport_steering(
+        const int socket_fd, const int n_streams)
+{
+    // The program sees the UDP payload and returns the socket index in the
+    // group. packetnum is little endian, a frame has less than 2^16 packets.
+    const uint32_t packetnum_offset = offsetof(jfjoch_packet_t, packetnum);
+
+    sock_filter code[] = {
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, packetnum_offset + 1),
+        BPF_STMT(BPF_ALU | BPF_LSH | BPF_K, 8),
+        BPF_STMT(BPF_MISC | BPF_TAX, 0),
+        BPF_STMT(BPF_LD | BPF_B | BPF_ABS, packetnum_offset),
+        BPF_STMT(BPF_ALU | BPF_OR | BPF_X, 0),
+        // module_id * n_streams / N_MODULES
+        BPF_STMT(BPF_ALU | BPF_DIV | BPF_K, JFJOCH_N_PACKETS_PER_MODULE),
+        BPF_STMT(BPF_ALU | BPF_MUL | BPF_K, (uint32_t) n_streams),
+        BPF_STMT(BPF_ALU | BPF_DIV | BPF_K, JFJOCH_N_MODULES),
+        BPF_STMT(BPF_RET | BPF_A, 0)
+    };
+
+    sock_fprog program = {};
+    program.len = sizeof(code) / sizeof(code[0]);
+    program.filter = code;
+
+    if (setsockopt(socket_fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF,
+                   &program, sizeof(program)) == -1) {
+        throw runtime_error("Cannot set SO_ATTACH_REUSEPORT_CBPF. " +
+                            string(strerror(errno)));
+    }
+}
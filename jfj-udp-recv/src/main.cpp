@@ -1,66 +1,273 @@
 #include <iostream>
 #include <stdexcept>
+#include <memory>
+#include <thread>
+#include <vector>
 #include <zmq.h>
 #include <RamBuffer.hpp>
 
 #include "formats.hpp"
 #include "buffer_config.hpp"
-#include "JfjFrameUdpReceiver.hpp"
+#include "PacketUdpReceiver.hpp"
+#include "PacketFrameEngine.hpp"
+#include "PacketBuffer.hpp"
+#include "FrameCompletion.hpp"
 #include "BufferUtils.hpp"
-#include "JfjFrameStats.hpp"
+#include "EventStream.hpp"
+#include "FrameStats.hpp"
+#include "JfjPacketSteering.hpp"
 
 using namespace std;
 using namespace chrono;
 using namespace buffer_config;
 using namespace BufferUtils;
 
-int main (int argc, char *argv[]) {
+typedef PacketBufferRing<jfjoch_packet_t,
+                         BUFFER_UDP_N_RECV_MSG,
+                         BUFFER_JFJ_N_PACKET_BATCHES> BatchRing;
 
-    if (argc != 3) {
-        cout << endl;
-        cout << "Usage: jfj_udp_recv [detector_json_filename]" << endl;
-        cout << "\tdetector_json_filename: detector config file path." << endl;
-        cout << endl;
+// Completed frame with the received packets of all modules.
+struct JfjFrame {
+    ModuleFrame meta;
+    uint64_t packets_bitmap[PacketBitmap::n_words(JFJOCH_N_PACKETS_PER_FRAME)];
+};
+typedef SpscRing<JfjFrame, BUFFER_JFJ_N_FRAMES> FrameRing;
 
-        exit(-1);
+// One UDP stream: a socket and the assembly of its block of modules.
+struct JfjStream {
+    const int i_stream;
+    PacketUdpReceiver receiver;
+    unique_ptr<BatchRing> batches = make_unique<BatchRing>();
+    // Frames completed by the last part of this stream.
+    unique_ptr<FrameRing> frames = make_unique<FrameRing>();
+
+    explicit JfjStream(const int i_stream) : i_stream(i_stream) {}
+};
+
+// Stage cores are taken in order from udp_recv_cores: socket and assembly
+// of each stream, then publish.
+void setup_stage_thread(const DetectorConfig& config, const size_t i_stage)
+{
+    if (i_stage < config.udp_recv_cores.size()) {
+        pin_thread_to_core(config.udp_recv_cores[i_stage]);
     }
 
-    const auto config = read_json_config(string(argv[1]));
+    if (config.udp_recv_rt_priority > 0) {
+        set_thread_rt_priority(config.udp_recv_rt_priority);
+    }
+}
 
-    const auto udp_port = config.start_udp_port;
-    JfjFrameUdpReceiver receiver(udp_port);
-    RamBuffer buffer(config.detector_name, config.n_modules);
-    FrameStats stats(config.detector_name, 0, STATS_TIME);
+// Socket stage: fill pre-allocated packet batches.
+void receive_batches(JfjStream& stream, const DetectorConfig& config)
+{
+    setup_stage_thread(config, 2 * stream.i_stream);
 
-    auto ctx = zmq_ctx_new();
-    zmq_ctx_set(ctx, ZMQ_IO_THREADS, ZMQ_IO_THREADS);
-    auto sender = BufferUtils::bind_socket(ctx, config.detector_name, "jungfraujoch");
+    while (true) {
+        auto& batch = stream.batches->wait_write();
 
-    // Might be better creating a structure for double buffering
-    ModuleFrame frameMeta;
-    ImageMetadata imageMeta;
-    char* dataBuffer = new char[JFJOCH_DATA_BYTES_PER_FRAME];
+        if (batch.fill_from(stream.receiver) == 0) {
+            continue;
+        }
+
+        stream.batches->commit_write();
+    }
+}
+
+// Assembly stage: copy the packets of the stream modules straight into the
+// RamBuffer image slot. The last stream to close its part of a frame passes
+// the frame on.
+void assemble_frames(JfjStream& stream,
+                     FrameCompletion& completion,
+                     const RamBuffer& buffer,
+                     const DetectorConfig& config)
+{
+    setup_stage_thread(config, (2 * stream.i_stream) + 1);
+
+    const auto n_streams = completion.get_n_parts();
+    auto engine = make_unique<JfjochFrameEngine>(
+            0,
+            JfjPacketSteering::get_packet_begin(stream.i_stream, n_streams),
+            JfjPacketSteering::get_packet_end(stream.i_stream, n_streams));
+
+    ModuleFrame part;
+    JfjFrame frame;
+    uint64_t last_frame_index = 0;
+    uint64_t last_pulse_id = 0;
+
+    // Parts with a pulse_id or frame_index that cannot follow the last part
+    // of the stream are assembled here, not over a committed image.
+    auto scratch_frame =
+            make_unique<char[]>(JfjochFrameEngine::FRAME_N_BYTES);
+    bool is_part_in_buffer = false;
+
+    // The JFJ frame is the whole RamBuffer image.
+    auto get_frame_buffer = [&](const ModuleFrame& meta) {
+        is_part_in_buffer =
+                meta.frame_index > last_frame_index &&
+                meta.pulse_id > last_pulse_id &&
+                meta.pulse_id - last_pulse_id <= BUFFER_UDP_MAX_PULSE_ID_STEP;
+
+        if (!is_part_in_buffer) {
+            return scratch_frame.get();
+        }
 
+        // Committed or aborted by the publish stage.
+        buffer.begin_image_write(meta.pulse_id);
+        return buffer.get_image_slot(meta.pulse_id);
+    };
+
+    const uint64_t n_slots = completion.get_n_slots();
+
+    auto push_frame = [&stream, &frame]() {
+        stream.frames->wait_write() = frame;
+        stream.frames->commit_write();
+    };
+
+    // Frames without packets on this stream still need its part.
+    auto add_empty_parts = [&](const uint64_t stop_frame_index) {
+        // frame_index restarted.
+        if (stop_frame_index + n_slots < last_frame_index) {
+            last_frame_index = 0;
+        }
+
+        // Older frames are gone from the RamBuffer anyway.
+        auto frame_index = last_frame_index + 1;
+        if (stop_frame_index > frame_index + n_slots) {
+            frame_index = stop_frame_index - n_slots;
+        }
+
+        for (; frame_index < stop_frame_index; frame_index++) {
+            if (completion.add_empty_part(
+                    stream.i_stream, frame_index,
+                    frame.meta, frame.packets_bitmap)) {
+                push_frame();
+            }
+
+            last_frame_index = frame_index;
+        }
+    };
+
+    auto add_part = [&]() {
+        add_empty_parts(part.frame_index);
+
+        // The part was already added empty by a flush.
+        const bool is_flushed = part.frame_index <= last_frame_index;
+
+        // A bad part is added empty, so the parts of the other streams in
+        // the image slot are still published.
+        bool is_complete = false;
+        if (!is_flushed && is_part_in_buffer) {
+            is_complete = completion.add_part(
+                    stream.i_stream, part, engine->get_frame_bitmap(),
+                    frame.meta, frame.packets_bitmap);
+        } else if (!is_flushed) {
+            is_complete = completion.add_empty_part(
+                    stream.i_stream, part.frame_index,
+                    frame.meta, frame.packets_bitmap);
+        }
+
+        if (is_complete) {
+            push_frame();
+        }
+
+        last_frame_index = max(last_frame_index, part.frame_index);
+        last_pulse_id = part.pulse_id;
+    };
+
+    auto last_batch_time = steady_clock::now();
+
+    while (true) {
+        auto batch = stream.batches->acquire_read();
+
+        // No packets on this stream: pass on its open part, and add empty
+        // parts so the frames of the other streams still complete.
+        if (batch == nullptr) {
+            const auto now = steady_clock::now();
+
+            if (now - last_batch_time > milliseconds(BUFFER_JFJ_FLUSH_MS)) {
+                if (engine->flush_frame(part) != 0) {
+                    add_part();
+                }
+
+                add_empty_parts(completion.get_newest_frame_index() + 1);
+                last_batch_time = now;
+            }
+
+            this_thread::yield();
+            continue;
+        }
+
+        last_batch_time = steady_clock::now();
+
+        while (engine->add_packets(*batch, part, get_frame_buffer) != 0) {
+            add_part();
+        }
+
+        stream.batches->release_read();
+    }
+}
+
+// Oldest completed frame over all streams, nullptr if there is none.
+FrameRing* get_next_frames(vector<unique_ptr<JfjStream>>& streams)
+{
+    FrameRing* next_frames = nullptr;
+    uint64_t next_frame_index = 0;
+
+    for (auto& stream : streams) {
+        auto frame = stream->frames->acquire_read();
+
+        if (frame != nullptr && (next_frames == nullptr ||
+                                 frame->meta.frame_index < next_frame_index)) {
+            next_frames = stream->frames.get();
+            next_frame_index = frame->meta.frame_index;
+        }
+    }
+
+    return next_frames;
+}
+
+// Publish stage: commit the frame metadata and notify over ZMQ.
+void publish_frames(vector<unique_ptr<JfjStream>>& streams,
+                    const RamBuffer& buffer,
+                    EventSender& sender,
+                    FrameStats& stats,
+                    const DetectorConfig& config)
+{
+    setup_stage_thread(config, 2 * streams.size());
+
+    ImageMetadata imageMeta;
     uint64_t pulse_id_previous = 0;
     uint64_t frame_index_previous = 0;
 
-
     while (true) {
-        // NOTE: Needs to be pipelined for really high frame rates
-        auto pulse_id = receiver.get_frame_from_udp(frameMeta, dataBuffer);
+        auto frames = get_next_frames(streams);
+        if (frames == nullptr) {
+            this_thread::yield();
+            continue;
+        }
+
+        auto frame = frames->acquire_read();
+        auto& frameMeta = frame->meta;
+        const auto pulse_id = frameMeta.pulse_id;
 
         bool bad_pulse_id = false;
 
-        if ( ( frameMeta.frame_index != (frame_index_previous+1) ) || ( (pulse_id-pulse_id_previous) < 0 ) || ( (pulse_id-pulse_id_previous) > 1000 ) ) {
+        if ( ( frameMeta.frame_index != (frame_index_previous+1) ) ||
+             ( pulse_id <= pulse_id_previous ) ||
+             ( (pulse_id-pulse_id_previous) >
+               BUFFER_UDP_MAX_PULSE_ID_STEP ) ) {
+
             bad_pulse_id = true;
+            buffer.abort_image_write(pulse_id);
         } else {
             imageMeta.pulse_id = frameMeta.pulse_id;
             imageMeta.frame_index = frameMeta.frame_index;
             imageMeta.daq_rec = frameMeta.daq_rec;
-            imageMeta.is_good_image = true;            
-            
-            buffer.write_frame(frameMeta, dataBuffer);            
-            zmq_send(sender, &imageMeta, sizeof(imageMeta), 0);
+            imageMeta.is_good_image =
+                    frameMeta.n_recv_packets == JFJOCH_N_PACKETS_PER_FRAME;
+
+            buffer.commit_image(frameMeta, frame->packets_bitmap);
+            sender.send(&imageMeta);
         }
 
         stats.record_stats(frameMeta, bad_pulse_id);
@@ -68,7 +275,85 @@ int main (int argc, char *argv[]) {
         pulse_id_previous = pulse_id;
         frame_index_previous = frameMeta.frame_index;
 
+        frames->release_read();
     }
+}
+
+int main (int argc, char *argv[]) {
+
+    if (argc != 3) {
+        cout << endl;
+        cout << "Usage: jfj_udp_recv [detector_json_filename]" << endl;
+        cout << "\tdetector_json_filename: detector config file path." << endl;
+        cout << endl;
 
-    delete[] dataBuffer;
+        exit(-1);
+    }
+
+    const auto config = read_json_config(string(argv[1]));
+
+    // One RamBuffer image holds one JFJ frame.
+    if (config.n_modules != JFJOCH_N_MODULES) {
+        throw runtime_error("Detector n_modules must match a JFJ frame.");
+    }
+
+    const int n_streams = config.udp_recv_n_streams;
+    if (n_streams < 1 || n_streams > JFJOCH_N_MODULES) {
+        throw runtime_error("Invalid udp_recv_n_streams.");
+    }
+
+    // Streams of a SO_REUSEPORT group are bound in steering order.
+    vector<unique_ptr<JfjStream>> streams;
+    for (int i_stream = 0; i_stream < n_streams; i_stream++) {
+        streams.push_back(make_unique<JfjStream>(i_stream));
+
+        const auto port = config.udp_recv_reuseport ?
+                config.start_udp_port : config.start_udp_port + i_stream;
+        auto& receiver = streams.back()->receiver;
+
+        receiver.bind(port, config.udp_recv_backend, config.udp_recv_interface,
+                      config.udp_recv_busy_poll_us, config.udp_recv_reuseport);
+
+        if (config.udp_recv_reuseport && i_stream == 0) {
+            JfjPacketSteering::attach_reuseport_steering(
+                    receiver.get_fd(), n_streams);
+        }
+    }
+
+    RamBuffer buffer(config.detector_name, config.n_modules,
+                     config.ram_buffer.n_slots, config.ram_buffer);
+    vector<uint32_t> stream_packets;
+    for (int i_stream = 0; i_stream <= n_streams; i_stream++) {
+        stream_packets.push_back(
+                JfjPacketSteering::get_packet_begin(i_stream, n_streams));
+    }
+    FrameCompletion completion(stream_packets, buffer.get_n_slots());
+
+    auto ctx = zmq_ctx_new();
+    zmq_ctx_set(ctx, ZMQ_IO_THREADS, ZMQ_IO_THREADS);
+    EventSender sender(ctx, config.detector_name, "jungfraujoch",
+                       sizeof(ImageMetadata), config.event_transport);
+    FrameStats stats(config.detector_name, 0, JFJOCH_N_PACKETS_PER_FRAME,
+                     STATS_TIME, sender);
+
+    // Socket -> assembly for each stream -> publish, each stage on its own
+    // thread. After the ZMQ IO threads are started, so they do not inherit
+    // the pinning.
+    vector<thread> stages;
+    stages.emplace_back(publish_frames, ref(streams), cref(buffer),
+                        ref(sender), ref(stats), cref(config));
+
+    for (auto& stream : streams) {
+        stages.emplace_back(assemble_frames, ref(*stream), ref(completion),
+                            cref(buffer), cref(config));
+        stages.emplace_back(receive_batches, ref(*stream), cref(config));
+    }
+
+    if (config.udp_recv_mlockall) {
+        BufferUtils::lock_process_memory();
+    }
+
+    for (auto& stage : stages) {
+        stage.join();
+    }
 }
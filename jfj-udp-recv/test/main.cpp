@@ -1,6 +1,7 @@
 #include "gtest/gtest.h"
 #include "test_PacketUdpReceiver.cpp"
 #include "test_FrameUdpReceiver.cpp"
+#include "test_PacketSteering.cpp"
 
 using namespace std;
 
@@ -10,6 +10,9 @@
 
 using namespace std;
 
+// Lost packets fail the test instead of blocking it.
+const int RECV_TIMEOUT_MS = 1000;
+
 TEST(BufferUdpReceiver, simple_recv)
 {
     int n_packets = JFJOCH_N_PACKETS_PER_FRAME;
@@ -22,6 +25,8 @@ TEST(BufferUdpReceiver, simple_recv)
 
     JfjFrameUdpReceiver udp_receiver(udp_port);
 
+    // Received while they are sent: the frames do not fit in the socket
+    // buffer.
     auto handle = async(launch::async, [&](){
         for (int64_t i_frame=0; i_frame < n_frames; i_frame++){
             for (size_t i_packet=0; i_packet<n_packets; i_packet++) {
@@ -38,18 +43,21 @@ TEST(BufferUdpReceiver, simple_recv)
                         0,
                         (sockaddr*) &server_address,
                         sizeof(server_address));
+
+                // Do not outrun the receiver, it copies every packet.
+                if (i_packet % 64 == 63) {
+                    this_thread::sleep_for(chrono::microseconds(100));
+                }
             }
         }
     });
 
-    handle.wait();
-
     ModuleFrame metadata;
     auto frame_buffer = make_unique<char[]>(JFJOCH_DATA_BYTES_PER_FRAME);
 
     for (int i_frame=0; i_frame < n_frames; i_frame++) {
         auto pulse_id = udp_receiver.get_frame_from_udp(
-                metadata, frame_buffer.get());
+                metadata, frame_buffer.get(), RECV_TIMEOUT_MS);
 
         ASSERT_EQ(i_frame + 1, pulse_id);
         ASSERT_EQ(metadata.frame_index, i_frame + 1000);
@@ -58,6 +66,7 @@ TEST(BufferUdpReceiver, simple_recv)
         ASSERT_EQ(metadata.n_recv_packets, n_packets);
     }
 
+    handle.wait();
     ::close(send_socket_fd);
 }
 
@@ -73,6 +82,8 @@ TEST(BufferUdpReceiver, missing_middle_packet)
 
     JfjFrameUdpReceiver udp_receiver(udp_port);
 
+    // Received while they are sent: the frames do not fit in the socket
+    // buffer.
     auto handle = async(launch::async, [&](){
         for (int64_t i_frame=0; i_frame < n_frames; i_frame++){
             for (size_t i_packet=0; i_packet<n_packets; i_packet++) {
@@ -94,18 +105,21 @@ TEST(BufferUdpReceiver, missing_middle_packet)
                         0,
                         (sockaddr*) &server_address,
                         sizeof(server_address));
+
+                // Do not outrun the receiver, it copies every packet.
+                if (i_packet % 64 == 63) {
+                    this_thread::sleep_for(chrono::microseconds(100));
+                }
             }
         }
     });
 
-    handle.wait();
-
     ModuleFrame metadata;
     auto frame_buffer = make_unique<char[]>(JFJOCH_DATA_BYTES_PER_FRAME);
 
     for (int i_frame=0; i_frame < n_frames; i_frame++) {
         auto pulse_id = udp_receiver.get_frame_from_udp(
-                metadata, frame_buffer.get());
+                metadata, frame_buffer.get(), RECV_TIMEOUT_MS);
 
         ASSERT_EQ(i_frame + 1, pulse_id);
         ASSERT_EQ(metadata.frame_index, i_frame + 1000);
@@ -114,6 +128,7 @@ TEST(BufferUdpReceiver, missing_middle_packet)
         ASSERT_EQ(metadata.n_recv_packets, n_packets - 1);
     }
 
+    handle.wait();
     ::close(send_socket_fd);
 }
 
@@ -129,6 +144,8 @@ TEST(BufferUdpReceiver, missing_first_packet)
 
     JfjFrameUdpReceiver udp_receiver(udp_port);
 
+    // Received while they are sent: the frames do not fit in the socket
+    // buffer.
     auto handle = async(launch::async, [&](){
         for (int64_t i_frame=0; i_frame < n_frames; i_frame++){
             for (size_t i_packet=0; i_packet<n_packets; i_packet++) {
@@ -150,18 +167,21 @@ TEST(BufferUdpReceiver, missing_first_packet)
                         0,
                         (sockaddr*) &server_address,
                         sizeof(server_address));
+
+                // Do not outrun the receiver, it copies every packet.
+                if (i_packet % 64 == 63) {
+                    this_thread::sleep_for(chrono::microseconds(100));
+                }
             }
         }
     });
 
-    handle.wait();
-
     ModuleFrame metadata;
     auto frame_buffer = make_unique<char[]>(JFJOCH_DATA_BYTES_PER_FRAME);
 
     for (int i_frame=0; i_frame < n_frames; i_frame++) {
         auto pulse_id = udp_receiver.get_frame_from_udp(
-                metadata, frame_buffer.get());
+                metadata, frame_buffer.get(), RECV_TIMEOUT_MS);
 
         ASSERT_EQ(i_frame + 1, pulse_id);
         ASSERT_EQ(metadata.frame_index, i_frame + 1000);
@@ -170,6 +190,7 @@ TEST(BufferUdpReceiver, missing_first_packet)
         ASSERT_EQ(metadata.n_recv_packets, n_packets - 1);
     }
 
+    handle.wait();
     ::close(send_socket_fd);
 }
 
@@ -185,6 +206,8 @@ TEST(BufferUdpReceiver, missing_last_packet)
 
     JfjFrameUdpReceiver udp_receiver(udp_port);
 
+    // Received while they are sent: the frames do not fit in the socket
+    // buffer.
     auto handle = async(launch::async, [&](){
         for (int64_t i_frame=0; i_frame < n_frames; i_frame++){
             for (size_t i_packet=0; i_packet<n_packets; i_packet++) {
@@ -206,18 +229,22 @@ TEST(BufferUdpReceiver, missing_last_packet)
                         0,
                         (sockaddr*) &server_address,
                         sizeof(server_address));
+
+                // Do not outrun the receiver, it copies every packet.
+                if (i_packet % 64 == 63) {
+                    this_thread::sleep_for(chrono::microseconds(100));
+                }
             }
         }
     });
 
-    handle.wait();
-
     ModuleFrame metadata;
     auto frame_buffer = make_unique<char[]>(JFJOCH_DATA_BYTES_PER_FRAME);
 
     // n_frames -1 because the last frame is not complete.
     for (int i_frame=0; i_frame < n_frames - 1; i_frame++) {
-        auto pulse_id = udp_receiver.get_frame_from_udp(metadata, frame_buffer.get());
+        auto pulse_id = udp_receiver.get_frame_from_udp(
+                metadata, frame_buffer.get(), RECV_TIMEOUT_MS);
 
         ASSERT_EQ(i_frame + 1, pulse_id);
         ASSERT_EQ(metadata.frame_index, i_frame + 1000);
@@ -226,5 +253,6 @@ TEST(BufferUdpReceiver, missing_last_packet)
         ASSERT_EQ(metadata.n_recv_packets, n_packets - 1);
     }
 
+    handle.wait();
     ::close(send_socket_fd);
 }
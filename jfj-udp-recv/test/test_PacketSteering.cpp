@@ -0,0 +1,91 @@
+#include <netinet/in.h>
+#include <jungfraujoch.hpp>
+#include "gtest/gtest.h"
+#include "mock/udp.hpp"
+#include "PacketUdpReceiver.hpp"
+#include "JfjPacketSteering.hpp"
+
+#include <thread>
+#include <chrono>
+
+using namespace std;
+
+TEST(JfjPacketSteering, module_blocks)
+{
+    const int n_streams = 3;
+
+    // Modules 0-10, 11-21, 22-31.
+    ASSERT_EQ(JfjPacketSteering::get_packet_begin(0, n_streams), 0);
+    ASSERT_EQ(JfjPacketSteering::get_packet_begin(1, n_streams), 11 * 128);
+    ASSERT_EQ(JfjPacketSteering::get_packet_begin(2, n_streams), 22 * 128);
+    ASSERT_EQ(JfjPacketSteering::get_packet_end(2, n_streams),
+              JFJOCH_N_PACKETS_PER_FRAME);
+
+    for (int module_id = 0; module_id < JFJOCH_N_MODULES; module_id++) {
+        auto i_stream = JfjPacketSteering::get_stream(module_id, n_streams);
+        auto packetnum = module_id * JFJOCH_N_PACKETS_PER_MODULE;
+
+        ASSERT_GE(packetnum,
+                  JfjPacketSteering::get_packet_begin(i_stream, n_streams));
+        ASSERT_LT(packetnum,
+                  JfjPacketSteering::get_packet_end(i_stream, n_streams));
+    }
+}
+
+TEST(JfjPacketSteering, reuseport_steering)
+{
+    const int n_streams = 2;
+    uint16_t udp_port = MOCK_UDP_PORT;
+
+    PacketUdpReceiver udp_receivers[n_streams];
+    for (auto& udp_receiver : udp_receivers) {
+        udp_receiver.bind(udp_port, BufferUtils::UdpRecvBackend::RECVMMSG,
+                          "", 0, true);
+    }
+    JfjPacketSteering::attach_reuseport_steering(
+            udp_receivers[0].get_fd(), n_streams);
+
+    auto send_socket_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_TRUE(send_socket_fd >= 0);
+    auto server_address = get_server_address(udp_port);
+
+    auto send_udp_buffer = make_unique<jfjoch_packet_t>();
+
+    // First and last packet of each module.
+    for (int module_id = 0; module_id < JFJOCH_N_MODULES; module_id++) {
+        for (auto i_packet : {0, JFJOCH_N_PACKETS_PER_MODULE - 1}) {
+            send_udp_buffer->packetnum =
+                    (module_id * JFJOCH_N_PACKETS_PER_MODULE) + i_packet;
+
+            ::sendto(
+                    send_socket_fd,
+                    send_udp_buffer.get(),
+                    JFJOCH_BYTES_PER_PACKET,
+                    0,
+                    (sockaddr*) &server_address,
+                    sizeof(server_address));
+        }
+    }
+
+    this_thread::sleep_for(chrono::milliseconds(10));
+
+    auto recv_udp_buffer = make_unique<jfjoch_packet_t>();
+
+    for (int i_stream = 0; i_stream < n_streams; i_stream++) {
+        int n_packets = 0;
+
+        while (udp_receivers[i_stream].receive(
+                recv_udp_buffer.get(), JFJOCH_BYTES_PER_PACKET)) {
+
+            auto module_id =
+                    recv_udp_buffer->packetnum / JFJOCH_N_PACKETS_PER_MODULE;
+            ASSERT_EQ(JfjPacketSteering::get_stream(module_id, n_streams),
+                      i_stream);
+            n_packets++;
+        }
+
+        ASSERT_EQ(n_packets, JFJOCH_N_MODULES);
+    }
+
+    ::close(send_socket_fd);
+}
@@ -4,14 +4,18 @@
 #include <chrono>
 #include <string>
 #include <formats.hpp>
+#include <EventStream.hpp>
 
 class StreamStats {
     const std::string detector_name_;
     const std::string stream_name_;
     const size_t stats_modulo_;
+    const EventReceiver& receiver_;
+    uint64_t n_dropped_events_reported_ = 0;
 
     int image_counter_;
     int n_corrupted_images_;
+    int n_overwritten_images_;
     std::chrono::time_point<std::chrono::steady_clock> stats_interval_start_;
 
     void reset_counters();
@@ -20,9 +24,11 @@ class StreamStats {
 public:
     StreamStats(const std::string &detector_name,
                 const std::string &stream_name,
-                const size_t stats_modulo);
+                const size_t stats_modulo,
+                const EventReceiver& receiver);
 
-    void record_stats(const ImageMetadata &meta);
+    // is_overwritten: the image slot was overwritten while it was sent.
+    void record_stats(const ImageMetadata &meta, const bool is_overwritten);
 };
 
 
@@ -9,16 +9,24 @@
 class ZmqLiveSender {
     const void* ctx_;
     const BufferUtils::DetectorConfig config_;
+    const int image_y_size_;
+    const int image_x_size_;
 
     void* socket_streamvis_;
     void* socket_live_;
 
 public:
+    // Images of image_y_size x image_x_size uint16 pixels.
     ZmqLiveSender(void* ctx,
-                  const BufferUtils::DetectorConfig& config);
+                  const BufferUtils::DetectorConfig& config,
+                  const int image_y_size,
+                  const int image_x_size);
     ~ZmqLiveSender();
 
-    void send(const ImageMetadata& meta, const char* data);
+    // missing_modules: bit i set if module i is not of this pulse.
+    void send(const ImageMetadata& meta,
+              const char* data,
+              const uint64_t missing_modules=0);
 };
 
 
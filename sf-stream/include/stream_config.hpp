@@ -6,14 +6,12 @@ namespace stream_config
     const size_t STREAM_RCVHWM = 100;
     // Size of buffer between the receiving and sending part.
     const int STREAM_FASTQUEUE_SLOTS = 5;
-    // If the modules are offset more than 1000 pulses, crush.
-    const uint64_t PULSE_OFFSET_LIMIT = 100;
     // SNDHWM for live processing socket.
     const int PROCESSING_ZMQ_SNDHWM = 10;
     // Keep the last second of pulses in the buffer.
     const int PULSE_ZMQ_SNDHWM = 100;
-    // Number of times we try to re-sync in case of failure.
-    const int SYNC_RETRY_LIMIT = 3;
+    // Threads assembling images into the detector geometry.
+    const int STREAM_ASSEMBLY_THREADS = 4;
 
     // Number of pulses between each statistics print out.
     const size_t STREAM_STATS_MODULO = 1000;
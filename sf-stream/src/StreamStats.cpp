@@ -8,10 +8,12 @@ using namespace chrono;
 StreamStats::StreamStats(
         const std::string &detector_name,
         const std::string &stream_name,
-        const size_t stats_modulo) :
+        const size_t stats_modulo,
+        const EventReceiver& receiver) :
             detector_name_(detector_name),
             stream_name_(stream_name),
-            stats_modulo_(stats_modulo)
+            stats_modulo_(stats_modulo),
+            receiver_(receiver)
 {
     reset_counters();
 }
@@ -20,11 +22,12 @@ void StreamStats::reset_counters()
 {
     image_counter_ = 0;
     n_corrupted_images_ = 0;
+    n_overwritten_images_ = 0;
     stats_interval_start_ = steady_clock::now();
 }
 
 void StreamStats::record_stats(
-        const ImageMetadata &meta)
+        const ImageMetadata &meta, const bool is_overwritten)
 {
     image_counter_++;
 
@@ -32,6 +35,10 @@ void StreamStats::record_stats(
         n_corrupted_images_++;
     }
 
+    if (is_overwritten) {
+        n_overwritten_images_++;
+    }
+
     if (image_counter_ == stats_modulo_) {
         print_stats();
         reset_counters();
@@ -44,6 +51,7 @@ void StreamStats::print_stats()
             steady_clock::now()-stats_interval_start_).count();
     // * 1000 because milliseconds, + 250 because of truncation.
     int rep_rate = ((image_counter_ * 1000) + 250) / interval_ms_duration;
+    const auto n_dropped_events = receiver_.get_n_dropped();
     uint64_t timestamp = time_point_cast<nanoseconds>(
             system_clock::now()).time_since_epoch().count();
 
@@ -54,9 +62,14 @@ void StreamStats::print_stats()
     cout << " ";
     cout << "n_processed_images=" << image_counter_ << "i";
     cout << ",n_corrupted_images=" << n_corrupted_images_ << "i";
+    cout << ",n_overwritten_images=" << n_overwritten_images_ << "i";
+    cout << ",n_dropped_events=";
+    cout << n_dropped_events - n_dropped_events_reported_ << "i";
     cout << ",repetition_rate=" << rep_rate << "i";
     cout << " ";
     cout << timestamp;
     cout << endl;
+
+    n_dropped_events_reported_ = n_dropped_events;
 }
 
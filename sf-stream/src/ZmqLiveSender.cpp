@@ -14,9 +14,13 @@ using namespace stream_config;
 
 ZmqLiveSender::ZmqLiveSender(
         void* ctx,
-        const BufferUtils::DetectorConfig& config) :
+        const BufferUtils::DetectorConfig& config,
+        const int image_y_size,
+        const int image_x_size) :
             ctx_(ctx),
-            config_(config)
+            config_(config),
+            image_y_size_(image_y_size),
+            image_x_size_(image_x_size)
 {
     // TODO: Set also LINGER and SNDHWM.
     socket_streamvis_ = zmq_socket(ctx, ZMQ_PUB);
@@ -52,9 +56,14 @@ ZmqLiveSender::~ZmqLiveSender()
     zmq_close(socket_live_);
 }
 
-void ZmqLiveSender::send(const ImageMetadata& meta, const char *data)
+void ZmqLiveSender::send(
+        const ImageMetadata& meta,
+        const char *data,
+        const uint64_t missing_modules)
 {
     uint16_t data_empty [] = { 0, 0, 0, 0};
+    const size_t image_n_bytes = (size_t) image_y_size_ * image_x_size_ *
+                                 buffer_config::PIXEL_N_BYTES;
 
     rapidjson::Document header(rapidjson::kObjectType);
     auto& header_alloc = header.GetAllocator();
@@ -65,6 +74,7 @@ void ZmqLiveSender::send(const ImageMetadata& meta, const char *data)
     header.AddMember("is_good_frame", meta.is_good_image, header_alloc);
     header.AddMember("daq_rec", meta.daq_rec, header_alloc);
     header.AddMember("pulse_id", meta.pulse_id, header_alloc);
+    header.AddMember("missing_modules", missing_modules, header_alloc);
 
     rapidjson::Value pedestal_file;
     pedestal_file.SetString(config_.PEDE_FILENAME.c_str(), header_alloc);
@@ -93,8 +103,8 @@ void ZmqLiveSender::send(const ImageMetadata& meta, const char *data)
     }
     if ( send_streamvis == 0 ) {
         auto& shape = header["shape"];
-        shape[0] = config_.n_modules*512;
-        shape[1] = 1024;
+        shape[0] = image_y_size_;
+        shape[1] = image_x_size_;
     } else{
         auto& shape = header["shape"];
         shape[0] = 2;
@@ -117,7 +127,7 @@ void ZmqLiveSender::send(const ImageMetadata& meta, const char *data)
     if ( send_streamvis == 0 ) {
         zmq_send(socket_streamvis_,
                  (char*)data,
-                 buffer_config::MODULE_N_BYTES * config_.n_modules,
+                 image_n_bytes,
                  0);
     } else {
         zmq_send(socket_streamvis_,
@@ -133,8 +143,8 @@ void ZmqLiveSender::send(const ImageMetadata& meta, const char *data)
     }
     if ( send_live_analysis == 0 ) {
         auto& shape = header["shape"];
-        shape[0] = config_.n_modules*512;
-        shape[1] = 1024;
+        shape[0] = image_y_size_;
+        shape[1] = image_x_size_;
     } else{
         auto& shape = header["shape"];
         shape[0] = 2;
@@ -158,7 +168,7 @@ void ZmqLiveSender::send(const ImageMetadata& meta, const char *data)
         if ( send_live_analysis == 0 ) {
             zmq_send(socket_live_,
                      (char*)data,
-                     buffer_config::MODULE_N_BYTES * config_.n_modules,
+                     image_n_bytes,
                      ZMQ_NOBLOCK);
         } else {
             zmq_send(socket_live_,
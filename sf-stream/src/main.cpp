@@ -1,9 +1,14 @@
 #include <iostream>
+#include <memory>
 #include <string>
+#include <vector>
 #include <zmq.h>
 #include <RamBuffer.hpp>
+#include <GeometryAssembler.hpp>
+#include <PulseTracer.hpp>
 #include <BufferUtils.hpp>
 #include <StreamStats.hpp>
+#include <EventStream.hpp>
 
 #include "stream_config.hpp"
 #include "ZmqLiveSender.hpp"
@@ -30,20 +35,68 @@ int main (int argc, char *argv[])
 
     auto ctx = zmq_ctx_new();
     zmq_ctx_set(ctx, ZMQ_IO_THREADS, STREAM_ZMQ_IO_THREADS);
-    auto receiver = BufferUtils::connect_socket(
-            ctx, config.detector_name, "assembler");
+    EventReceiver receiver(ctx, config.detector_name, "assembler",
+                           sizeof(ImageMetadata), config.event_transport);
 
-    RamBuffer ram_buffer(config.detector_name, config.n_modules);
-    StreamStats stats(config.detector_name, stream_name, STREAM_STATS_MODULO);
-    ZmqLiveSender sender(ctx, config);
+    RamBuffer ram_buffer(config.detector_name, config.n_modules,
+                         config.ram_buffer.n_slots, config.ram_buffer);
+    StreamStats stats(config.detector_name, stream_name, STREAM_STATS_MODULO,
+                      receiver);
+    PulseTracer tracer(config.detector_name, config.latency_trace,
+                       config.ram_buffer.n_slots);
+
+    // Stacked modules are sent straight from the RamBuffer.
+    const auto& geometry = config.geometry;
+    unique_ptr<GeometryAssembler> assembler;
+    vector<uint16_t> image;
+    int image_y_size = config.n_modules * MODULE_Y_SIZE;
+    int image_x_size = MODULE_X_SIZE;
+
+    if (!geometry.modules.empty() || geometry.gap_pixels ||
+        geometry.double_pixels != BufferUtils::DoublePixels::KEEP) {
+        assembler = make_unique<GeometryAssembler>(
+                geometry, config.n_modules, STREAM_ASSEMBLY_THREADS);
+        image.resize(assembler->get_image_n_pixels());
+        image_y_size = assembler->get_image_y_size();
+        image_x_size = assembler->get_image_x_size();
+    }
+
+    ZmqLiveSender sender(ctx, config, image_y_size, image_x_size);
 
     ImageMetadata meta;
     while (true) {
-        zmq_recv(receiver, &meta, sizeof(meta), 0);
+        receiver.recv(&meta);
+        // Stored in the image slot by jf-assembler.
+        const auto missing_modules =
+                ram_buffer.get_missing_modules(meta.pulse_id);
+        const auto generation = ram_buffer.begin_read_image(meta.pulse_id);
         char* data = ram_buffer.read_image(meta.pulse_id);
 
-        sender.send(meta, data);
+        // Already overwritten, let the receivers know.
+        if (generation == RamBuffer::INVALID_GENERATION) {
+            meta.is_good_image = 0;
+        }
+
+        bool is_overwritten = false;
+        if (assembler) {
+            assembler->assemble(data, image.data());
+            data = (char*) image.data();
+
+            // The assembled copy is ours, validate it before sending.
+            is_overwritten =
+                    !ram_buffer.end_read_image(meta.pulse_id, generation);
+            if (is_overwritten) {
+                meta.is_good_image = 0;
+            }
+        }
+
+        sender.send(meta, data, missing_modules);
+        tracer.record_now(TraceStage::STREAM_SEND, meta.pulse_id);
 
-        stats.record_stats(meta);
+        if (!assembler) {
+            is_overwritten =
+                    !ram_buffer.end_read_image(meta.pulse_id, generation);
+        }
+        stats.record_stats(meta, is_overwritten);
     }
 }
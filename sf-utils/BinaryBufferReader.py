@@ -19,7 +19,8 @@ MODULE_Y_SIZE = 512
 BYTES_PER_PIXEL = 2
 MODULE_N_PIXELS = MODULE_X_SIZE * MODULE_Y_SIZE
 MODULE_N_BYTES = MODULE_N_PIXELS * BYTES_PER_PIXEL
-BUFFER_FORMAT_MARKER = b"\xBE"
+# 0xBE files were written without packets_bitmap.
+BUFFER_FORMAT_MARKER = b"\xBF"
 
 
 class BufferBinaryFormat(Structure):
@@ -31,10 +32,11 @@ class BufferBinaryFormat(Structure):
         ("daq_rec",        c_uint64),
         ("n_recv_packets", c_uint64),
         ("module_id",      c_uint64),
+        ("packets_bitmap", c_uint64 * 2),
         ("data",           c_byte * MODULE_N_BYTES)
     ]
 
-BUFFER_BINARY_NON_DATA = [n for n, _t in BufferBinaryFormat._fields_ if n != "data"]
+BUFFER_BINARY_NON_DATA = [n for n, _t in BufferBinaryFormat._fields_ if n not in ("data", "packets_bitmap")]
 
 BUFFER_BINARY_SIZE = sizeof(BufferBinaryFormat)
 
@@ -94,7 +96,8 @@ class BinaryBufferReader:
 
             if not is_good_frame:
                 n_lost_packets = 128 - frame_buffer.n_recv_packets
-                _logger.warning(f"{output_prefix} n_lost_packets: {n_lost_packets}")
+                lost_packets = get_missing_packets(frame_buffer.packets_bitmap)
+                _logger.warning(f"{output_prefix} n_lost_packets: {n_lost_packets} lost_packets: {lost_packets}")
                 metadata["is_good_frame"] = False
                 continue
 
@@ -124,6 +127,10 @@ class BinaryBufferReader:
 
 
 
+def get_missing_packets(packets_bitmap):
+    # Each packet holds 4 rows of the module.
+    return [i for i in range(128) if not (packets_bitmap[i // 64] >> (i % 64)) & 1]
+
 def get_file_frame_index(pulse_id):
     file_base = int((pulse_id // FILE_MOD) * FILE_MOD)
     return pulse_id - file_base
@@ -0,0 +1,125 @@
+#!/usr/bin/env python
+
+from argparse import ArgumentParser
+from ctypes import c_uint64, sizeof, Structure
+
+import numpy
+
+
+JUNGFRAU_N_MODULES = 32
+PULSE_TRACE_SHM_SUFFIX = "-trace"
+PERCENTILES = [50, 90, 99, 99.9]
+
+
+class TracePoint(Structure):
+    _pack_ = 1
+    _fields_ = [
+        ("pulse_id", c_uint64),
+        ("time_ns",  c_uint64)
+    ]
+
+class PulseTrace(Structure):
+    _pack_ = 1
+    _fields_ = [
+        ("module_recv",    TracePoint * JUNGFRAU_N_MODULES),
+        ("module_commit",  TracePoint * JUNGFRAU_N_MODULES),
+        ("assembler_emit", TracePoint),
+        ("stream_send",    TracePoint),
+        ("writer_write",   TracePoint)
+    ]
+
+PULSE_TRACE_SIZE = sizeof(PulseTrace)
+
+
+
+def read_traces(detector_name):
+    filename = f"/dev/shm/{detector_name}{PULSE_TRACE_SHM_SUFFIX}"
+
+    with open(filename, "rb") as input_file:
+        input_data = input_file.read()
+
+    n_slots = len(input_data) // PULSE_TRACE_SIZE
+    return [PulseTrace.from_buffer_copy(input_data, i_slot * PULSE_TRACE_SIZE) for i_slot in range(n_slots)]
+
+
+def get_point(point, pulse_id):
+    # Slots are reused - only points written for this pulse count.
+    if point.pulse_id != pulse_id or point.time_ns == 0:
+        return None
+    return point.time_ns
+
+
+def get_stage_latencies(traces, n_modules):
+    stages = {
+        "recv_to_commit":    [],
+        "commit_to_emit":    [],
+        "emit_to_stream":    [],
+        "emit_to_write":     [],
+        "recv_to_emit":      []
+    }
+
+    for trace in traces:
+        pulse_id = trace.assembler_emit.pulse_id
+        emit = get_point(trace.assembler_emit, pulse_id)
+        if emit is None:
+            continue
+
+        recvs = [get_point(trace.module_recv[i], pulse_id) for i in range(n_modules)]
+        commits = [get_point(trace.module_commit[i], pulse_id) for i in range(n_modules)]
+
+        for recv, commit in zip(recvs, commits):
+            if recv is not None and commit is not None:
+                stages["recv_to_commit"].append(commit - recv)
+
+        commits = [commit for commit in commits if commit is not None]
+        if commits:
+            stages["commit_to_emit"].append(emit - max(commits))
+
+        recvs = [recv for recv in recvs if recv is not None]
+        if recvs:
+            stages["recv_to_emit"].append(emit - min(recvs))
+
+        stream = get_point(trace.stream_send, pulse_id)
+        if stream is not None:
+            stages["emit_to_stream"].append(stream - emit)
+
+        write = get_point(trace.writer_write, pulse_id)
+        if write is not None:
+            stages["emit_to_write"].append(write - emit)
+
+    return stages
+
+
+def print_report(stages):
+    header = ["stage", "n_pulses"] + [f"p{p}" for p in PERCENTILES] + ["max"]
+    print(" ".join(f"{h:>14}" for h in header) + "  [us]")
+
+    for stage, latencies in stages.items():
+        if not latencies:
+            print(f"{stage:>14} {0:>14}")
+            continue
+
+        latencies_us = numpy.array(latencies, dtype="int64") / 1000
+        values = list(numpy.percentile(latencies_us, PERCENTILES)) + [latencies_us.max()]
+        print(f"{stage:>14} {len(latencies):>14} " + " ".join(f"{v:>14.1f}" for v in values))
+
+
+
+
+
+def main():
+    parser = ArgumentParser(description="Report per stage latency percentiles from the pulse trace")
+
+    parser.add_argument("detector_name", type=str, help="detector name from the detector config")
+    parser.add_argument("n_modules",     type=int, help="number of modules of the detector")
+
+    clargs = parser.parse_args()
+
+    traces = read_traces(clargs.detector_name)
+    stages = get_stage_latencies(traces, clargs.n_modules)
+    print_report(stages)
+
+
+
+if __name__ == "__main__":
+    main()